@@ -19,626 +19,1091 @@
 
 #include <string.h>
 #include <math.h>
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
 
 #include "quat.h"
-
-static const float ZERO_TOLERANCE = 0.000001f;
+#include "quat_packet.h"
 
 #ifndef FOR_N
 #define FOR_N(v, m) for (int v = 0; v < m; ++v)
 #endif /* FOR_N */
 
 
-void vec3_copy(vec3_t *vo, vec3_t *vi)
+/* single precision scalar functions: float math only */
+#define REAL float
+#define QUAT_T quat_t
+#define VEC3_T vec3_t
+#define EULER_T euler_t
+#define QFN(name) quat_##name
+#define VFN(name) vec3_##name
+#define QUAT_INIT quaternion_init
+#define NORMALIZE_EULER normalize_euler_0_2pi
+#define IDENTITY_QUAT identity_quat
+#define MATH(fn) fn##f
+#define LIT(x) x##f
+#if defined(QUAT_SLERP_FAST)
+#define SLERP_FAST quat_slerp_fast
+#endif
+#include "quat_tmpl.c"
+#include "quat_tmpl_undef.h"
+
+
+/* double precision scalar functions */
+#define REAL double
+#define QUAT_T quatd_t
+#define VEC3_T vec3d_t
+#define EULER_T eulerd_t
+#define QFN(name) quatd_##name
+#define VFN(name) vec3d_##name
+#define QUAT_INIT quaterniond_init
+#define NORMALIZE_EULER normalize_eulerd_0_2pi
+#define IDENTITY_QUAT identity_quatd
+#define MATH(fn) fn
+#define LIT(x) x
+#include "quat_tmpl.c"
+#include "quat_tmpl_undef.h"
+
+
+/* rotation coefficients of unit quaternion q as row major 3x3 matrix;
+   same terms as in quat_rot_vec, so evaluating each row as
+   diagonal term + (other terms) gives identical results */
+static void quat_rot_coeffs(float *m, const quat_t *q)
 {
-   memcpy(vo, vi, sizeof(vec3_t));   
+   const float qw = q->w, qx = q->x, qy = q->y, qz = q->z;
+   const float qww = qw * qw, qxx = qx * qx, qyy = qy * qy, qzz = qz * qz;
+   const float qwx = qw * qx, qwy = qw * qy, qwz = qw * qz, qxy = qx * qy;
+   const float qxz = qx * qz, qyz = qy * qz;
+   m[0] = qww + qxx - qyy - qzz;
+   m[1] = 2 * (qxy - qwz);
+   m[2] = 2 * (qxz + qwy);
+   m[3] = 2 * (qxy + qwz);
+   m[4] = qww - qxx + qyy - qzz;
+   m[5] = 2 * (qyz - qwx);
+   m[6] = 2 * (qxz - qwy);
+   m[7] = 2 * (qyz + qwx);
+   m[8] = qww - qxx - qyy + qzz;
 }
 
 
-void quat_init(quat_t *q, const vec3_t *acc, const vec3_t *mag)
+#if defined(__SSE__)
+
+/* rotates 4 packed vectors (12 floats in a, b and c) without transposing them:
+   every output lane is k_same * v_same + (k_other1 * v_other1 + k_other2 * v_other2),
+   which is the evaluation order of quat_rot_vec. The input registers already
+   hold the v_same components, the other two are gathered by shuffles. */
+#define ROT4_AOS(SHUF, MUL, ADD, a, b, c, k) \
+   do { \
+      __typeof__(a) u, o1, o2, ra, rb; \
+      u = SHUF(a, b, _MM_SHUFFLE(0, 0, 0, 1)); \
+      o1 = SHUF(u, u, _MM_SHUFFLE(2, 1, 1, 0)); \
+      u = SHUF(a, b, _MM_SHUFFLE(1, 1, 1, 2)); \
+      o2 = SHUF(u, u, _MM_SHUFFLE(2, 1, 0, 0)); \
+      ra = ADD(MUL(k[0], a), ADD(MUL(k[1], o1), MUL(k[2], o2))); \
+      o1 = SHUF(a, b, _MM_SHUFFLE(2, 3, 3, 3)); \
+      o2 = SHUF(b, c, _MM_SHUFFLE(0, 0, 0, 1)); \
+      rb = ADD(MUL(k[3], b), ADD(MUL(k[4], o1), MUL(k[5], o2))); \
+      u = SHUF(b, c, _MM_SHUFFLE(1, 2, 2, 2)); \
+      o1 = SHUF(u, u, _MM_SHUFFLE(3, 3, 2, 0)); \
+      u = SHUF(b, c, _MM_SHUFFLE(2, 3, 3, 3)); \
+      o2 = SHUF(u, u, _MM_SHUFFLE(3, 2, 2, 0)); \
+      c = ADD(MUL(k[6], c), ADD(MUL(k[7], o1), MUL(k[8], o2))); \
+      a = ra; \
+      b = rb; \
+   } while (0)
+
+
+static void rot4_coeffs(float *k, const float *m)
 {
-   float ax = acc->x;
-   float ay = acc->y;
-   float az = acc->z;
-   float mx = mag->x;
-   float my = mag->y;
-   float mz = mag->z;
-
-
-   float init_roll = atan2(-ay, -az);
-   float init_pitch = atan2(ax, -az);
-
-   float cos_roll = cosf(init_roll);
-   float sin_roll = sinf(init_roll);
-   float cos_pitch = cosf(init_pitch);
-   float sin_pitch = sinf(init_pitch);
-
-   float mag_x = mx * cos_pitch + my * sin_roll * sin_pitch + mz * cos_roll * sin_pitch;
-   float mag_y = my * cos_roll - mz * sin_roll;
-
-   float init_yaw = atan2(-mag_y, mag_x);
+   /* per register: same, first other and second other column of the lane's row */
+   static const int cols[3][3] = { { 0, 1, 2 }, { 1, 0, 2 }, { 2, 0, 1 } };
+   FOR_N(reg, 3)
+      FOR_N(lane, 4) {
+         int row = (reg * 4 + lane) % 3;
+         FOR_N(term, 3)
+            k[(reg * 3 + term) * 4 + lane] = m[row * 3 + cols[row][term]];
+      }
+}
 
-   cos_roll =  cosf(init_roll * 0.5f);
-   sin_roll =  sinf(init_roll * 0.5f);
+#endif /* __SSE__ */
 
-   cos_pitch = cosf(init_pitch * 0.5f );
-   sin_pitch = sinf(init_pitch * 0.5f );
 
-   float cosHeading = cosf(init_yaw * 0.5f);
-   float sinHeading = sinf(init_yaw * 0.5f);
+QUAT_API void quat_rot_vec_n(vec3_t *vo, const vec3_t *vi, const quat_t *q, size_t n)
+{
+   float m[9];
+   quat_rot_coeffs(m, q);
+   size_t i = 0;
+
+#if defined(__SSE__)
+   float kf[36];
+   rot4_coeffs(kf, m);
+   const float *fi = vi->vec;
+   float *fo = vo->vec;
+#if defined(__AVX__)
+   __m256 k8[9];
+   FOR_N(j, 9)
+      k8[j] = _mm256_broadcast_ps((const __m128 *)&kf[j * 4]);
+   for (; i < (n & ~(size_t)7); i += 8) {
+      /* two groups of 4 vectors, one per 128 bit lane */
+      const float *lo = fi + 3 * i, *hi = lo + 12;
+      __m256 a = _mm256_loadu2_m128(hi, lo);
+      __m256 b = _mm256_loadu2_m128(hi + 4, lo + 4);
+      __m256 c = _mm256_loadu2_m128(hi + 8, lo + 8);
+      ROT4_AOS(_mm256_shuffle_ps, _mm256_mul_ps, _mm256_add_ps, a, b, c, k8);
+      float *olo = fo + 3 * i, *ohi = olo + 12;
+      _mm256_storeu2_m128(ohi, olo, a);
+      _mm256_storeu2_m128(ohi + 4, olo + 4, b);
+      _mm256_storeu2_m128(ohi + 8, olo + 8, c);
+   }
+#endif /* __AVX__ */
+   __m128 k4[9];
+   FOR_N(j, 9)
+      k4[j] = _mm_loadu_ps(&kf[j * 4]);
+   for (; i < (n & ~(size_t)3); i += 4) {
+      const float *p = fi + 3 * i;
+      __m128 a = _mm_loadu_ps(p);
+      __m128 b = _mm_loadu_ps(p + 4);
+      __m128 c = _mm_loadu_ps(p + 8);
+      ROT4_AOS(_mm_shuffle_ps, _mm_mul_ps, _mm_add_ps, a, b, c, k4);
+      float *o = fo + 3 * i;
+      _mm_storeu_ps(o, a);
+      _mm_storeu_ps(o + 4, b);
+      _mm_storeu_ps(o + 8, c);
+   }
+#endif /* __SSE__ */
 
-   q->q0 = cos_roll * cos_pitch * cosHeading + sin_roll * sin_pitch * sinHeading;
-   q->q1 = sin_roll * cos_pitch * cosHeading - cos_roll * sin_pitch * sinHeading;
-   q->q2 = cos_roll * sin_pitch * cosHeading + sin_roll * cos_pitch * sinHeading;
-   q->q3 = cos_roll * cos_pitch * sinHeading - sin_roll * sin_pitch * cosHeading;
+   for (; i < n; i++) {
+      const float vx = vi[i].x, vy = vi[i].y, vz = vi[i].z;
+      vo[i].x = m[0] * vx + (m[1] * vy + m[2] * vz);
+      vo[i].y = m[4] * vy + (m[3] * vx + m[5] * vz);
+      vo[i].z = m[8] * vz + (m[6] * vx + m[7] * vy);
+   }
 }
 
 
-void quat_init_axis(quat_t *q, float x, float y, float z, float a)
+QUAT_API void quat_rot_vec_soa(float *xo, float *yo, float *zo,
+                               const float *xi, const float *yi, const float *zi,
+                               const quat_t *q, size_t n)
 {
-   /* see: http://www.euclideanspace.com/maths/geometry/rotations
-           /conversions/angleToQuaternion/index.htm */
-   float a2 = a * 0.5f;
-   float s = sin(a2);
-   q->x = x * s;   
-   q->y = y * s;   
-   q->z = z * s;   
-   q->w = cos(a2);   
-}
-
+   float m[9];
+   quat_rot_coeffs(m, q);
+   size_t i = 0;
+
+#if defined(__AVX__)
+   __m256 k8[9];
+   FOR_N(j, 9)
+      k8[j] = _mm256_set1_ps(m[j]);
+   for (; i < (n & ~(size_t)7); i += 8) {
+      __m256 x = _mm256_loadu_ps(xi + i);
+      __m256 y = _mm256_loadu_ps(yi + i);
+      __m256 z = _mm256_loadu_ps(zi + i);
+      _mm256_storeu_ps(xo + i, _mm256_add_ps(_mm256_mul_ps(k8[0], x),
+                       _mm256_add_ps(_mm256_mul_ps(k8[1], y), _mm256_mul_ps(k8[2], z))));
+      _mm256_storeu_ps(yo + i, _mm256_add_ps(_mm256_mul_ps(k8[4], y),
+                       _mm256_add_ps(_mm256_mul_ps(k8[3], x), _mm256_mul_ps(k8[5], z))));
+      _mm256_storeu_ps(zo + i, _mm256_add_ps(_mm256_mul_ps(k8[8], z),
+                       _mm256_add_ps(_mm256_mul_ps(k8[6], x), _mm256_mul_ps(k8[7], y))));
+   }
+#endif /* __AVX__ */
+#if defined(__SSE__)
+   __m128 k4[9];
+   FOR_N(j, 9)
+      k4[j] = _mm_set1_ps(m[j]);
+   for (; i < (n & ~(size_t)3); i += 4) {
+      __m128 x = _mm_loadu_ps(xi + i);
+      __m128 y = _mm_loadu_ps(yi + i);
+      __m128 z = _mm_loadu_ps(zi + i);
+      _mm_storeu_ps(xo + i, _mm_add_ps(_mm_mul_ps(k4[0], x),
+                    _mm_add_ps(_mm_mul_ps(k4[1], y), _mm_mul_ps(k4[2], z))));
+      _mm_storeu_ps(yo + i, _mm_add_ps(_mm_mul_ps(k4[4], y),
+                    _mm_add_ps(_mm_mul_ps(k4[3], x), _mm_mul_ps(k4[5], z))));
+      _mm_storeu_ps(zo + i, _mm_add_ps(_mm_mul_ps(k4[8], z),
+                    _mm_add_ps(_mm_mul_ps(k4[6], x), _mm_mul_ps(k4[7], y))));
+   }
+#endif /* __SSE__ */
 
-void quat_init_axis_v(quat_t *q, const vec3_t *v, float a)
-{
-   quat_init_axis(q, v->x, v->y, v->z, a);
+   for (; i < n; i++) {
+      const float vx = xi[i], vy = yi[i], vz = zi[i];
+      xo[i] = m[0] * vx + (m[1] * vy + m[2] * vz);
+      yo[i] = m[4] * vy + (m[3] * vx + m[5] * vz);
+      zo[i] = m[8] * vz + (m[6] * vx + m[7] * vy);
+   }
 }
 
 
-void quat_to_axis(const quat_t *q, float *x, float *y, float *z, float *a)
+/* widest packet type available for the array functions */
+#if defined(__AVX__)
+#define QUATP_T quat8_t
+#define QUATP_N 8
+#define QUATP(op) quat8_##op
+#define QUATP_V vfloat8_t
+#define QUATP_VI vint8_t
+#define QUATP_VF(op) vfloat8_##op
+#define QUATP_V3_T vec3x8_t
+#define QUATP_V3(op) vec3x8_##op
+#else
+#define QUATP_T quat4_t
+#define QUATP_N 4
+#define QUATP(op) quat4_##op
+#define QUATP_V vfloat4_t
+#define QUATP_VI vint4_t
+#define QUATP_VF(op) vfloat4_##op
+#define QUATP_V3_T vec3x4_t
+#define QUATP_V3(op) vec3x4_##op
+#endif
+
+
+QUAT_API void quat_mul_n(quat_t *o, const quat_t *q1, const quat_t *q2, size_t n)
 {
-   /* see: http://www.euclideanspace.com/maths/geometry/rotations
-           /conversions/quaternionToAngle/index.htm */
-   float angle = 2 * acos(q->w);
-   float s = sqrt(1.0 - q->w * q->w);
-   if (s < ZERO_TOLERANCE) {
-      /* if s close to zero then direction of axis not important */
-      *a = 0;
-      *x = 1;
-      *y = 0;
-      *z = 0;
-   } else {
-      *a = angle;
-      *x = q->x / s; /* normalise axis */
-      *y = q->y / s;
-      *z = q->z / s;
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a, b;
+      QUATP(load)(&a, q1 + i);
+      QUATP(load)(&b, q2 + i);
+      QUATP(mul)(&a, &a, &b);
+      QUATP(store)(o + i, &a);
+   }
+   for (; i < n; i++) {
+      quat_t tmp;
+      quat_mul(&tmp, &q1[i], &q2[i]);
+      o[i] = tmp;
    }
 }
 
 
-void quat_to_axis_v(const quat_t *q, vec3_t *v, float *a)
+QUAT_API void quat_conj_n(quat_t *qo, const quat_t *qi, size_t n)
 {
-   quat_to_axis(q, &v->x, &v->y, &v->z, a);
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a;
+      QUATP(load)(&a, qi + i);
+      QUATP(conj)(&a, &a);
+      QUATP(store)(qo + i, &a);
+   }
+   for (; i < n; i++)
+      quat_conj(&qo[i], &qi[i]);
 }
 
 
-void quat_rot_vec_self(vec3_t *v, const quat_t *q)
+QUAT_API void quat_normalize_n(quat_t *qo, const quat_t *qi, size_t n)
 {
-   vec3_t vo;
-   quat_rot_vec(&vo, v, q);
-   vec3_copy(v, &vo);
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a;
+      QUATP(load)(&a, qi + i);
+      QUATP(normalize)(&a, &a);
+      QUATP(store)(qo + i, &a);
+   }
+   for (; i < n; i++)
+      quat_normalize(&qo[i], &qi[i]);
 }
 
 
-void quat_rot_vec(vec3_t *vo, const vec3_t *vi, const quat_t *q)
+QUAT_API void quat_dot_n(float *d, const quat_t *q1, const quat_t *q2, size_t n)
 {
-   /* see: https://github.com/qsnake/ase/blob/master/ase/quaternions.py */
-   const float vx = vi->x, vy = vi->y, vz = vi->z;
-   const float qw = q->w, qx = q->x, qy = q->y, qz = q->z;
-   const float qww = qw * qw, qxx = qx * qx, qyy = qy * qy, qzz = qz * qz;
-   const float qwx = qw * qx, qwy = qw * qy, qwz = qw * qz, qxy = qx * qy;
-   const float qxz = qx * qz, qyz = qy * qz;
-   vo->x = (qww + qxx - qyy - qzz) * vx + 2 * ((qxy - qwz) * vy + (qxz + qwy) * vz);
-   vo->y = (qww - qxx + qyy - qzz) * vy + 2 * ((qxy + qwz) * vx + (qyz - qwx) * vz);
-   vo->z = (qww - qxx - qyy + qzz) * vz + 2 * ((qxz - qwy) * vx + (qyz + qwx) * vy);
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a, b;
+      QUATP(load)(&a, q1 + i);
+      QUATP(load)(&b, q2 + i);
+      __typeof__(a.w) r = QUATP(dot)(&a, &b);
+      memcpy(d + i, &r, sizeof(r));
+   }
+   for (; i < n; i++)
+      d[i] = quat_dot(&q1[i], &q2[i]);
 }
 
 
-void quat_copy(quat_t *qo, const quat_t *qi)
-{
-   memcpy(qo, qi, sizeof(quat_t));   
-}
+	
 
 
-float quat_len(const quat_t *q)
+QUAT_API quat_t *quat_slerp_fast(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t)
 {
-   float s = 0.0f;
-   FOR_N(i, 4)
-      s += q->vec[i] * q->vec[i];
-   return sqrtf(s);
-}
+   /* polynomial from quat_packet.h, same evaluation order as quat4_slerp_fast */
+   static const float u[8] = QUAT_SLERP_FAST_U, v[8] = QUAT_SLERP_FAST_V;
+   float x = quat_dot(qfrom, qto);
 
+   /* adjust for shortest path */
+   float sign = x < 0.0f ? -1.0f : 1.0f;
+   float xm1 = x * sign - 1.0f;
+
+   float d = 1.0f - t;
+   float tt = t * t, dd = d * d;
+   float bt = 1.0f, bd = 1.0f;
+   for (int i = 7; i >= 0; i--) {
+      bt = 1.0f + (u[i] * tt - v[i]) * xm1 * bt;
+      bd = 1.0f + (u[i] * dd - v[i]) * xm1 * bd;
+   }
+   float scale0 = d * bd;
+   float scale1 = sign * t * bt;
 
-void quat_conj(quat_t *q_out, const quat_t *q_in)
-{
-   q_out->x = -q_in->x;
-   q_out->y = -q_in->y;
-   q_out->z = -q_in->z;
-   q_out->w = q_in->w;
+   qo->x = scale0 * qfrom->x + scale1 * qto->x;
+   qo->y = scale0 * qfrom->y + scale1 * qto->y;
+   qo->z = scale0 * qfrom->z + scale1 * qto->z;
+   qo->w = scale0 * qfrom->w + scale1 * qto->w;
+   return qo;
 }
 
 
-void quat_to_euler(euler_t *euler, const quat_t *quat)
+QUAT_API void quat_slerp_fast_n(quat_t *qo, const quat_t *qfrom, const quat_t *qto,
+                                const float *t, size_t n)
 {
-   const float x = quat->x, y = quat->y, z = quat->z, w = quat->w;
-   const float ww = w * w, xx = x * x, yy = y * y, zz = z * z;
-   euler->yaw = normalize_euler_0_2pi(atan2f(2.f * (x * y + z * w), xx - yy - zz + ww));
-   euler->pitch = asinf(-2.f * (x * z - y * w));
-   euler->roll = atan2f(2.f * (y * z + x * w), -xx - yy + zz + ww);
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a, b;
+      __typeof__(a.w) tv;
+      QUATP(load)(&a, qfrom + i);
+      QUATP(load)(&b, qto + i);
+      memcpy(&tv, t + i, sizeof(tv));
+      QUATP(slerp_fast)(&a, &a, &b, tv);
+      QUATP(store)(qo + i, &a);
+   }
+   for (; i < n; i++) {
+      quat_t tmp;
+      quat_slerp_fast(&tmp, &qfrom[i], &qto[i], t[i]);
+      qo[i] = tmp;
+   }
 }
 
 
-void quat_mul(quat_t *o, const quat_t *q1, const quat_t *q2)
+/* axes i, j, k of the euler orders, x = 0, y = 1, z = 2; the angle of
+   axis a is stored in the euler_t field vec[2 - a] */
+static const unsigned char quat_euler_axes[6][3] =
 {
-   /* see: http://www.euclideanspace.com/maths/algebra/
-           realNormedAlgebra/quaternions/code/index.htm#mul */
-   o->x =  q1->x * q2->w + q1->y * q2->z - q1->z * q2->y + q1->w * q2->x;
-   o->y = -q1->x * q2->z + q1->y * q2->w + q1->z * q2->x + q1->w * q2->y;
-   o->z =  q1->x * q2->y - q1->y * q2->x + q1->z * q2->w + q1->w * q2->z;
-   o->w = -q1->x * q2->x - q1->y * q2->y - q1->z * q2->z + q1->w * q2->w;
-}
-
-
-void quat_add(quat_t *o, const quat_t *q1, const quat_t *q2)
+   { 2, 1, 0 }, { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }
+};
+
+
+/* QUATP_N conversions in order i, j, k; p is 1 if the order is a cyclic
+   permutation of x, y, z and -1 otherwise. q = Ri(a) Rj(b) Rk(c) has
+   the rotation matrix elements
+      R[i][k] = p sin(b),
+      R[j][k] = -p sin(a) cos(b), R[k][k] = cos(a) cos(b),
+      R[i][j] = -p cos(b) sin(c), R[i][i] = cos(b) cos(c)
+   b is taken from sin(b) and cos(b) = |(R[i][i], R[i][j])|, which stays
+   accurate near +-90 degrees, and c from Ri(-a) R = Rj(b) Rk(c):
+      p sin(c) = cos(a) R[j][i] + p sin(a) R[k][i],
+        cos(c) = cos(a) R[j][j] + p sin(a) R[k][j]
+   so that c matches a also in gimbal lock, where only a +- c is defined */
+static inline __attribute__((always_inline))
+void quat_to_euler_packet(euler_t *e, const quat_t *q, int i, int j, int k, float p, int wrap)
 {
-   /* see: http://www.euclideanspace.com/maths/algebra/
-           realNormedAlgebra/quaternions/code/index.htm#add */
-   o->x = q1->x + q2->x;
-   o->y = q1->y + q2->y;
-   o->z = q1->z + q2->z;
-   o->w = q1->w + q2->w;
+   QUATP_T a;
+   QUATP(load)(&a, q);
+   QUATP_V v[3] = { a.x, a.y, a.z }, ang[3], sa, ca;
+   QUATP_V ww = a.w * a.w, ii = v[i] * v[i], jj = v[j] * v[j], kk = v[k] * v[k];
+   QUATP_V wi = a.w * v[i], wj = a.w * v[j], wk = a.w * v[k];
+   QUATP_V ij = v[i] * v[j], ik = v[i] * v[k], jk = v[j] * v[k];
+   QUATP_V rii = ww + ii - jj - kk, rij = 2.0f * (ij - p * wk);
+   ang[i] = QUATP_VF(atan2)(2.0f * (wi - p * jk), ww + kk - ii - jj);
+   ang[j] = QUATP_VF(atan2)(2.0f * (wj + p * ik), QUATP_VF(sqrt)(rii * rii + rij * rij));
+   QUATP_VF(sincos)(&sa, &ca, ang[i]);
+   QUATP_V rji = 2.0f * (ij + p * wk), rki = 2.0f * (ik - p * wj);
+   QUATP_V rjj = ww + jj - ii - kk, rkj = 2.0f * (jk + p * wi);
+   ang[k] = QUATP_VF(atan2)(p * (ca * rji) + sa * rki, ca * rjj + p * (sa * rkj));
+   QUATP_V3_T o = { .x = ang[2], .y = ang[1], .z = ang[0] };
+   if (wrap)
+      o.x = QUATP_VF(wrap_2pi)(o.x);
+   QUATP_V3(store)((vec3_t *)(void *)e, &o);
 }
 
 
-void quat_add_to(quat_t *o, const quat_t *q)
+/* q = (ca, sa e_i) (cb, sb e_j) (cc, sc e_k) with e_i x e_j = p e_k */
+static inline __attribute__((always_inline))
+void quat_from_euler_packet(quat_t *q, const euler_t *e, int i, int j, int k, float p)
 {
-   quat_t tmp;
-   quat_add(&tmp, o, q);
-   quat_copy(o, &tmp);
+   QUATP_V3_T in;
+   QUATP_V3(load)(&in, (const vec3_t *)(const void *)e);
+   QUATP_V ang[3] = { in.z, in.y, in.x }, s[3], c[3], v[3];
+   FOR_N(a, 3)
+      QUATP_VF(sincos)(&s[a], &c[a], ang[a] * 0.5f);
+   QUATP_V cacb = c[i] * c[j], sasb = s[i] * s[j], sacb = s[i] * c[j], casb = c[i] * s[j];
+   QUATP_T o;
+   o.w = cacb * c[k] - p * (sasb * s[k]);
+   v[i] = sacb * c[k] + p * (casb * s[k]);
+   v[j] = casb * c[k] - p * (sacb * s[k]);
+   v[k] = p * (sasb * c[k]) + cacb * s[k];
+   o.x = v[0];
+   o.y = v[1];
+   o.z = v[2];
+   QUATP(store)(q, &o);
 }
 
 
-void quat_scale(quat_t *o, const quat_t *q, float f)
+/* the loops over the packets, the tail is padded to a full packet so
+   that every element goes through the same code */
+static inline __attribute__((always_inline))
+void quat_to_euler_loop(euler_t *e, const quat_t *q, size_t n, int i, int j, int k, int wrap)
 {
-   /* see: http://www.euclideanspace.com/maths/algebra/
-           realNormedAlgebra/quaternions/code/index.htm#scale*/
-   FOR_N(i, 4)
-      o->vec[i] = q->vec[i] * f;
+   const float p = (j - i + 3) % 3 == 1 ? 1.0f : -1.0f;
+   size_t m = n & ~(size_t)(QUATP_N - 1);
+   for (size_t l = 0; l < m; l += QUATP_N)
+      quat_to_euler_packet(e + l, q + l, i, j, k, p, wrap);
+   if (m < n) {
+      quat_t qt[QUATP_N];
+      euler_t et[QUATP_N];
+      FOR_N(l, QUATP_N)
+         qt[l] = m + l < n ? q[m + l] : q[m];
+      quat_to_euler_packet(et, qt, i, j, k, p, wrap);
+      memcpy(e + m, et, (n - m) * sizeof(*e));
+   }
 }
 
 
-void quat_scale_self(quat_t *q, float f)
+static inline __attribute__((always_inline))
+void quat_from_euler_loop(quat_t *q, const euler_t *e, size_t n, int i, int j, int k)
 {
-   quat_scale(q, q, f);
+   const float p = (j - i + 3) % 3 == 1 ? 1.0f : -1.0f;
+   size_t m = n & ~(size_t)(QUATP_N - 1);
+   for (size_t l = 0; l < m; l += QUATP_N)
+      quat_from_euler_packet(q + l, e + l, i, j, k, p);
+   if (m < n) {
+      euler_t et[QUATP_N];
+      quat_t qt[QUATP_N];
+      FOR_N(l, QUATP_N)
+         et[l] = m + l < n ? e[m + l] : e[m];
+      quat_from_euler_packet(qt, et, i, j, k, p);
+      memcpy(q + m, qt, (n - m) * sizeof(*q));
+   }
 }
 
 
-void quat_normalize(quat_t *o, const quat_t *q)
-{
-   /* see: http://www.euclideanspace.com/maths/algebra/
-           realNormedAlgebra/quaternions/code/index.htm#normalise */
-   quat_scale(o, q, 1.0f / quat_len(q));
-}
+/* one instance of the loops per order, with constant axes */
+#define QUAT_EULER_ORDERS(X) X(0) X(1) X(2) X(3) X(4) X(5)
 
 
-void quat_normalize_self(quat_t *q)
+QUAT_API int quat_to_euler_n(euler_t *e, const quat_t *q, size_t n, unsigned int order)
 {
-   quat_normalize(q, q);
+   int wrap = (order & QUAT_EULER_YAW_0_2PI) != 0;
+   switch (order & ~QUAT_EULER_YAW_0_2PI) {
+#define QUAT_EULER_CASE(o) \
+   case o: \
+      quat_to_euler_loop(e, q, n, quat_euler_axes[o][0], quat_euler_axes[o][1], \
+                         quat_euler_axes[o][2], wrap); \
+      return 0;
+   QUAT_EULER_ORDERS(QUAT_EULER_CASE)
+#undef QUAT_EULER_CASE
+   }
+   return -1;
 }
 
 
-float normalize_euler_0_2pi(float a)
+QUAT_API int quat_from_euler_n(quat_t *q, const euler_t *e, size_t n, unsigned int order)
 {
-   while (a < 0)
-      a += (float)(2 * M_PI);
-   return a;
+   switch (order & ~QUAT_EULER_YAW_0_2PI) {
+#define QUAT_EULER_CASE(o) \
+   case o: \
+      quat_from_euler_loop(q, e, n, quat_euler_axes[o][0], quat_euler_axes[o][1], \
+                           quat_euler_axes[o][2]); \
+      return 0;
+   QUAT_EULER_ORDERS(QUAT_EULER_CASE)
+#undef QUAT_EULER_CASE
+   }
+   return -1;
 }
 
 
-/* m is pointer to array of 16 floats in column major order */
-void quat_to_rh_rot_matrix(const quat_t *q, float *m)
-{
-   quat_t qn;
-   float qw, qx, qy, qz;
-
-   quat_normalize(&qn, q);
-
-   qw = qn.w;
-   qx = qn.x;
-   qy = qn.y;
-   qz = qn.z;
-
-   m[0] = 1.0f - 2.0f * qy * qy - 2.0f * qz * qz;
-   m[1] = 2.0f * qx * qy + 2.0f * qz * qw;
-   m[2] = 2.0f * qx * qz - 2.0f * qy * qw;
-   m[3] = 0.0f;
+/* exponential map: the packet versions of quat_exp, quat_log, quat_pow
+   and quat_integrate, with the vector sincos, atan2, exp and log */
+#define QUAT_EXPMAP_EXP 0
+#define QUAT_EXPMAP_LOG 1
+#define QUAT_EXPMAP_POW 2
+#define QUAT_EXPMAP_INTEGRATE 3
 
-   m[4] = 2.0f * qx * qy - 2.0f * qz * qw;
-   m[5] = 1.0f - 2.0f * qx * qx - 2.0f * qz * qz;
-   m[6] = 2.0f * qy * qz + 2.0f * qx * qw;
-   m[7] = 0.0f;
 
-   m[8] = 2.0f * qx * qz + 2.0f * qy * qw;
-   m[9] = 2.0f * qy * qz - 2.0f * qx * qw;
-   m[10] = 1.0f - 2.0f * qx * qx - 2.0f * qy * qy;
-   m[11] = 0.0f;
-
-   m[12] = 0.0f;
-   m[13] = 0.0f;
-   m[14] = 0.0f;
-   m[15] = 1.0f;
+/* o = exp(q); pure inputs (w = 0) skip e^w */
+static inline __attribute__((always_inline))
+void quat_exp_packet(QUATP_T *o, const QUATP_T *q, int pure)
+{
+   QUATP_V t2 = q->x * q->x + q->y * q->y + q->z * q->z;
+   QUATP_V t = QUATP_VF(sqrt)(t2), s, c;
+   QUATP_VF(sincos)(&s, &c, t);
+   /* the Taylor series of quat_exp, also where s / t is 0 / 0 */
+   QUATP_VI small = t < 0.125f;
+   s = QUATP_VF(select)(small, 1.0f - t2 * 0.16666666666666667f * (1.0f - t2 * 0.05f), s / t);
+   c = QUATP_VF(select)(small, 1.0f - t2 * 0.5f * (1.0f - t2 * 0.083333333333333333f), c);
+   if (!pure) {
+      QUATP_V e = QUATP_VF(exp)(q->w);
+      s = s * e;
+      c = e * c;
+   }
+   QUATP_V x = s * q->x, y = s * q->y, z = s * q->z;
+   o->w = c;
+   o->x = x;
+   o->y = y;
+   o->z = z;
 }
 
 
-/* m is pointer to array of 16 floats in column major order */
-void quat_to_lh_rot_matrix(const quat_t *q, float *m)
+static inline __attribute__((always_inline))
+void quat_log_packet(QUATP_T *o, const QUATP_T *q)
 {
-   quat_t qn;
-   float qw, qx, qy, qz;
-
-   quat_normalize(&qn, q);
-
-   qw = qn.w;
-   qx = qn.x;
-   qy = qn.y;
-   qz = qn.z;
-
-   m[0] = 1.0f - 2.0f * qy * qy - 2.0f * qz * qz;
-   m[1] = 2.0f * qx * qy - 2.0f * qz * qw;
-   m[2] = 2.0f * qx * qz + 2.0f * qy * qw;
-   m[3] = 0.0f;
-
-   m[4] = 2.0f * qx * qy + 2.0f * qz * qw;
-   m[5] = 1.0f - 2.0f * qx * qx - 2.0f * qz * qz;
-   m[6] = 2.0f * qy * qz - 2.0f * qx * qw;
-   m[7] = 0.0f;
-
-   m[8] = 2.0f * qx * qz - 2.0f * qy * qw;
-   m[9] = 2.0f * qy * qz + 2.0f * qx * qw;
-   m[10] = 1.0f - 2.0f * qx * qx - 2.0f * qy * qy;
-   m[11] = 0.0f;
-
-   m[12] = 0.0f;
-   m[13] = 0.0f;
-   m[14] = 0.0f;
-   m[15] = 1.0f;
+   QUATP_V s2 = q->x * q->x + q->y * q->y + q->z * q->z;
+   QUATP_V s = QUATP_VF(sqrt)(s2);
+   QUATP_VI vec = s > 0.0f;
+   QUATP_V f = QUATP_VF(select)(vec, QUATP_VF(atan2)(s, q->w) / s, (QUATP_V){ 0.0f });
+   QUATP_V pi = QUATP_VF(select)(vec | (q->w >= 0.0f), (QUATP_V){ 0.0f }, (QUATP_V){ 0.0f } + 3.14159265f);
+   QUATP_V w = 0.5f * QUATP_VF(log)(q->w * q->w + s2);
+   o->x = f * q->x + pi;
+   o->y = f * q->y;
+   o->z = f * q->z;
+   o->w = w;
 }
 
 
-void vec3_init(vec3_t *vo, float x, float y, float z)
+static inline __attribute__((always_inline))
+void quat_expmap_packet(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega,
+                        float dt, int op)
 {
-   vo->x = x;
-   vo->y = y;
-   vo->z = z;
+   QUATP_T a, r;
+   QUATP(load)(&a, q);
+   if (op == QUAT_EXPMAP_EXP) {
+      quat_exp_packet(&r, &a, 0);
+   } else if (op == QUAT_EXPMAP_LOG) {
+      quat_log_packet(&r, &a);
+   } else if (op == QUAT_EXPMAP_POW) {
+      QUATP_V tv;
+      memcpy(&tv, t, sizeof(tv));
+      quat_log_packet(&r, &a);
+      QUATP(scale)(&r, &r, tv);
+      quat_exp_packet(&r, &r, 0);
+   } else {
+      QUATP_T e;
+      QUATP_V3_T w;
+      QUATP_V3(load)(&w, omega);
+      float h = 0.5f * dt;
+      e.w = (QUATP_V){ 0.0f };
+      e.x = w.x * h;
+      e.y = w.y * h;
+      e.z = w.z * h;
+      quat_exp_packet(&e, &e, 1);
+      QUATP(mul)(&r, &a, &e);
+   }
+   QUATP(store)(qo, &r);
 }
 
 
-vec3_t *vec3_add(vec3_t *vo, const vec3_t *v1, const vec3_t *v2)
+/* the tail is padded with identities, zero exponents and rates to a
+   full packet, so that every element goes through the same code */
+static inline __attribute__((always_inline))
+void quat_expmap_n(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega,
+                   float dt, size_t n, int op)
 {
-   vo->x = v1->x + v2->x;
-   vo->y = v1->y + v2->y;
-   vo->z = v1->z + v2->z;
-   return vo;
+   size_t m = n & ~(size_t)(QUATP_N - 1);
+   for (size_t i = 0; i < m; i += QUATP_N)
+      quat_expmap_packet(qo + i, q + i, t ? t + i : NULL, omega ? omega + i : NULL, dt, op);
+   if (m < n) {
+      quat_t qt[QUATP_N];
+      float tt[QUATP_N] = { 0.0f };
+      vec3_t wt[QUATP_N];
+      memset(wt, 0, sizeof(wt));
+      FOR_N(l, QUATP_N) {
+         qt[l] = m + l < n ? q[m + l] : identity_quat;
+         if (m + l < n && t)
+            tt[l] = t[m + l];
+         if (m + l < n && omega)
+            wt[l] = omega[m + l];
+      }
+      quat_expmap_packet(qt, qt, tt, wt, dt, op);
+      memcpy(qo + m, qt, (n - m) * sizeof(*qo));
+   }
 }
 
 
-vec3_t *vec3_add_self(vec3_t *v1, const vec3_t *v2)
+QUAT_API void quat_exp_n(quat_t *qo, const quat_t *q, size_t n)
 {
-   return vec3_add(v1, v1, v2);
+   quat_expmap_n(qo, q, NULL, NULL, 0.0f, n, QUAT_EXPMAP_EXP);
 }
 
 
-vec3_t *vec3_add_c_self(vec3_t *v1, float x, float y, float z)
+QUAT_API void quat_log_n(quat_t *qo, const quat_t *q, size_t n)
 {
-        v1->x += x;
-        v1->y += y;
-        v1->z += z;
-        return v1;
+   quat_expmap_n(qo, q, NULL, NULL, 0.0f, n, QUAT_EXPMAP_LOG);
 }
 
 
-vec3_t *vec3_sub(vec3_t *vo, const vec3_t *v1, const vec3_t *v2)
+QUAT_API void quat_pow_n(quat_t *qo, const quat_t *q, const float *t, size_t n)
 {
-   vo->vec[0] = v1->vec[0] - v2->vec[0];
-   vo->vec[1] = v1->vec[1] - v2->vec[1];
-   vo->vec[2] = v1->vec[2] - v2->vec[2];
-   return vo;
+   quat_expmap_n(qo, q, t, NULL, 0.0f, n, QUAT_EXPMAP_POW);
 }
 
 
-vec3_t *vec3_sub_self(vec3_t *v1, const vec3_t *v2)
+QUAT_API void quat_integrate_n(quat_t *qo, const quat_t *q, const vec3_t *omega, float dt, size_t n)
 {
-   return vec3_sub(v1, v1, v2);
+   quat_expmap_n(qo, q, NULL, omega, dt, n, QUAT_EXPMAP_INTEGRATE);
 }
 
 
-vec3_t *vec3_sub_c_self(vec3_t *v1, float x, float y, float z)
+/* quat_two_prod, quat_two_sum, quat_diff_prod and quat_dot_acc on each lane */
+static inline __attribute__((always_inline))
+QUATP_V quat_two_prod_packet(QUATP_V a, QUATP_V b, QUATP_V *e)
 {
-   v1->x -= x;
-   v1->y -= y;
-   v1->z -= z;
-   return v1;
+   QUATP_V p = a * b;
+   QUATP_V as = 4097.0f * a, bs = 4097.0f * b;
+   QUATP_V ah = as - (as - a), bh = bs - (bs - b);
+   QUATP_V al = a - ah, bl = b - bh;
+   *e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+   return p;
 }
 
 
-vec3_t *vec3_mul(vec3_t *vo, const vec3_t *vi, float scalar)
+static inline __attribute__((always_inline))
+QUATP_V quat_two_sum_packet(QUATP_V a, QUATP_V b, QUATP_V *e)
 {
-   vo->vec[0] = vi->vec[0] * scalar;
-   vo->vec[1] = vi->vec[1] * scalar;
-   vo->vec[2] = vi->vec[2] * scalar;
-   return vo;
+   QUATP_V s = a + b;
+   QUATP_V bv = s - a;
+   *e = (a - (s - bv)) + (b - bv);
+   return s;
 }
 
 
-vec3_t *vec3_mul_self(vec3_t *vi, float scalar)
+static inline __attribute__((always_inline))
+QUATP_V quat_diff_prod_packet(QUATP_V a, QUATP_V b, QUATP_V c, QUATP_V d)
 {
-   return vec3_mul(vi, vi, scalar);
+   QUATP_V e, f;
+   QUATP_V p = quat_two_prod_packet(a, b, &e);
+   QUATP_V q = quat_two_prod_packet(c, d, &f);
+   return (p - q) + (e - f);
 }
 
 
-float vec3_dot(const vec3_t *v1, const vec3_t *v2)
+static inline __attribute__((always_inline))
+QUATP_V quat_dot_acc_packet(QUATP_V ax, QUATP_V ay, QUATP_V az, QUATP_V bx, QUATP_V by, QUATP_V bz)
 {
-   return v1->vec[0] * v2->vec[0] + v1->vec[1] * v2->vec[1] + v1->vec[2] * v2->vec[2];
+   QUATP_V e, r, t;
+   QUATP_V p = quat_two_prod_packet(ax, bx, &e);
+   QUATP_V h = quat_two_prod_packet(ay, by, &r);
+   p = quat_two_sum_packet(p, h, &t);
+   e += t + r;
+   h = quat_two_prod_packet(az, bz, &r);
+   p = quat_two_sum_packet(p, h, &t);
+   e += t + r;
+   return p + e;
 }
 
 
-vec3_t *vec3_cross(vec3_t *vo, const vec3_t *v1, const vec3_t *v2)
+/* quat_decompose_swing_twist on a packet, with the same steps as the
+   scalar version. A zero v1 makes f 0 / 0, which is replaced by 0. */
+static inline __attribute__((always_inline))
+void quat_swing_twist_packet(const quat_t *q, const vec3_t *v1, quat_t *swing, quat_t *twist,
+                             int twist_first)
 {
-   vo->vec[0] = v1->vec[1]*v2->vec[2] - v1->vec[2]*v2->vec[1];
-   vo->vec[1] = v1->vec[2]*v2->vec[0] - v1->vec[0]*v2->vec[2];
-   vo->vec[2] = v1->vec[0]*v2->vec[1] - v1->vec[1]*v2->vec[0];
-   return vo;
+   QUATP_T a, s, t, c;
+   QUATP_V3_T v;
+   QUATP(load)(&a, q);
+   QUATP_V3(load)(&v, v1);
+   QUATP_V d = quat_dot_acc_packet(a.x, a.y, a.z, v.x, v.y, v.z);
+   QUATP_V f = d / (v.x * v.x + v.y * v.y + v.z * v.z);
+   f = QUATP_VF(select)(f == f, f, (QUATP_V){ 0.0f });
+   t.w = a.w;
+   t.x = f * v.x;
+   t.y = f * v.y;
+   t.z = f * v.z;
+   QUATP_V n = QUATP(len)(&t);
+   QUATP_VI ok = n > 0.0f;
+   t.w = QUATP_VF(select)(ok, t.w / n, (QUATP_V){ 0.0f } + 1.0f);
+   t.x = QUATP_VF(select)(ok, t.x / n, (QUATP_V){ 0.0f });
+   t.y = QUATP_VF(select)(ok, t.y / n, (QUATP_V){ 0.0f });
+   t.z = QUATP_VF(select)(ok, t.z / n, (QUATP_V){ 0.0f });
+   QUATP(conj)(&c, &t);
+   QUATP(mul)(&s, &a, &c);
+   if (twist_first) {
+      QUATP(conj)(&c, &s);
+      QUATP(mul)(&t, &a, &c);
+   }
+   QUATP(store)(swing, &s);
+   QUATP(store)(twist, &t);
 }
 
 
-float vec3_len2(const vec3_t *v)
+/* the tail is padded with identities around x */
+static inline __attribute__((always_inline))
+void quat_swing_twist_n(const quat_t *q, const vec3_t *v1, quat_t *swing, quat_t *twist,
+                        size_t n, int twist_first)
 {
-   return v->x * v->x + v->y * v->y + v->z * v->z;
+   size_t m = n & ~(size_t)(QUATP_N - 1);
+   for (size_t i = 0; i < m; i += QUATP_N)
+      quat_swing_twist_packet(q + i, v1 + i, swing + i, twist + i, twist_first);
+   if (m < n) {
+      quat_t qt[QUATP_N], st[QUATP_N], tt[QUATP_N];
+      vec3_t vt[QUATP_N];
+      FOR_N(l, QUATP_N) {
+         qt[l] = m + l < n ? q[m + l] : identity_quat;
+         vt[l] = m + l < n ? v1[m + l] : (vec3_t){ { 1.0f, 0.0f, 0.0f } };
+      }
+      quat_swing_twist_packet(qt, vt, st, tt, twist_first);
+      memcpy(swing + m, st, (n - m) * sizeof(*swing));
+      memcpy(twist + m, tt, (n - m) * sizeof(*twist));
+   }
 }
 
 
-vec3_t *vec3_normalize(vec3_t *vo, const vec3_t *vi)
+QUAT_API void quat_decompose_swing_twist_n(const quat_t *q, const vec3_t *v1, quat_t *swing,
+                                           quat_t *twist, size_t n)
 {
-   float len = sqrt(vec3_len2(vi));
-   vo->x = vi->x / len;
-   vo->y = vi->y / len;
-   vo->z = vi->z / len;
-   return vo;
+   quat_swing_twist_n(q, v1, swing, twist, n, 0);
 }
 
 
-vec3_t *vec3_rot_axis(vec3_t *vo, vec3_t *vi, float x, float y, float z, float angle)
+QUAT_API void quat_decompose_twist_swing_n(const quat_t *q, const vec3_t *v1, quat_t *twist,
+                                           quat_t *swing, size_t n)
 {
-   vec3_copy(vo, vi);
-   return vec3_rot_axis_self(vo, x, y, z, angle);
+   quat_swing_twist_n(q, v1, swing, twist, n, 1);
 }
 
 
-vec3_t *vec3_rot_axis_self(vec3_t *vo, float x, float y, float z, float angle)
+/* quat_from_u2v on a packet, with the same steps as the scalar version;
+   zero u or v give the identity */
+static inline __attribute__((always_inline))
+void quat_u2v_packet(QUATP_T *q, const QUATP_V3_T *u, const QUATP_V3_T *v, const QUATP_V3_T *up)
 {
-   quat_t rotate;
-   quat_init_axis(&rotate, x, y, z, angle);
-   quat_rot_vec_self(vo, &rotate);
-   return vo;
+   QUATP_V one = (QUATP_V){ 0.0f } + 1.0f, zero = { 0.0f };
+   QUATP_V aa = u->x * u->x + u->y * u->y + u->z * u->z;
+   QUATP_V l = QUATP_VF(sqrt)(aa * (v->x * v->x + v->y * v->y + v->z * v->z));
+   QUATP_VI ok = l > 0.0f;
+   aa = QUATP_VF(select)(ok, aa, one);
+   QUATP_V il = one / QUATP_VF(select)(ok, l, one);
+   QUATP_V d = (u->x * v->x + u->y * v->y + u->z * v->z) * il;
+   QUATP_V cx = u->y * v->z - u->z * v->y, cy = u->z * v->x - u->x * v->z, cz = u->x * v->y - u->y * v->x;
+   QUATP_V g = (cx * u->x + cy * u->y + cz * u->z) / aa;
+   cx = (cx - g * u->x) * il;
+   cy = (cy - g * u->y) * il;
+   cz = (cz - g * u->z) * il;
+   QUATP_V cc = cx * cx + cy * cy + cz * cz;
+   QUATP_VI neg = d < 0.0f;
+   QUATP_V w = QUATP_VF(select)(neg, cc / (one - d), one + d);
+   QUATP_VI anti = neg & (cc <= 1.0e-6f * 1.0e-6f);
+   /* half turn h around up without its part along u, else u x x or u x y */
+   QUATP_V hx = up->x, hy = up->y, hz = up->z;
+   QUATP_V ee = hx * hx + hy * hy + hz * hz;
+   FOR_N(k, 2) {
+      QUATP_V f = (hx * u->x + hy * u->y + hz * u->z) / aa;
+      hx -= f * u->x;
+      hy -= f * u->y;
+      hz -= f * u->z;
+   }
+   QUATP_VI par = hx * hx + hy * hy + hz * hz <= 1.0e-6f * 1.0e-6f * ee;
+   QUATP_VI nx = u->x * u->x < 0.25f * aa;
+   hx = QUATP_VF(select)(par, QUATP_VF(select)(nx, zero, -u->z), hx);
+   hy = QUATP_VF(select)(par, QUATP_VF(select)(nx, u->z, zero), hy);
+   hz = QUATP_VF(select)(par, QUATP_VF(select)(nx, -u->y, u->x), hz);
+   /* then (1 - d, -c) from -u to v */
+   QUATP_V lmd = one - d;
+   w = QUATP_VF(select)(anti, cx * hx + cy * hy + cz * hz, w);
+   QUATP_V x = QUATP_VF(select)(anti, lmd * hx - (cy * hz - cz * hy), cx);
+   QUATP_V y = QUATP_VF(select)(anti, lmd * hy - (cz * hx - cx * hz), cy);
+   QUATP_V z = QUATP_VF(select)(anti, lmd * hz - (cx * hy - cy * hx), cz);
+   QUATP_V n = QUATP_VF(sqrt)(w * w + x * x + y * y + z * z);
+   q->w = QUATP_VF(select)(ok, w / n, one);
+   q->x = QUATP_VF(select)(ok, x / n, zero);
+   q->y = QUATP_VF(select)(ok, y / n, zero);
+   q->z = QUATP_VF(select)(ok, z / n, zero);
 }
 
 
-double vec3_dist(const vec3_t *v1, const vec3_t *v2)
+/* quat_look_at on a packet, with the same steps as the scalar version */
+static inline __attribute__((always_inline))
+void quat_look_at_packet(QUATP_T *q, const QUATP_V3_T *pos, const QUATP_V3_T *target,
+                         const QUATP_V3_T *up)
 {
-   return sqrt((v1->x - v2->x) * (v1->x - v2->x) +
-               (v1->y - v2->y) * (v1->y - v2->y) +
-               (v1->z - v2->z) * (v1->z - v2->z));
+   QUATP_V one = (QUATP_V){ 0.0f } + 1.0f, zero = { 0.0f };
+   QUATP_V3_T x = { .x = one, .y = zero, .z = zero }, y = { .x = zero, .y = one, .z = zero }, d, dl, y1;
+   QUATP_T q1, q2;
+   d.x = quat_two_sum_packet(target->x, -pos->x, &dl.x);
+   d.y = quat_two_sum_packet(target->y, -pos->y, &dl.y);
+   d.z = quat_two_sum_packet(target->z, -pos->z, &dl.z);
+   quat_u2v_packet(&q1, &x, &d, up);
+   QUATP(rot_vec)(&y1, &y, &q1);
+   QUATP_V dd = d.x * d.x + d.y * d.y + d.z * d.z;
+   QUATP_V ee = up->x * up->x + up->y * up->y + up->z * up->z;
+   /* m = up x d from exact products, p = d x m / |d|^2 */
+   QUATP_V mx = quat_diff_prod_packet(up->y, d.z, up->z, d.y) + (up->y * dl.z - up->z * dl.y);
+   QUATP_V my = quat_diff_prod_packet(up->z, d.x, up->x, d.z) + (up->z * dl.x - up->x * dl.z);
+   QUATP_V mz = quat_diff_prod_packet(up->x, d.y, up->y, d.x) + (up->x * dl.y - up->y * dl.x);
+   QUATP_VI far = dd > 0.0f;
+   QUATP_VI along = ~far | (mx * mx + my * my + mz * mz <= 1.0e-6f * 1.0e-6f * ee * dd);
+   QUATP_V id = one / QUATP_VF(select)(far, dd, one);
+   QUATP_V fa = (y1.x * d.x + y1.y * d.y + y1.z * d.z) * id;
+   QUATP_V ax = y1.x - fa * d.x, ay = y1.y - fa * d.y, az = y1.z - fa * d.z;
+   QUATP_V px = (d.y * mz - d.z * my) * id, py = (d.z * mx - d.x * mz) * id, pz = (d.x * my - d.y * mx) * id;
+   QUATP_V k = QUATP_VF(sqrt)((ax * ax + ay * ay + az * az) * (px * px + py * py + pz * pz));
+   QUATP_V c = ax * px + ay * py + az * pz;
+   QUATP_V s = (ay * pz - az * py) * d.x + (az * px - ax * pz) * d.y + (ax * py - ay * px) * d.z;
+   /* q2 = (w, f d) */
+   QUATP_VI pos_c = c >= 0.0f;
+   QUATP_V w = QUATP_VF(select)(pos_c, k + c, s);
+   QUATP_V f = QUATP_VF(select)(pos_c, s * id, k - c);
+   QUATP_V n = QUATP_VF(sqrt)(w * w + f * f * dd);
+   q2.w = w / n;
+   q2.x = f * d.x / n;
+   q2.y = f * d.y / n;
+   q2.z = f * d.z / n;
+   QUATP(mul)(&q2, &q2, &q1);
+   q->w = QUATP_VF(select)(along, q1.w, q2.w);
+   q->x = QUATP_VF(select)(along, q1.x, q2.x);
+   q->y = QUATP_VF(select)(along, q1.y, q2.y);
+   q->z = QUATP_VF(select)(along, q1.z, q2.z);
 }
 
 
-double vec3_dist_c(const vec3_t *v1, float x, float y, float z)
-{
-   return sqrt((v1->x - x) * (v1->x - x) +
-               (v1->y - y) * (v1->y - y) +
-               (v1->z - z) * (v1->z - z));
-}
+#define QUAT_AIM_U2V 0
+#define QUAT_AIM_LOOK_AT 1
 
-const quat_t identity_quat = { {1.0, 0.0, 0.0, 0.0} };
-	
-/* see http://gamedev.stackexchange.com/questions/15070/orienting-a-model-to-face-a-target */
-/* Calculate the quaternion to rotate from vector u to vector v */
-void quat_from_u2v(quat_t *q, const vec3_t *u, const vec3_t *v, const vec3_t *up)
+static inline __attribute__((always_inline))
+void quat_aim_packet(quat_t *q, const vec3_t *a, const vec3_t *b, const vec3_t *up, int op)
 {
-   vec3_t un, vn, axis, axisn;
-   float dot;
-   float angle;
-
-   vec3_normalize(&un, u);
-   vec3_normalize(&vn, v);
-   dot = vec3_dot(&un, &vn);
-   if (fabs(dot - -1.0f) < ZERO_TOLERANCE) {
-      /* vector a and b point exactly in the opposite direction
-       * so it is a 180 degrees turn around the up-axis
-       */
-      vec3_t default_up = { { 0, 1, 0} };
-      if (!up)
-         up = &default_up;
-      quat_init_axis(q, up->x, up->y, up->z, M_PI);
-      return;
-   }
-   if (fabs(dot - 1.0f) < ZERO_TOLERANCE) {
-      /* vector a and b point exactly in the same direction
-       * so we return the identity quaternion
-       */
-      *q = identity_quat;
-      return;
+   QUATP_V3_T va, vb, vu;
+   QUATP_T r;
+   QUATP_V3(load)(&va, a);
+   QUATP_V3(load)(&vb, b);
+   if (up) {
+      QUATP_V3(load)(&vu, up);
+   } else {
+      vu.x = (QUATP_V){ 0.0f };
+      vu.y = (QUATP_V){ 0.0f } + 1.0f;
+      vu.z = (QUATP_V){ 0.0f };
    }
-   angle = acos(dot);
-   vec3_cross(&axis, &un, &vn);
-   vec3_normalize(&axisn, &axis);
-   quat_init_axis(q, axisn.x, axisn.y, axisn.z, angle);
+   if (op == QUAT_AIM_U2V)
+      quat_u2v_packet(&r, &va, &vb, &vu);
+   else
+      quat_look_at_packet(&r, &va, &vb, &vu);
+   QUATP(store)(q, &r);
 }
 
 
-float quat_dot(const quat_t *q1, const quat_t *q2)
+/* the tail is padded with rotations from x to x */
+static inline __attribute__((always_inline))
+void quat_aim_n(quat_t *q, const vec3_t *a, const vec3_t *b, const vec3_t *up, size_t n, int op)
 {
-   return q1->vec[0] * q2->vec[0] + q1->vec[1] * q2->vec[1] +
-          q1->vec[2] * q2->vec[2] + q1->vec[3] * q2->vec[3];
+   size_t m = n & ~(size_t)(QUATP_N - 1);
+   for (size_t i = 0; i < m; i += QUATP_N)
+      quat_aim_packet(q + i, a + i, b + i, up ? up + i : NULL, op);
+   if (m < n) {
+      quat_t qt[QUATP_N];
+      vec3_t at[QUATP_N], bt[QUATP_N], ut[QUATP_N];
+      FOR_N(l, QUATP_N) {
+         at[l] = m + l < n ? a[m + l] : (vec3_t){ { op == QUAT_AIM_U2V ? 1.0f : 0.0f, 0.0f, 0.0f } };
+         bt[l] = m + l < n ? b[m + l] : (vec3_t){ { 1.0f, 0.0f, 0.0f } };
+         ut[l] = m + l < n && up ? up[m + l] : (vec3_t){ { 0.0f, 1.0f, 0.0f } };
+      }
+      quat_aim_packet(qt, at, bt, ut, op);
+      memcpy(q + m, qt, (n - m) * sizeof(*q));
+   }
 }
 
 
-static quat_t *quat_lerp(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t)
+QUAT_API void quat_from_u2v_n(quat_t *q, const vec3_t *u, const vec3_t *v, const vec3_t *up, size_t n)
 {
-   double cosom = quat_dot(qfrom, qto);
-
-   /* qto = qfrom or qto = -qfrom so no rotation to slerp */
-   if (cosom >= 1.0) {
-      quat_copy(qo, qfrom);
-      return qo;
-   }
-
-   /* adjust for shortest path */
-   quat_t to1;
-   if (cosom < 0.0) {
-      to1.x = -qto->x;
-      to1.y = -qto->y;
-      to1.z = -qto->z;
-      to1.w = -qto->w;
-   } else {
-      quat_copy(&to1, qto);
-   }
-
-   double scale0 = 1.0 - t;
-   double scale1 = t;
-
-   /* calculate final values */
-   qo->x = scale0 * qfrom->x + scale1 * to1.x;
-   qo->y = scale0 * qfrom->y + scale1 * to1.y;
-   qo->z = scale0 * qfrom->z + scale1 * to1.z;
-   qo->w = scale0 * qfrom->w + scale1 * to1.w;
-   return qo;
+   quat_aim_n(q, u, v, up, n, QUAT_AIM_U2V);
 }
 
 
-quat_t *quat_nlerp(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t)
+QUAT_API void quat_look_at_n(quat_t *q, const vec3_t *pos, const vec3_t *target, const vec3_t *up, size_t n)
 {
-   quat_lerp(qo, qfrom, qto, t); 
-   quat_normalize_self(qo);
-   return qo; 
+   quat_aim_n(q, pos, target, up, n, QUAT_AIM_LOOK_AT);
 }
 
 
-quat_t *quat_slerp(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t)
+/* rotation terms of quat_to_rh_rot_matrix as row major 3x3 matrix r,
+   for float and for vector operands */
+#define QUAT_MATRIX_TERMS(r, qw, qx, qy, qz) \
+   do { \
+      r[0] = 1.0f - 2.0f * qy * qy - 2.0f * qz * qz; \
+      r[1] = 2.0f * qx * qy - 2.0f * qz * qw; \
+      r[2] = 2.0f * qx * qz + 2.0f * qy * qw; \
+      r[3] = 2.0f * qx * qy + 2.0f * qz * qw; \
+      r[4] = 1.0f - 2.0f * qx * qx - 2.0f * qz * qz; \
+      r[5] = 2.0f * qy * qz - 2.0f * qx * qw; \
+      r[6] = 2.0f * qx * qz - 2.0f * qy * qw; \
+      r[7] = 2.0f * qy * qz + 2.0f * qx * qw; \
+      r[8] = 1.0f - 2.0f * qx * qx - 2.0f * qy * qy; \
+   } while (0)
+
+/* matrix elements are taken from e[0 .. 13]: 0 .. 8 rotation terms,
+   9 .. 11 translation, 12 zero, 13 one */
+#define QUAT_MATRIX_ELEMS 14
+
+
+/* fills idx with the element of every output float, returns the matrix size */
+static int quat_matrix_index(int *idx, unsigned int flags)
 {
-   /* calc cosine */
-   double cosom = quat_dot(qfrom, qto);
+   const int rows = (flags & QUAT_MATRIX_4X4) ? 4 : 3;
+   const int cols = (flags & (QUAT_MATRIX_3X4 | QUAT_MATRIX_4X4)) ? 4 : 3;
+   const int col_major = (flags & QUAT_MATRIX_COL_MAJOR) != 0;
+   int k = 0;
+   FOR_N(a, (col_major ? cols : rows))
+      FOR_N(b, (col_major ? rows : cols)) {
+         int r = col_major ? b : a, c = col_major ? a : b;
+         if (r == 3)
+            idx[k++] = c == 3 ? 13 : 12;
+         else if (c == 3)
+            idx[k++] = 9 + r;
+         else
+            idx[k++] = (flags & QUAT_MATRIX_LH) ? c * 3 + r : r * 3 + c;
+      }
+   return k;
+}
 
-   /* qto = qfrom or qto = -qfrom so no rotation to slerp */
-   if (cosom >= 1.0) {
-      quat_copy(qo, qfrom);
-      return qo; 
-   }   
 
-   /* adjust for shortest path */
-   quat_t to1;
-   if (cosom < 0.0) {
-      cosom = -cosom;
-      to1.x = -qto->x;
-      to1.y = -qto->y;
-      to1.z = -qto->z;
-      to1.w = -qto->w;
-   } else {
-      quat_copy(&to1, qto);
+/* writes lanes matrices to m; element j of lane l is e[j * lanes + l].
+   Groups of 4 lanes are transposed into 4 consecutive output floats each. */
+static void quat_matrix_store(float *m, size_t stride, const float *e, int lanes,
+                              const int *idx, int len)
+{
+   int k, l = 0;
+#if defined(__SSE__)
+   for (; l < (lanes & ~3); l += 4) {
+      float *o = m + l * stride;
+      for (k = 0; k < (len & ~3); k += 4) {
+         __m128 r0 = _mm_loadu_ps(e + idx[k] * lanes + l);
+         __m128 r1 = _mm_loadu_ps(e + idx[k + 1] * lanes + l);
+         __m128 r2 = _mm_loadu_ps(e + idx[k + 2] * lanes + l);
+         __m128 r3 = _mm_loadu_ps(e + idx[k + 3] * lanes + l);
+         _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+         _mm_storeu_ps(o + k, r0);
+         _mm_storeu_ps(o + stride + k, r1);
+         _mm_storeu_ps(o + 2 * stride + k, r2);
+         _mm_storeu_ps(o + 3 * stride + k, r3);
+      }
+      for (; k < len; k++)
+         FOR_N(j, 4)
+            o[j * stride + k] = e[idx[k] * lanes + l + j];
    }
-
-   /* calculate coefficients */
-   double scale0, scale1;
-   if (cosom < 0.99995) {
-      /* standard case (slerp) */
-      double omega = acos(cosom);
-      double sinom = sin(omega);
-      scale0 = sin((1.0 - t) * omega) / sinom;
-      scale1 = sin(t * omega) / sinom;
-   } else {
-      /* "from" and "to" quaternions are very close
-       *  ... so we can do a linear interpolation
-       */
-      scale0 = 1.0 - t;
-      scale1 = t;
-   }
-
-   /* calculate final values */
-   qo->x = scale0 * qfrom->x + scale1 * to1.x;
-   qo->y = scale0 * qfrom->y + scale1 * to1.y;
-   qo->z = scale0 * qfrom->z + scale1 * to1.z;
-   qo->w = scale0 * qfrom->w + scale1 * to1.w;
-   return qo;
+#endif /* __SSE__ */
+   for (; l < lanes; l++)
+      for (k = 0; k < len; k++)
+         m[l * stride + k] = e[idx[k] * lanes + l];
 }
 
 
-quat_t *quat_apply_relative_yaw_pitch_roll(quat_t *q,
-                                        double yaw, double pitch, double roll)
+QUAT_API void quat_to_matrix_n(float *m, size_t stride, const quat_t *q, const vec3_t *t,
+                               size_t n, unsigned int flags)
 {
-        quat_t qyaw, qpitch, qroll, qrot, q1, q2, q3, q4;
-
-        /* calculate amount of yaw to impart this iteration... */
-        quat_init_axis(&qyaw, 0.0, 1.0, 0.0, yaw);
-        /* Calculate amount of pitch to impart this iteration... */
-        quat_init_axis(&qpitch, 0.0, 0.0, 1.0, pitch);
-        /* Calculate amount of roll to impart this iteration... */
-        quat_init_axis(&qroll, 1.0, 0.0, 0.0, roll);
-        /* Combine pitch, roll and yaw */
-        quat_mul(&q1, &qyaw, &qpitch);
-        quat_mul(&qrot, &q1, &qroll);
-
-        /* Convert rotation to local coordinate system */
-        quat_mul(&q1, q, &qrot);
-        quat_conj(&q2, q);
-        quat_mul(&q3, &q1, &q2);
-        /* Apply to local orientation */
-        quat_mul(&q4, &q3, q);
-        quat_normalize_self(&q4);
-        *q = q4;
-        return q;
+   int idx[16];
+   const int len = quat_matrix_index(idx, flags);
+   float e[QUAT_MATRIX_ELEMS][QUATP_N];
+   FOR_N(l, QUATP_N) {
+      FOR_N(j, 3)
+         e[9 + j][l] = 0.0f;
+      e[12][l] = 0.0f;
+      e[13][l] = 1.0f;
+   }
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      QUATP_T a;
+      __typeof__(a.w) r[9];
+      QUATP(load)(&a, q + i);
+      if (!(flags & QUAT_MATRIX_UNIT))
+         QUATP(normalize)(&a, &a);
+      QUAT_MATRIX_TERMS(r, a.w, a.x, a.y, a.z);
+      memcpy(e, r, sizeof(r));
+      if (t)
+         FOR_N(l, QUATP_N)
+            FOR_N(j, 3)
+               e[9 + j][l] = t[i + l].vec[j];
+      quat_matrix_store(m + i * stride, stride, e[0], QUATP_N, idx, len);
+   }
+   for (; i < n; i++) {
+      quat_t a = q[i];
+      float e[QUAT_MATRIX_ELEMS];
+      if (!(flags & QUAT_MATRIX_UNIT))
+         quat_normalize(&a, &q[i]);
+      QUAT_MATRIX_TERMS(e, a.w, a.x, a.y, a.z);
+      FOR_N(j, 3)
+         e[9 + j] = t ? t[i].vec[j] : 0.0f;
+      e[12] = 0.0f;
+      e[13] = 1.0f;
+      quat_matrix_store(m + i * stride, stride, e, 1, idx, len);
+   }
 }
 
 
-quat_t *quat_apply_relative_yaw_pitch(quat_t *q, double yaw, double pitch)
+/* reads lanes matrices from m, the inverse of quat_matrix_store */
+static void quat_matrix_load(float *e, int lanes, const float *m, size_t stride,
+                             const int *idx, int len)
 {
-        quat_t qyaw, qpitch, q1;
-
-        /* calculate amount of yaw to impart this iteration... */
-        quat_init_axis(&qyaw, 0.0, 1.0, 0.0, yaw);
-        /* Calculate amount of pitch to impart this iteration... */
-        quat_init_axis(&qpitch, 0.0, 0.0, 1.0, pitch);
-
-        quat_mul(&q1, &qyaw, q);
-        quat_mul(q, &q1, &qpitch);
-        return q;
+   int k, l = 0;
+#if defined(__SSE__)
+   for (; l < (lanes & ~3); l += 4) {
+      const float *p = m + l * stride;
+      for (k = 0; k < (len & ~3); k += 4) {
+         __m128 r0 = _mm_loadu_ps(p + k);
+         __m128 r1 = _mm_loadu_ps(p + stride + k);
+         __m128 r2 = _mm_loadu_ps(p + 2 * stride + k);
+         __m128 r3 = _mm_loadu_ps(p + 3 * stride + k);
+         _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+         _mm_storeu_ps(e + idx[k] * lanes + l, r0);
+         _mm_storeu_ps(e + idx[k + 1] * lanes + l, r1);
+         _mm_storeu_ps(e + idx[k + 2] * lanes + l, r2);
+         _mm_storeu_ps(e + idx[k + 3] * lanes + l, r3);
+      }
+      for (; k < len; k++)
+         FOR_N(j, 4)
+            e[idx[k] * lanes + l + j] = p[j * stride + k];
+   }
+#endif /* __SSE__ */
+   for (; l < lanes; l++)
+      for (k = 0; k < len; k++)
+         e[idx[k] * lanes + l] = m[l * stride + k];
 }
 
-void quat_decompose_twist_swing(const quat_t *q, const vec3_t *v1, quat_t *twist, quat_t *swing)
-{
-	vec3_t v2;
-	quat_rot_vec(&v2, v1, q);
 
-	quat_from_u2v(swing, v1, &v2, 0);
-	quat_t swing_conj;
-	quat_conj(&swing_conj, swing);
-	quat_mul(twist, q, &swing_conj);
+/* lane-wise quat_from_rot_rows, with masks instead of branches */
+static inline void quat_from_rot_packet(QUATP_T *o, const QUATP_V *r)
+{
+   const QUATP_V one = (QUATP_V){ 0.0f } + 1.0f;
+   QUATP_V big = r[0] + r[4] + r[8];
+   QUATP_VI k1 = r[0] > big;
+   big = QUATP_VF(select)(k1, r[0], big);
+   QUATP_VI k2 = r[4] > big;
+   big = QUATP_VF(select)(k2, r[4], big);
+   QUATP_VI k3 = r[8] > big;
+   k2 &= ~k3;
+   k1 &= ~(k2 | k3);
+   QUATP_VI k0 = ~(k1 | k2 | k3);
+
+   /* 1 +- r0 +- r4 +- r8, multiplying by +-1 is exact */
+   QUATP_V s0 = QUATP_VF(select)(k0 | k1, one, -one);
+   QUATP_V s4 = QUATP_VF(select)(k0 | k2, one, -one);
+   QUATP_V s8 = QUATP_VF(select)(k0 | k3, one, -one);
+   QUATP_V h = 0.5f * QUATP_VF(sqrt)(1.0f + s0 * r[0] + s4 * r[4] + s8 * r[8]);
+   QUATP_V f = 0.25f / h;
+
+   QUATP_V a = r[7] - r[5], b = r[2] - r[6], c = r[3] - r[1];
+   QUATP_V d = r[1] + r[3], e = r[2] + r[6], g = r[5] + r[7];
+   QUATP_V w = QUATP_VF(select)(k0, h, QUATP_VF(select)(k1, a, QUATP_VF(select)(k2, b, c)) * f);
+   QUATP_V x = QUATP_VF(select)(k1, h, QUATP_VF(select)(k0, a, QUATP_VF(select)(k2, d, e)) * f);
+   QUATP_V y = QUATP_VF(select)(k2, h, QUATP_VF(select)(k0, b, QUATP_VF(select)(k1, d, g)) * f);
+   QUATP_V z = QUATP_VF(select)(k3, h, QUATP_VF(select)(k0, c, QUATP_VF(select)(k1, e, g)) * f);
+
+   QUATP_VI neg = w < 0.0f;
+   o->w = QUATP_VF(select)(neg, -w, w);
+   o->x = QUATP_VF(select)(neg, -x, x);
+   o->y = QUATP_VF(select)(neg, -y, y);
+   o->z = QUATP_VF(select)(neg, -z, z);
 }
 
-void quat_decompose_swing_twist(const quat_t *q, const vec3_t *v1, quat_t *swing, quat_t *twist)
-{
-	vec3_t v2;
-	quat_rot_vec(&v2, v1, q);
 
-	quat_from_u2v(swing, v1, &v2, 0);
-	quat_t swing_conj;
-	quat_conj(&swing_conj, swing);
-	quat_mul(twist, &swing_conj, q);
+QUAT_API void quat_from_matrix_n(quat_t *q, const float *m, size_t stride,
+                                 size_t n, unsigned int flags)
+{
+   int idx[16];
+   /* with QUAT_MATRIX_LH the index transposes the rotation back */
+   const int len = quat_matrix_index(idx, flags);
+   size_t i = 0;
+   for (; i < (n & ~(size_t)(QUATP_N - 1)); i += QUATP_N) {
+      float e[QUAT_MATRIX_ELEMS][QUATP_N];
+      QUATP_V r[9];
+      QUATP_T a;
+      quat_matrix_load(e[0], QUATP_N, m + i * stride, stride, idx, len);
+      memcpy(r, e, sizeof(r));
+      quat_from_rot_packet(&a, r);
+      QUATP(store)(q + i, &a);
+   }
+   for (; i < n; i++) {
+      float e[QUAT_MATRIX_ELEMS];
+      quat_matrix_load(e, 1, m + i * stride, stride, idx, len);
+      quat_from_rot_rows(&q[i], e);
+   }
 }
-
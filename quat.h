@@ -21,6 +21,22 @@
 #define __QUAT_H__
 
 
+#include <stddef.h>
+
+
+/* Define QUAT_INLINE before including quat.h to get the whole library
+ * as static inline functions (no quat.o needed). This lets the compiler
+ * inline and vectorize across calls in the including translation unit.
+ */
+#if defined(QUAT_INLINE)
+#define QUAT_API static inline
+#define QUAT_API_DATA static
+#else
+#define QUAT_API
+#define QUAT_API_DATA
+#endif
+
+
 /* generic 3d vector */
 typedef union
 {
@@ -71,158 +87,225 @@ typedef union
 euler_t;
 
 
-/* copy vector vi to vo */
-void vec3_copy(vec3_t *vo, vec3_t *vi);
-
-/* init orientation quaternion from measurements */
-void quaternion_init(quat_t *quat, const vec3_t *acc, const vec3_t *mag);
-
-/* initialize quaternion from axis angle using floats */
-void quat_init_axis(quat_t *q, float x, float y, float z, float a);
-
-/* initialize quaternion from axis angle using a vector */
-void quat_init_axis_v(quat_t *q, const vec3_t *v, float a);
-
-/* extract axis and angle from a quaternion */
-void quat_to_axis(const quat_t *q, float *x, float *y, float *z, float *a);
-
-/* extract axis in vector form and angle from a quaternion */
-void quat_to_axis_v(const quat_t *q, vec3_t *v, float *a);
-
-/* rotate vector vi via unit quaternion q and put result into vector vo */
-void quat_rot_vec(vec3_t *vo, const vec3_t *vi, const quat_t *q);
-
-/* rotate vector v_in in-place via unit quaternion quat */
-void quat_rot_vec_self(vec3_t *v, const quat_t *q);
-
-/* returns len of quaternion */
-float quat_len(const quat_t *q);
-
-/* copy quaternion qi to qo */
-void quat_copy(quat_t *qo, const quat_t *qi);
-
-/* qo = qi * f */
-void quat_scale(quat_t *qo, const quat_t *qi, float f);
-
-/* qo *= f */
-void quat_scale_self(quat_t *q, float f);
+/* double precision 3d vector */
+typedef union
+{
+   struct
+   {
+      double x;
+      double y;
+      double z;
+   };
+   double vec[3];
+}
+vec3d_t;
 
-/* conjugate quaternion */
-void quat_conj(quat_t *qo, const quat_t *qi);
 
-/* o = q1 + 12 */
-void quat_add(quat_t *qo, const quat_t *q1, const quat_t *q2);
+/* double precision quaternion */
+typedef union
+{
+   struct
+   {
+      double q0;
+      double q1;
+      double q2;
+      double q3;
+   };
+   struct
+   {
+      double w;
+      double x;
+      double y;
+      double z;
+   };
+   double vec[4];
+}
+quatd_t;
 
-/* o += q */
-void quat_add_self(quat_t *o, const quat_t *q);
 
-/* o = q1 * q2 */
-void quat_mul(quat_t *o, const quat_t *q1, const quat_t *q2);
+/* double precision euler angle */
+typedef union
+{
+   struct
+   {
+      double yaw;
+      double pitch;
+      double roll;
+   };
+   double vec[3];
+}
+eulerd_t;
 
-/* normalizes quaternion q and puts result into o */
-void quat_normalize(quat_t *qo, const quat_t *qi);
 
-/* normalize q in-place */
-void quat_normalize_self(quat_t *q);
+/*
+ * The scalar API is declared once in quat_tmpl.h and instantiated for
+ * float (quat_t, vec3_t, euler_t: quat_*, vec3_*) and for double
+ * (quatd_t, vec3d_t, eulerd_t: quatd_*, vec3d_*). The float functions
+ * use single precision math only, they never promote to double.
+ */
 
-/* convert quaternion to euler angles */
-void quat_to_euler(euler_t *e, const quat_t *q);
+#define REAL float
+#define QUAT_T quat_t
+#define VEC3_T vec3_t
+#define EULER_T euler_t
+#define QFN(name) quat_##name
+#define VFN(name) vec3_##name
+#define QUAT_INIT quaternion_init
+#define NORMALIZE_EULER normalize_euler_0_2pi
+#define IDENTITY_QUAT identity_quat
+#include "quat_tmpl.h"
+#include "quat_tmpl_undef.h"
+
+#define REAL double
+#define QUAT_T quatd_t
+#define VEC3_T vec3d_t
+#define EULER_T eulerd_t
+#define QFN(name) quatd_##name
+#define VFN(name) vec3d_##name
+#define QUAT_INIT quaterniond_init
+#define NORMALIZE_EULER normalize_eulerd_0_2pi
+#define IDENTITY_QUAT identity_quatd
+#include "quat_tmpl.h"
+#include "quat_tmpl_undef.h"
 
-/* normalize angle */
-float normalize_euler_0_2pi(float a);
 
-/* Convert quaternion to right handed rotation matrix. m is a pointer
- * to 16 floats in column major order.
+/*
+ * single precision batch functions
  */
-void quat_to_rh_rot_matrix(const quat_t *q, float *m);
 
-/* Convert quaternion to left handed rotation matrix. m is a pointer
- * to 16 floats in column major order.
+/* rotate n vectors vi via unit quaternion q and put results into vo.
+ * The rotation coefficients are computed once for the whole array;
+ * vo may be equal to vi. Results match quat_rot_vec.
  */
-void quat_to_lh_rot_matrix(const quat_t *q, float *m);
-
-/* initialize vector */
-void vec3_init(vec3_t *vo, float x, float y, float z);
-
-/* vo = v1 + v2 */
-vec3_t *vec3_add(vec3_t *vo, const vec3_t *v1, const vec3_t *v2);
-
-/* v1 = v1 + v2 */
-vec3_t *vec3_add_self(vec3_t *v1, const vec3_t *v2);
-
-/* v1 += [x, y, z] */
-vec3_t *vec3_add_c_self(vec3_t *v1, float x, float y, float z);
-
-/* vo = v1 - v2 */
-vec3_t *vec3_sub(vec3_t *vo, const vec3_t *v1, const vec3_t *v2);
-
-/* v1 = v1 - v2 */
-vec3_t *vec3_sub_self(vec3_t *v1, const vec3_t *v2);
-
-/* v1 -= [x, y, z] */
-vec3_t *vec3_sub_c_self(vec3_t *v1, float x, float y, float z);
+QUAT_API void quat_rot_vec_n(vec3_t *vo, const vec3_t *vi, const quat_t *q, size_t n);
 
-/* vo = vi * scalar */
-vec3_t *vec3_mul(vec3_t *vo, const vec3_t *vi, float scalar);
-
-/* vi *= scalar */
-vec3_t *vec3_mul_self(vec3_t *vi, float scalar);
-
-/* return dot product of v1 and v2 */
-float vec3_dot(const vec3_t *v1, const vec3_t *v2);
-
-/* vo = v1 x v2 (cross product) */ 
-vec3_t *vec3_cross(vec3_t *vo, const vec3_t *v1, const vec3_t *v2);
-
-/* returns square of the magnitude of v */
-float vec3_len2(const vec3_t *v);
+/* same as quat_rot_vec_n, but for vectors stored as separate
+ * x, y and z arrays (structure of arrays); in-place operation is allowed.
+ */
+QUAT_API void quat_rot_vec_soa(float *xo, float *yo, float *zo,
+                               const float *xi, const float *yi, const float *zi,
+                               const quat_t *q, size_t n);
 
-/* vo = normalized vi */
-vec3_t *vec3_normalize(vec3_t *vo, const vec3_t *vi);
+/* array versions of quat_mul, quat_conj, quat_normalize and quat_dot:
+ * process n quaternions at full vector width (see quat_packet.h);
+ * outputs may be equal to inputs. Results match the scalar functions.
+ */
+QUAT_API void quat_mul_n(quat_t *o, const quat_t *q1, const quat_t *q2, size_t n);
+QUAT_API void quat_conj_n(quat_t *qo, const quat_t *qi, size_t n);
+QUAT_API void quat_normalize_n(quat_t *qo, const quat_t *qi, size_t n);
+QUAT_API void quat_dot_n(float *d, const quat_t *q1, const quat_t *q2, size_t n);
+
+/* spherical quaternion interpolation using a polynomial instead of acos/sin.
+ * For unit inputs and t in [0, 1], the interpolation weights are within
+ * 2e-5 of the exact ones and the rotation angle of the result is within
+ * 1.7e-5 rad (0.001 deg) of quat_slerp; the result is not renormalized,
+ * its length is within 3e-5 of 1.
+ */
+QUAT_API quat_t *quat_slerp_fast(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t);
 
-/* vec3 rotate by axis and angle */
-vec3_t *vec3_rot_axis(vec3_t *vo, vec3_t *vi, float x, float y, float z, float angle);
+/* qo[i] = quat_slerp_fast(qfrom[i], qto[i], t[i]) for n quaternions */
+QUAT_API void quat_slerp_fast_n(quat_t *qo, const quat_t *qfrom, const quat_t *qto,
+                                const float *t, size_t n);
 
-/* vec3 rotate self by axis and angle */
-vec3_t *vec3_rot_axis_self(vec3_t *vo, float x, float y, float z, float angle);
 
-/* return distance between v1 and v2 */
-double vec3_dist(const vec3_t *v1, const vec3_t *v2);
+/* array versions of quat_exp, quat_log, quat_pow (qo[i] = q[i]^t[i]) and
+ * quat_integrate (with rates omega[i] and a common dt) using the vector
+ * approximations of quat_vmath_tmpl.h; outputs may be equal to inputs.
+ * Errors match the scalar functions (quat_accuracy): for steps up to
+ * pi rad quat_integrate_n is within 5e-7 rad of the exact rotation and
+ * changes the length of unit q by less than 2e-7.
+ */
+QUAT_API void quat_exp_n(quat_t *qo, const quat_t *q, size_t n);
+QUAT_API void quat_log_n(quat_t *qo, const quat_t *q, size_t n);
+QUAT_API void quat_pow_n(quat_t *qo, const quat_t *q, const float *t, size_t n);
+QUAT_API void quat_integrate_n(quat_t *qo, const quat_t *q, const vec3_t *omega, float dt, size_t n);
 
-/* return distance between v1 and [x, y, z] */
-double vec3_dist_c(const vec3_t *v1, float x, float y, float z);
 
-/* identity quaternion */
-extern const quat_t identity_quat;
+/* quat_decompose_swing_twist and quat_decompose_twist_swing of q[i]
+ * around v1[i] for n quaternions, e.g. the joints of a skeleton; as
+ * accurate as the scalar functions, within 5e-7 rad also for swings near
+ * pi (quat_accuracy)
+ */
+QUAT_API void quat_decompose_swing_twist_n(const quat_t *q, const vec3_t *v1, quat_t *swing,
+                                           quat_t *twist, size_t n);
+QUAT_API void quat_decompose_twist_swing_n(const quat_t *q, const vec3_t *v1, quat_t *twist,
+                                           quat_t *swing, size_t n);
 
-/* see http://gamedev.stackexchange.com/questions/15070/orienting-a-model-to-face-a-target */
-/* Calculate the quaternion to rotate from vector u to vector v */
-void quat_from_u2v(quat_t *q, const vec3_t *u, const vec3_t *v, const vec3_t *up);
 
-/* quaternion dot product q1 . q2 */
-float quat_dot(const quat_t *q1, const quat_t *q2);
+/* q[i] = quat_from_u2v(u[i], v[i], up[i]) and quat_look_at(pos[i],
+ * target[i], up[i]) for n aiming turrets or cameras; up may be NULL for
+ * (0, 1, 0) throughout. Within 5e-7 rad of the scalar functions
+ * (quat_accuracy).
+ */
+QUAT_API void quat_from_u2v_n(quat_t *q, const vec3_t *u, const vec3_t *v, const vec3_t *up, size_t n);
+QUAT_API void quat_look_at_n(quat_t *q, const vec3_t *pos, const vec3_t *target, const vec3_t *up, size_t n);
 
-/* calculate normalized linear quaternion interpolation */
-quat_t *quat_nlerp(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t);
 
-/* calculate spherical quaternion interpolation */
-quat_t *quat_slerp(quat_t *qo, const quat_t *qfrom, const quat_t *qto, float t);
+/* rotation orders of quat_to_euler_n and quat_from_euler_n: the
+ * rotations about the named axes are composed from left to right, e.g.
+ * QUAT_EULER_ZYX is q = Rz(yaw) Ry(pitch) Rx(roll), the convention of
+ * quat_to_euler. The angles always go to the field of their axis: roll
+ * about x, pitch about y, yaw about z.
+ */
+#define QUAT_EULER_ZYX 0
+#define QUAT_EULER_XYZ 1
+#define QUAT_EULER_XZY 2
+#define QUAT_EULER_YXZ 3
+#define QUAT_EULER_YZX 4
+#define QUAT_EULER_ZXY 5
+#define QUAT_EULER_YAW_0_2PI 0x10  /* or'ed to the order: yaw in [0, 2 pi] */
+
+/* convert n unit quaternions to euler angles in the given order, using
+ * branch free vector atan2/sincos approximations (see quat_vmath_tmpl.h).
+ * The first and third angles are in [-pi, pi], the second one in
+ * [-pi/2, pi/2]. In gimbal lock the third angle is derived from the
+ * first one, so the rotation rebuilt from the angles is within 5e-7 rad
+ * of q for all inputs (quat_accuracy checks all orders); quat_to_euler
+ * is off by up to 1 rad there. Returns 0, or -1 without writing e if
+ * order is not one of the above.
+ */
+QUAT_API int quat_to_euler_n(euler_t *e, const quat_t *q, size_t n, unsigned int order);
 
-/* Apply incremental yaw, pitch and roll relative to the quaternion.
- * For example, if the quaternion represents an orientation of a ship,
- * this will apply yaw/pitch/roll *in the ship's local coord system to the
- * orientation.
+/* convert n euler angle triples to quaternions in the given order, using
+ * a vector sincos approximation; for angles up to 16384 rad the result
+ * is within 5e-7 rad of the exact rotation. Returns 0, or -1 without
+ * writing q if order is not one of the above.
  */
-quat_t *quat_apply_relative_yaw_pitch_roll(quat_t *q,
-                                        double yaw, double pitch, double roll);
+QUAT_API int quat_from_euler_n(quat_t *q, const euler_t *e, size_t n, unsigned int order);
+
+
+/* flags of quat_to_matrix_n: one layout, optionally or'ed with the others */
+#define QUAT_MATRIX_3X3       0x00  /* 9 floats, rotation only */
+#define QUAT_MATRIX_3X4       0x01  /* 12 floats, rotation and translation */
+#define QUAT_MATRIX_4X4       0x02  /* 16 floats, last row is (0, 0, 0, 1) */
+#define QUAT_MATRIX_COL_MAJOR 0x04  /* default is row major */
+#define QUAT_MATRIX_LH        0x08  /* transposed rotation, like quat_to_lh_rot_matrix */
+#define QUAT_MATRIX_UNIT      0x10  /* inputs are unit quaternions, skip renormalization */
+
+/* write the rotation matrices of n quaternions q, with translations t
+ * (NULL for none), to m[i * stride ...] in the layout given by flags;
+ * stride is in floats and at least the matrix size. A column major 3x4
+ * matrix is stored as 4 columns of 3 floats. QUAT_MATRIX_4X4 |
+ * QUAT_MATRIX_COL_MAJOR gives bit for bit the result of
+ * quat_to_rh_rot_matrix (or quat_to_lh_rot_matrix with QUAT_MATRIX_LH).
+ */
+QUAT_API void quat_to_matrix_n(float *m, size_t stride, const quat_t *q, const vec3_t *t,
+                               size_t n, unsigned int flags);
+
+/* convert n rotation matrices m[i * stride ...], stored in the layout
+ * given by flags (QUAT_MATRIX_UNIT and translations are ignored), to
+ * quaternions q; results match quat_from_rh_rot_matrix and
+ * quat_from_lh_rot_matrix, the largest component is selected without
+ * branches
+ */
+QUAT_API void quat_from_matrix_n(quat_t *q, const float *m, size_t stride,
+                                 size_t n, unsigned int flags);
+
 
-/* Apply incremental yaw and pitch relative to the quaternion.
- * Yaw is applied to world axis so no roll will accumulate */
-quat_t *quat_apply_relative_yaw_pitch(quat_t *q, double yaw, double pitch);
+#if defined(QUAT_INLINE)
+#include "quat.c"
+#endif
 
-/* decompose a quaternion into a rotation (swing) perpendicular to v1 and a rotation (twist) around v1 */
-void quat_decompose_twist_swing(const quat_t *q, const vec3_t *v1, quat_t *twist, quat_t *swing);
-void quat_decompose_swing_twist(const quat_t *q, const vec3_t *v1, quat_t *swing, quat_t *twist);
 
 #endif /* __QUAT_H__ */
 
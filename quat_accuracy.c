@@ -0,0 +1,1041 @@
+/*
+   quaternion library - accuracy harness
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * usage: quat_accuracy [-n samples]
+ *
+ * Feeds fixed-seed random and near-singular inputs to the float and
+ * double functions and compares the results against a long double
+ * reference. For each function and input class it reports:
+ *
+ *    max/mean angle  rotation angle between result and reference in rad
+ *                    (for quat_rot_vec the angle between the vectors)
+ *    max/mean ulp    largest component error in ulps of the result type,
+ *                    relative to the largest reference component so that
+ *                    components near zero do not dominate; "-" where the
+ *                    reference is not unique
+ *    max norm        largest deviation of the result length from the
+ *                    reference length (relative for vectors)
+ *    ns/op           time per element of the fastest of three passes
+ *
+ * The last section checks replacement candidates (fast and batch
+ * versions) against the function they would replace. A candidate is
+ * safe to ship if it returns no inf/nan and, for every input class, its
+ * max angle error is within its error budget or within the error of the
+ * function it replaces. The exit status is 1 if a candidate is unsafe.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+
+#include "quat.h"
+#include "quat_wire.h"
+#include "quat_store.h"
+#include "quat_avg.h"
+#include "quat_spline.h"
+
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+
+#define N_MAX 65536      /* max samples per input class */
+#define N_TIMING 3       /* timing passes, the fastest is reported */
+#define N_STATS 512
+#define PI_L 3.141592653589793238462643383279503L
+
+
+/* reference quaternion and vector */
+typedef struct
+{
+   long double w, x, y, z;
+}
+refq_t;
+
+typedef struct
+{
+   long double x, y, z;
+}
+refv_t;
+
+
+/* error statistics of one function for one input class */
+typedef struct
+{
+   const char *fn;
+   const char *cls;
+   int n;
+   int nonfinite;
+   int has_ulp;
+   int has_norm;
+   double max_angle, sum_angle;
+   double max_ulp, sum_ulp;
+   double max_norm;
+   double ns;
+}
+stat_t;
+
+
+static stat_t stats[N_STATS];
+static int n_stats = 0;
+static int n_samples = 20000;
+
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+
+/* time one pass of call over n elements, fastest of N_TIMING */
+#define TIME_NS(ns, call, n) \
+   do { \
+      ns = 1.0e30; \
+      FOR_N(r_, N_TIMING) { \
+         double t_ = now(); \
+         call; \
+         t_ = (now() - t_) * 1.0e9 / (n); \
+         if (t_ < ns) \
+            ns = t_; \
+      } \
+   } while (0)
+
+
+/* fixed-seed xorshift generator, uniform in [-1, 1]; every check
+   reseeds, so candidates see the same inputs as their baseline */
+static unsigned int rnd_state;
+
+static void rnd_seed(void)
+{
+   rnd_state = 2463534242u;
+}
+
+static long double rnd(void)
+{
+   rnd_state ^= rnd_state << 13;
+   rnd_state ^= rnd_state >> 17;
+   rnd_state ^= rnd_state << 5;
+   return rnd_state / 2147483647.5L - 1.0L;
+}
+
+
+/* long double reference math */
+
+static long double rv_dot(refv_t a, refv_t b)
+{
+   return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+static long double rv_len(refv_t a)
+{
+   return sqrtl(rv_dot(a, a));
+}
+
+
+static refv_t rv_scale(refv_t a, long double f)
+{
+   refv_t r = { a.x * f, a.y * f, a.z * f };
+   return r;
+}
+
+
+static refv_t rv_normalize(refv_t a)
+{
+   return rv_scale(a, 1.0L / rv_len(a));
+}
+
+
+static refv_t rv_cross(refv_t a, refv_t b)
+{
+   refv_t r = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+   return r;
+}
+
+
+/* angle between two vectors, accurate for small and large angles */
+static long double rv_angle(refv_t a, refv_t b)
+{
+   return atan2l(rv_len(rv_cross(a, b)), rv_dot(a, b));
+}
+
+
+static long double rq_dot(refq_t a, refq_t b)
+{
+   return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+static refq_t rq_scale(refq_t a, long double f)
+{
+   refq_t r = { a.w * f, a.x * f, a.y * f, a.z * f };
+   return r;
+}
+
+
+static refq_t rq_normalize(refq_t a)
+{
+   return rq_scale(a, 1.0L / sqrtl(rq_dot(a, a)));
+}
+
+
+static refq_t rq_conj(refq_t a)
+{
+   refq_t r = { a.w, -a.x, -a.y, -a.z };
+   return r;
+}
+
+
+static refq_t rq_mul(refq_t a, refq_t b)
+{
+   refq_t r =
+   {
+      a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+      a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+      a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+      a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+   };
+   return r;
+}
+
+
+/* rotation by angle a around unit axis v */
+static refq_t rq_axis(refv_t v, long double a)
+{
+   long double s = sinl(a * 0.5L);
+   refq_t r = { cosl(a * 0.5L), v.x * s, v.y * s, v.z * s };
+   return r;
+}
+
+
+/* rotate v by q, q is normalized first */
+static refv_t rv_rot(refv_t v, refq_t q)
+{
+   refq_t p = { 0.0L, v.x, v.y, v.z };
+   q = rq_normalize(q);
+   p = rq_mul(rq_mul(q, p), rq_conj(q));
+   refv_t r = { p.x, p.y, p.z };
+   return r;
+}
+
+
+/* angle of the rotation between a and b (q and -q are the same rotation) */
+static long double rq_angle(refq_t a, refq_t b)
+{
+   a = rq_normalize(a);
+   b = rq_normalize(b);
+   if (rq_dot(a, b) < 0.0L)
+      b = rq_scale(b, -1.0L);
+   long double dw = a.w - b.w, dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+   long double d = sqrtl(dw * dw + dx * dx + dy * dy + dz * dz) * 0.5L;
+   return 4.0L * asinl(d > 1.0L ? 1.0L : d);   /* keeps nan */
+}
+
+
+/* shortest rotation from u to v, not unique for antiparallel u, v */
+static refq_t rq_u2v(refv_t u, refv_t v)
+{
+   u = rv_normalize(u);
+   v = rv_normalize(v);
+   refv_t c = rv_cross(u, v);
+   refq_t r = { 1.0L + rv_dot(u, v), c.x, c.y, c.z };
+   return rq_normalize(r);
+}
+
+
+static refq_t rq_slerp(refq_t a, refq_t b, long double t)
+{
+   a = rq_normalize(a);
+   b = rq_normalize(b);
+   if (rq_dot(a, b) < 0.0L)
+      b = rq_scale(b, -1.0L);
+   long double om = rq_angle(a, b) * 0.5L;
+   if (om == 0.0L)
+      return a;
+   long double s0 = sinl((1.0L - t) * om) / sinl(om);
+   long double s1 = sinl(t * om) / sinl(om);
+   refq_t r = { s0 * a.w + s1 * b.w, s0 * a.x + s1 * b.x, s0 * a.y + s1 * b.y, s0 * a.z + s1 * b.z };
+   return r;
+}
+
+
+/* q = yaw around z * pitch around y * roll around x, the convention of quat_to_euler */
+static refq_t rq_euler(long double yaw, long double pitch, long double roll)
+{
+   refv_t ex = { 1.0L, 0.0L, 0.0L }, ey = { 0.0L, 1.0L, 0.0L }, ez = { 0.0L, 0.0L, 1.0L };
+   return rq_mul(rq_mul(rq_axis(ez, yaw), rq_axis(ey, pitch)), rq_axis(ex, roll));
+}
+
+
+static refq_t rq_exp(refq_t q)
+{
+   long double t = sqrtl(q.x * q.x + q.y * q.y + q.z * q.z), e = expl(q.w);
+   long double s = t > 0.0L ? e * sinl(t) / t : e;
+   refq_t r = { e * cosl(t), s * q.x, s * q.y, s * q.z };
+   return r;
+}
+
+
+static refq_t rq_log(refq_t q)
+{
+   long double s = sqrtl(q.x * q.x + q.y * q.y + q.z * q.z);
+   long double f = s > 0.0L ? atan2l(s, q.w) / s : 0.0L;
+   refq_t r = { logl(sqrtl(rq_dot(q, q))), f * q.x, f * q.y, f * q.z };
+   return r;
+}
+
+
+static void rq_to_euler(refq_t q, long double *yaw, long double *pitch, long double *roll)
+{
+   long double s;
+   q = rq_normalize(q);
+   *yaw = atan2l(2.0L * (q.x * q.y + q.z * q.w), q.x * q.x - q.y * q.y - q.z * q.z + q.w * q.w);
+   if (*yaw < 0.0L)
+      *yaw += 2.0L * PI_L;
+   s = -2.0L * (q.x * q.z - q.y * q.w);
+   *pitch = asinl(s > 1.0L ? 1.0L : (s < -1.0L ? -1.0L : s));
+   *roll = atan2l(2.0L * (q.y * q.z + q.x * q.w), -q.x * q.x - q.y * q.y + q.z * q.z + q.w * q.w);
+}
+
+
+/* random inputs */
+
+static refv_t rv_random(void)
+{
+   refv_t v;
+   do {
+      v.x = rnd();
+      v.y = rnd();
+      v.z = rnd();
+   } while (rv_dot(v, v) > 1.0L || rv_dot(v, v) < 1.0e-4L);
+   return rv_normalize(v);
+}
+
+
+/* random unit vector perpendicular to unit vector u */
+static refv_t rv_random_perp(refv_t u)
+{
+   refv_t p;
+   do {
+      p = rv_cross(u, rv_random());
+   } while (rv_dot(p, p) < 1.0e-4L);
+   return rv_normalize(p);
+}
+
+
+static refq_t rq_random(void)
+{
+   refq_t q;
+   do {
+      q.w = rnd();
+      q.x = rnd();
+      q.y = rnd();
+      q.z = rnd();
+   } while (rq_dot(q, q) > 1.0L || rq_dot(q, q) < 1.0e-4L);
+   return rq_normalize(q);
+}
+
+
+/* log-uniform in [1e-7, 1e-1] */
+static long double small_angle(void)
+{
+   return powl(10.0L, -4.0L + 3.0L * rnd());
+}
+
+
+/* statistics */
+
+static stat_t *stat_new(const char *fn, const char *cls, double ns)
+{
+   if (n_stats == N_STATS) {
+      fprintf(stderr, "too many statistics\n");
+      exit(EXIT_FAILURE);
+   }
+   stat_t *st = &stats[n_stats++];
+   memset(st, 0, sizeof(*st));
+   st->fn = fn;
+   st->cls = cls;
+   st->ns = ns;
+   return st;
+}
+
+
+/* ulp < 0: reference not unique, norm < 0: not applicable */
+static void stat_add(stat_t *st, long double angle, long double ulp, long double norm)
+{
+   st->n++;
+   if (!isfinite(angle) || !isfinite(ulp) || !isfinite(norm)) {
+      st->nonfinite++;
+      return;
+   }
+   if (angle > st->max_angle)
+      st->max_angle = angle;
+   st->sum_angle += angle;
+   if (ulp >= 0.0L) {
+      st->has_ulp = 1;
+      if (ulp > st->max_ulp)
+         st->max_ulp = ulp;
+      st->sum_ulp += ulp;
+   }
+   if (norm >= 0.0L) {
+      st->has_norm = 1;
+      if (norm > st->max_norm)
+         st->max_norm = norm;
+   }
+}
+
+
+/* error of out[k] in ulps of a type with mant mantissa bits,
+   relative to the largest component of ref[k] */
+static long double ulp_err(const long double *out, const long double *ref, int k, int mant)
+{
+   long double scale = 0.0L, err = 0.0L;
+   FOR_N(i, k)
+      if (fabsl(ref[i]) > scale)
+         scale = fabsl(ref[i]);
+   if (scale == 0.0L)
+      scale = 1.0L;
+   FOR_N(i, k)
+      if (fabsl(out[i] - ref[i]) > err)
+         err = fabsl(out[i] - ref[i]);
+   return err / ldexpl(1.0L, ilogbl(scale) - mant + 1);
+}
+
+
+static long double ulp_q(refq_t out, refq_t ref, int mant)
+{
+   if (rq_dot(out, ref) < 0.0L)
+      ref = rq_scale(ref, -1.0L);
+   long double o[4] = { out.w, out.x, out.y, out.z };
+   long double r[4] = { ref.w, ref.x, ref.y, ref.z };
+   return ulp_err(o, r, 4, mant);
+}
+
+
+static long double norm_q(refq_t out)
+{
+   return fabsl(sqrtl(rq_dot(out, out)) - 1.0L);
+}
+
+
+/* generic checks, once per scalar type */
+
+#define REAL float
+#define QUAT_T quat_t
+#define VEC3_T vec3_t
+#define EULER_T euler_t
+#define QFN(name) quat_##name
+#define VFN(name) vec3_##name
+#define A(name) f_##name
+#define MANT FLT_MANT_DIG
+#include "quat_accuracy_tmpl.c"
+#include "quat_tmpl_undef.h"
+#undef A
+#undef MANT
+
+#define REAL double
+#define QUAT_T quatd_t
+#define VEC3_T vec3d_t
+#define EULER_T eulerd_t
+#define QFN(name) quatd_##name
+#define VFN(name) vec3d_##name
+#define A(name) d_##name
+#define MANT DBL_MANT_DIG
+#include "quat_accuracy_tmpl.c"
+#include "quat_tmpl_undef.h"
+#undef A
+#undef MANT
+
+
+/* replacement candidates */
+
+static void slerp_fast_loop(quat_t *qo, const quat_t *qfrom, const quat_t *qto, const float *t, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      quat_slerp_fast(&qo[i], &qfrom[i], &qto[i], t[i]);
+}
+
+
+static void from_matrix_n(quat_t *q, const float *m, size_t n)
+{
+   quat_from_matrix_n(q, m, 16, n, QUAT_MATRIX_4X4 | QUAT_MATRIX_COL_MAJOR);
+}
+
+
+static void exp_n(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega, float dt, size_t n)
+{
+   quat_exp_n(qo, q, n);
+}
+
+
+static void log_n(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega, float dt, size_t n)
+{
+   quat_log_n(qo, q, n);
+}
+
+
+static void pow_n(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega, float dt, size_t n)
+{
+   quat_pow_n(qo, q, t, n);
+}
+
+
+static void integrate_n(quat_t *qo, const quat_t *q, const float *t, const vec3_t *omega, float dt, size_t n)
+{
+   quat_integrate_n(qo, q, omega, dt, n);
+}
+
+
+/* encode and decode round trips of the wire formats */
+typedef void (*wire_fn)(quat_t *qo, const quat_t *qi, size_t n);
+
+static void wire32(quat_t *qo, const quat_t *qi, size_t n)
+{
+   static quat_wire32_t c[N_MAX];
+   quat_wire_encode32_n(c, qi, n);
+   quat_wire_decode32_n(qo, c, n);
+}
+
+
+static void wire48(quat_t *qo, const quat_t *qi, size_t n)
+{
+   static quat_wire48_t c[N_MAX];
+   quat_wire_encode48_n(c, qi, n);
+   quat_wire_decode48_n(qo, c, n);
+}
+
+
+static void wire64(quat_t *qo, const quat_t *qi, size_t n)
+{
+   static quat_wire64_t c[N_MAX];
+   quat_wire_encode64_n(c, qi, n);
+   quat_wire_decode64_n(qo, c, n);
+}
+
+
+/* random, near identity and near 90 degrees, where the largest
+   component is close to 1/sqrt(2) and may tie with another one;
+   the reference is the float input */
+static void check_wire(const char *name, wire_fn fn)
+{
+   static const char *cls[] = { "random", "angle~0", "angle~pi/2" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refq_t q;
+         if (c == 0)
+            q = rq_random();
+         else
+            q = rq_axis(rv_random(), c == 1 ? small_angle() : PI_L * 0.5L + small_angle() * rnd());
+         f_put_q(&f_qa[i], q);
+      }
+      TIME_NS(ns, fn(f_qo, f_qa, n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t out = f_get_q(&f_qo[i]);
+         stat_add(st, rq_angle(out, f_get_q(&f_qa[i])), -1.0L, norm_q(out));
+      }
+   }
+}
+
+
+/* q = R_i(a) R_j(b) R_k(c) for the axes i, j, k of order, the angle of
+   axis x, y, z is e[2], e[1], e[0] as in euler_t */
+static const int euler_axes[6][3] =
+{
+   { 2, 1, 0 }, { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }
+};
+
+static const char *euler_names[6] = { "ZYX", "XYZ", "XZY", "YXZ", "YZX", "ZXY" };
+
+
+static refq_t rq_euler_order(unsigned int order, const long double *e)
+{
+   static const refv_t axes[3] = { { 1.0L, 0.0L, 0.0L }, { 0.0L, 1.0L, 0.0L }, { 0.0L, 0.0L, 1.0L } };
+   refq_t q = { 1.0L, 0.0L, 0.0L, 0.0L };
+   FOR_N(l, 3) {
+      int a = euler_axes[order][l];
+      q = rq_mul(q, rq_axis(axes[a], e[2 - a]));
+   }
+   return q;
+}
+
+
+/* quat_to_euler_n in all orders: random orientations and the middle
+   angle near +-90 degrees (gimbal lock), measured on the rotation
+   rebuilt from the angles; with the names of the quat_to_euler classes */
+static void check_to_euler_n(void)
+{
+   static const char *cls[] = { "random", "pitch~90deg" };
+   static char names[6][32];
+   double ns;
+
+   FOR_N(o, 6) {
+      snprintf(names[o], sizeof(names[o]), "quat_to_euler_n %s", euler_names[o]);
+      rnd_seed();
+      FOR_N(c, 2) {
+         FOR_N(i, n_samples) {
+            refq_t q;
+            if (c == 0) {
+               q = rq_random();
+            } else {
+               long double e[3], mid = PI_L * 0.5L - small_angle();
+               e[0] = PI_L * rnd();
+               e[1] = PI_L * rnd();
+               e[2] = PI_L * rnd();
+               e[2 - euler_axes[o][1]] = rnd() < 0.0L ? -mid : mid;
+               q = rq_euler_order(o, e);
+            }
+            f_put_q(&f_qa[i], q);
+         }
+         TIME_NS(ns, quat_to_euler_n(f_eo, f_qa, n_samples, o), n_samples);
+         stat_t *st = stat_new(names[o], cls[c], ns);
+         FOR_N(i, n_samples) {
+            long double e[3];
+            FOR_N(j, 3)
+               e[j] = (long double)f_eo[i].vec[j];
+            stat_add(st, rq_angle(rq_euler_order(o, e), f_get_q(&f_qa[i])), -1.0L, -1.0L);
+         }
+      }
+   }
+}
+
+
+/* quat_from_euler_n in all orders, inputs as for quat_from_euler */
+static void check_from_euler_n(void)
+{
+   static const char *cls[] = { "random", "angles~16384" };
+   static char names[6][32];
+   double ns;
+
+   FOR_N(o, 6) {
+      snprintf(names[o], sizeof(names[o]), "quat_from_euler_n %s", euler_names[o]);
+      rnd_seed();
+      FOR_N(c, 2) {
+         long double range = c == 0 ? PI_L : 16384.0L;
+         FOR_N(i, n_samples)
+            FOR_N(j, 3)
+               f_eo[i].vec[j] = (float)(range * rnd());
+         TIME_NS(ns, quat_from_euler_n(f_qo, f_eo, n_samples, o), n_samples);
+         stat_t *st = stat_new(names[o], cls[c], ns);
+         FOR_N(i, n_samples) {
+            long double e[3];
+            FOR_N(j, 3)
+               e[j] = (long double)f_eo[i].vec[j];
+            refq_t out = f_get_q(&f_qo[i]), ref = rq_euler_order(o, e);
+            if (rq_dot(out, ref) < 0.0L)
+               ref = rq_scale(ref, -1.0L);
+            stat_add(st, rq_angle(out, ref), ulp_q(out, ref, FLT_MANT_DIG), norm_q(out));
+         }
+      }
+   }
+}
+
+
+/* quat_store steering against the scalar functions on the same inputs:
+   angles in [-pi, pi] and small per tick angles; with_roll = 0 checks the
+   yaw/pitch version */
+static void check_store(const char *name, int with_roll)
+{
+   static const char *cls[] = { "random", "angles~0" };
+   static float storage[QUAT_STORE_FLOATS(N_MAX)], ang[3][N_MAX];
+   quat_store_t s;
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 2) {
+      FOR_N(i, n_samples) {
+         f_put_q(&f_qa[i], rq_random());
+         FOR_N(j, 3)
+            ang[j][i] = (float)(c == 0 ? PI_L * rnd() : small_angle() * rnd());
+      }
+      quat_store_init(&s, storage, n_samples, f_qa);
+      if (with_roll)
+         TIME_NS(ns, quat_store_apply_relative_yaw_pitch_roll(NULL, &s, ang[0], ang[1], ang[2]), n_samples);
+      else
+         TIME_NS(ns, quat_store_apply_relative_yaw_pitch(NULL, &s, ang[0], ang[1]), n_samples);
+      /* the timing passes steer repeatedly, so steer once more from q */
+      quat_store_init(&s, storage, n_samples, f_qa);
+      if (with_roll)
+         quat_store_apply_relative_yaw_pitch_roll(NULL, &s, ang[0], ang[1], ang[2]);
+      else
+         quat_store_apply_relative_yaw_pitch(NULL, &s, ang[0], ang[1]);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         quat_t q = f_qa[i], out;
+         if (with_roll)
+            quat_apply_relative_yaw_pitch_roll(&q, ang[0][i], ang[1][i], ang[2][i]);
+         else
+            quat_apply_relative_yaw_pitch(&q, ang[0][i], ang[1][i]);
+         quat_store_get(&s, i, &out);
+         stat_add(st, rq_angle(f_get_q(&out), f_get_q(&q)), -1.0L, norm_q(f_get_q(&out)));
+      }
+   }
+}
+
+
+/* slerp without the shortest path correction, as inside squad */
+static refq_t rq_slerp_direct(refq_t a, refq_t b, long double t)
+{
+   long double d = 0.0L, e = 0.0L;
+   long double av[4] = { a.w, a.x, a.y, a.z }, bv[4] = { b.w, b.x, b.y, b.z };
+   FOR_N(c, 4) {
+      d += (av[c] - bv[c]) * (av[c] - bv[c]);
+      e += (av[c] + bv[c]) * (av[c] + bv[c]);
+   }
+   long double om = 2.0L * atan2l(sqrtl(d), sqrtl(e));
+   if (om == 0.0L)
+      return a;
+   long double s0 = sinl((1.0L - t) * om) / sinl(om), s1 = sinl(t * om) / sinl(om);
+   refq_t r = { s0 * a.w + s1 * b.w, s0 * a.x + s1 * b.x, s0 * a.y + s1 * b.y, s0 * a.z + s1 * b.z };
+   return r;
+}
+
+
+/* inner control point of key i of n */
+static refq_t rq_squad_ctrl(const quat_key_t *k, int n, int i)
+{
+   refq_t q = f_get_q(&k[i].q), sum = { 0.0L, 0.0L, 0.0L, 0.0L };
+   if (i == 0 || i == n - 1)
+      return q;
+   for (int j = i - 1; j <= i + 1; j += 2) {
+      refq_t r = rq_mul(rq_conj(q), f_get_q(&k[j].q));
+      if (r.w < 0.0L)
+         r = rq_scale(r, -1.0L);
+      r = rq_log(r);
+      sum.w += r.w;
+      sum.x += r.x;
+      sum.y += r.y;
+      sum.z += r.z;
+   }
+   return rq_mul(q, rq_exp(rq_scale(sum, -0.25L)));
+}
+
+
+/* squad through keys k[0 .. n - 1] at time t inside their range */
+static refq_t rq_squad(const quat_key_t *k, int n, long double t)
+{
+   int i = 0;
+   while (i < n - 2 && t >= k[i + 1].t)
+      i++;
+   long double u = (t - k[i].t) / ((long double)k[i + 1].t - k[i].t);
+   refq_t a = f_get_q(&k[i].q), b = f_get_q(&k[i + 1].q);
+   refq_t sa = rq_squad_ctrl(k, n, i), sb = rq_squad_ctrl(k, n, i + 1);
+   if (quat_dot(&k[i].q, &k[i + 1].q) < 0.0f) {
+      b = rq_scale(b, -1.0L);
+      sb = rq_scale(sb, -1.0L);
+   }
+   return rq_slerp_direct(rq_slerp_direct(a, b, u), rq_slerp_direct(sa, sb, u), 2.0L * u * (1.0L - u));
+}
+
+
+/* quat_spline_eval and quat_spline_eval_n at random times on random
+   walks of N_SPLINE_KEYS keys with steps up to 1.5 rad and small steps */
+#define N_SPLINE_KEYS 64
+
+static void check_spline(void)
+{
+   static const char *cls[] = { "random", "steps~0" };
+   static quat_key_t k[N_SPLINE_KEYS];
+   static quat_spline_seg_t segs[N_SPLINE_KEYS];
+   static float t[N_MAX];
+   quat_spline_t sp;
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 2) {
+      refq_t q = rq_random();
+      k[0].t = 0.0f;
+      FOR_N(i, N_SPLINE_KEYS) {
+         if (i > 0) {
+            k[i].t = k[i - 1].t + (float)(1.0L + 0.5L * rnd());
+            q = rq_normalize(rq_mul(q, rq_axis(rv_random(), c == 0 ? 1.5L * rnd() : small_angle())));
+         }
+         f_put_q(&k[i].q, q);
+      }
+      quat_spline_init(&sp, segs, k, N_SPLINE_KEYS);
+      FOR_N(i, n_samples)
+         t[i] = (float)((0.5L + 0.5L * rnd()) * k[N_SPLINE_KEYS - 1].t);
+      FOR_N(batch, 2) {
+         if (batch)
+            TIME_NS(ns, quat_spline_eval_n(&sp, f_qo, t, n_samples), n_samples);
+         else
+            TIME_NS(ns, FOR_N(i, n_samples) quat_spline_eval(&sp, &f_qo[i], t[i]), n_samples);
+         stat_t *st = stat_new(batch ? "quat_spline_eval_n" : "quat_spline_eval", cls[c], ns);
+         FOR_N(i, n_samples)
+            stat_add(st, rq_angle(f_get_q(&f_qo[i]), rq_squad(k, N_SPLINE_KEYS, t[i])), -1.0L,
+                     norm_q(f_get_q(&f_qo[i])));
+      }
+   }
+}
+
+
+/* dominant eigenvector of the symmetric 4x4 matrix m by cyclic Jacobi
+   rotations, the reference for the averager */
+static refq_t rq_eigen_max(long double m[4][4])
+{
+   long double v[4][4] = { { 1.0L }, { 0.0L, 1.0L }, { 0.0L, 0.0L, 1.0L }, { 0.0L, 0.0L, 0.0L, 1.0L } };
+   FOR_N(sweep, 50) {
+      long double off = 0.0L;
+      FOR_N(i, 4)
+         for (int j = i + 1; j < 4; j++)
+            off += m[i][j] * m[i][j];
+      if (off < 1.0e-60L)
+         break;
+      FOR_N(p, 4)
+         for (int q = p + 1; q < 4; q++) {
+            if (m[p][q] == 0.0L)
+               continue;
+            long double th = (m[q][q] - m[p][p]) / (2.0L * m[p][q]);
+            long double t = (th >= 0.0L ? 1.0L : -1.0L) / (fabsl(th) + sqrtl(th * th + 1.0L));
+            long double c = 1.0L / sqrtl(t * t + 1.0L), s = t * c;
+            FOR_N(k, 4) {
+               long double a = m[k][p], b = m[k][q];
+               m[k][p] = c * a - s * b;
+               m[k][q] = s * a + c * b;
+            }
+            FOR_N(k, 4) {
+               long double a = m[p][k], b = m[q][k];
+               m[p][k] = c * a - s * b;
+               m[q][k] = s * a + c * b;
+            }
+            FOR_N(k, 4) {
+               long double a = v[k][p], b = v[k][q];
+               v[k][p] = c * a - s * b;
+               v[k][q] = s * a + c * b;
+            }
+         }
+   }
+   int best = 0;
+   FOR_N(i, 4)
+      if (m[i][i] > m[best][best])
+         best = i;
+   refq_t q = { v[0][best], v[1][best], v[2][best], v[3][best] };
+   return rq_normalize(q);
+}
+
+
+/* quat_avg on sets of N_AVG weighted samples: noise around a random
+   center, the same with random signs, and uniformly random orientations
+   (close eigenvalues), against the eigenvector of the long double M */
+#define N_AVG 64
+
+static void check_avg(void)
+{
+   static const char *cls[] = { "clustered", "sign flips", "spread" };
+   static float w[N_MAX];
+   int sets = n_samples / N_AVG > 0 ? n_samples / N_AVG : 1;
+   int n = sets * N_AVG;
+   double ns;
+
+   if (n > N_MAX)
+      n = N_MAX, sets = n / N_AVG;
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(k, sets) {
+         refq_t center = rq_random();
+         FOR_N(i, N_AVG) {
+            refq_t q = c == 2 ? rq_random() : rq_mul(center, rq_axis(rv_random(), 0.3L * rnd()));
+            if (c == 1 && rnd() < 0.0L)
+               q = rq_scale(q, -1.0L);
+            f_put_q(&f_qa[k * N_AVG + i], q);
+            w[k * N_AVG + i] = (float)(1.0L + rnd());
+         }
+      }
+      quat_avg_t a;
+      TIME_NS(ns, FOR_N(k, sets) {
+         quat_avg_init(&a);
+         quat_avg_add_n(&a, &f_qa[k * N_AVG], &w[k * N_AVG], N_AVG);
+         quat_avg_get(&a, &f_qo[k]);
+      }, n);
+      stat_t *st = stat_new("quat_avg", cls[c], ns);
+      FOR_N(k, sets) {
+         long double m[4][4] = { { 0.0L } };
+         FOR_N(i, N_AVG) {
+            refq_t q = f_get_q(&f_qa[k * N_AVG + i]);
+            long double v[4] = { q.w, q.x, q.y, q.z };
+            FOR_N(r, 4)
+               FOR_N(s, 4)
+                  m[r][s] += w[k * N_AVG + i] * v[r] * v[s];
+         }
+         stat_add(st, rq_angle(f_get_q(&f_qo[k]), rq_eigen_max(m)), -1.0L, norm_q(f_get_q(&f_qo[k])));
+      }
+   }
+}
+
+
+typedef struct
+{
+   const char *candidate;
+   const char *baseline;
+   double budget;        /* max angle error in rad that is acceptable anyway */
+}
+candidate_t;
+
+
+static const candidate_t candidates[] =
+{
+   { "quat_slerp_fast", "quat_slerp", 2.0e-5 },
+   { "quat_slerp_fast_n", "quat_slerp", 2.0e-5 },
+   { "quat_from_matrix_n", "quat_from_rh_rot_matrix", 0.0 },
+   { "quat_wire 32 bit", "quat_t", 4.8e-3 },
+   { "quat_wire 48 bit", "quat_t", 1.5e-4 },
+   { "quat_wire 64 bit", "quat_t", 4.7e-6 },
+   { "quat_exp_n", "quat_exp", 5.0e-7 },
+   { "quat_log_n", "quat_log", 2.0e-6 },
+   { "quat_pow_n", "quat_pow", 4.0e-6 },
+   { "quat_integrate_n", "quat_integrate", 5.0e-7 },
+   { "quat_decompose_swing_twist_n", "quat_decompose_swing_twist", 1.0e-6 },
+   { "quat_decompose_twist_swing_n", "quat_decompose_twist_swing", 1.0e-6 },
+   { "quat_from_u2v_n", "quat_from_u2v", 1.0e-6 },
+   { "quat_look_at_n", "quat_look_at", 1.0e-6 },
+   { "quat_store yaw/pitch/roll", "scalar", 1.0e-6 },
+   { "quat_store yaw/pitch", "scalar", 1.0e-6 },
+   { "quat_avg", "Jacobi eigenvector", 1.0e-6 },
+   { "quat_spline_eval_n", "quat_spline_eval", 1.0e-6 },
+   { "quat_to_euler_n ZYX", "quat_to_euler", 5.0e-7 },
+   { "quat_to_euler_n XYZ", "quat_to_euler", 5.0e-7 },
+   { "quat_to_euler_n XZY", "quat_to_euler", 5.0e-7 },
+   { "quat_to_euler_n YXZ", "quat_to_euler", 5.0e-7 },
+   { "quat_to_euler_n YZX", "quat_to_euler", 5.0e-7 },
+   { "quat_to_euler_n ZXY", "quat_to_euler", 5.0e-7 },
+   { "quat_from_euler_n ZYX", "quat_from_euler", 5.0e-7 },
+   { "quat_from_euler_n XYZ", "quat_from_euler", 5.0e-7 },
+   { "quat_from_euler_n XZY", "quat_from_euler", 5.0e-7 },
+   { "quat_from_euler_n YXZ", "quat_from_euler", 5.0e-7 },
+   { "quat_from_euler_n YZX", "quat_from_euler", 5.0e-7 },
+   { "quat_from_euler_n ZXY", "quat_from_euler", 5.0e-7 },
+   { NULL, NULL, 0.0 }
+};
+
+
+static const stat_t *stat_find(const char *fn, const char *cls)
+{
+   FOR_N(i, n_stats)
+      if (!strcmp(stats[i].fn, fn) && !strcmp(stats[i].cls, cls))
+         return &stats[i];
+   return NULL;
+}
+
+
+static void print_stats(void)
+{
+   printf("%-34s %-14s %6s %10s %10s %10s %10s %10s %8s %7s\n", "function", "inputs", "n",
+          "max angle", "mean angle", "max ulp", "mean ulp", "max norm", "inf/nan", "ns/op");
+   FOR_N(i, n_stats) {
+      const stat_t *st = &stats[i];
+      int n = st->n - st->nonfinite;
+      printf("%-34s %-14s %6d %10.3g %10.3g ", st->fn, st->cls, st->n,
+             st->max_angle, n ? st->sum_angle / n : 0.0);
+      if (st->has_ulp)
+         printf("%10.3g %10.3g ", st->max_ulp, n ? st->sum_ulp / n : 0.0);
+      else
+         printf("%10s %10s ", "-", "-");
+      if (st->has_norm)
+         printf("%10.3g ", st->max_norm);
+      else
+         printf("%10s ", "-");
+      printf("%8d %7.2f\n", st->nonfinite, st->ns);
+   }
+}
+
+
+/* returns the number of unsafe candidates */
+static int print_verdicts(void)
+{
+   int unsafe = 0;
+
+   printf("\nreplacement candidates:\n");
+   for (const candidate_t *c = candidates; c->candidate; c++) {
+      int ok = 1;
+      double ns = 0.0, base_ns = 0.0;
+      printf("%s in place of %s (budget %.3g rad):\n", c->candidate, c->baseline, c->budget);
+      FOR_N(i, n_stats) {
+         const stat_t *st = &stats[i];
+         if (strcmp(st->fn, c->candidate))
+            continue;
+         const stat_t *base = stat_find(c->baseline, st->cls);
+         double allowed = c->budget;
+         if (base && base->max_angle > allowed)
+            allowed = base->max_angle;
+         int cls_ok = !st->nonfinite && st->max_angle <= allowed;
+         printf("   %-14s max angle %10.3g, baseline %10.3g: %s\n", st->cls, st->max_angle,
+                base ? base->max_angle : 0.0, cls_ok ? "ok" : "TOO LARGE");
+         ok &= cls_ok;
+         ns += st->ns;
+         base_ns += base ? base->ns : 0.0;
+      }
+      if (base_ns > 0.0)
+         printf("   speedup %.2fx: %s\n", ns > 0.0 ? base_ns / ns : 0.0, ok ? "safe" : "NOT SAFE");
+      else
+         printf("   %s\n", ok ? "safe" : "NOT SAFE");
+      unsafe += !ok;
+   }
+   return unsafe;
+}
+
+
+int main(int argc, char *argv[])
+{
+   if (argc == 3 && !strcmp(argv[1], "-n"))
+      n_samples = atoi(argv[2]);
+   else if (argc != 1)
+      n_samples = 0;
+   if (n_samples <= 0 || n_samples > N_MAX) {
+      fprintf(stderr, "usage: %s [-n samples], samples in [1, %d]\n", argv[0], N_MAX);
+      return EXIT_FAILURE;
+   }
+
+   f_check_all();
+   d_check_all();
+   f_check_slerp("quat_slerp_fast", slerp_fast_loop);
+   f_check_slerp("quat_slerp_fast_n", quat_slerp_fast_n);
+   f_check_from_matrix("quat_from_matrix_n", from_matrix_n);
+   f_check_expmap("quat_exp_n", exp_n, 0);
+   f_check_expmap("quat_log_n", log_n, 1);
+   f_check_expmap("quat_pow_n", pow_n, 2);
+   f_check_expmap("quat_integrate_n", integrate_n, 3);
+   f_check_decompose("quat_decompose_swing_twist_n", quat_decompose_swing_twist_n, 1);
+   f_check_decompose("quat_decompose_twist_swing_n", quat_decompose_twist_swing_n, 0);
+   f_check_from_u2v("quat_from_u2v_n", quat_from_u2v_n);
+   f_check_look_at("quat_look_at_n", quat_look_at_n);
+   check_wire("quat_wire 32 bit", wire32);
+   check_wire("quat_wire 48 bit", wire48);
+   check_wire("quat_wire 64 bit", wire64);
+   check_store("quat_store yaw/pitch/roll", 1);
+   check_store("quat_store yaw/pitch", 0);
+   check_avg();
+   check_spline();
+   check_to_euler_n();
+   check_from_euler_n();
+
+   print_stats();
+   return print_verdicts() ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,548 @@
+/*
+   quaternion library - generic accuracy checks
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * Included by quat_accuracy.c once per scalar type with the macros from
+ * quat_tmpl.h plus:
+ *
+ *    A(name)         name of a check function or input array
+ *    MANT            mantissa bits of REAL
+ *
+ * Functions are checked through batch signatures, so fast and batch
+ * candidates can be checked on exactly the same inputs as the scalar
+ * function they would replace.
+ */
+
+
+static QUAT_T A(qa)[N_MAX], A(qb)[N_MAX], A(qo)[N_MAX], A(qp)[N_MAX];
+static VEC3_T A(va)[N_MAX], A(vb)[N_MAX], A(vc)[N_MAX], A(vo)[N_MAX];
+static EULER_T A(eo)[N_MAX];
+static REAL A(ta)[N_MAX], A(fo)[N_MAX];
+static REAL A(ma)[N_MAX * 16];
+
+
+static void A(put_q)(QUAT_T *q, refq_t r)
+{
+   q->w = (REAL)r.w;
+   q->x = (REAL)r.x;
+   q->y = (REAL)r.y;
+   q->z = (REAL)r.z;
+}
+
+
+static refq_t A(get_q)(const QUAT_T *q)
+{
+   refq_t r = { (long double)q->w, (long double)q->x, (long double)q->y, (long double)q->z };
+   return r;
+}
+
+
+static void A(put_v)(VEC3_T *v, refv_t r)
+{
+   v->x = (REAL)r.x;
+   v->y = (REAL)r.y;
+   v->z = (REAL)r.z;
+}
+
+
+static refv_t A(get_v)(const VEC3_T *v)
+{
+   refv_t r = { (long double)v->x, (long double)v->y, (long double)v->z };
+   return r;
+}
+
+
+/* slerp: random pairs and pairs with cosom near +1 and -1 */
+
+typedef void (*A(slerp_fn))(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, const REAL *t, size_t n);
+
+static void A(slerp_loop)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, const REAL *t, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(slerp)(&qo[i], &qfrom[i], &qto[i], t[i]);
+}
+
+
+static void A(check_slerp)(const char *name, A(slerp_fn) fn)
+{
+   static const char *cls[] = { "random", "cosom~+1", "cosom~-1" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refq_t a = rq_random(), b;
+         if (c == 0) {
+            b = rq_random();
+         } else {
+            b = rq_mul(a, rq_axis(rv_random(), small_angle()));
+            if (c == 2)
+               b = rq_scale(b, -1.0L);
+         }
+         A(put_q)(&A(qa)[i], a);
+         A(put_q)(&A(qb)[i], b);
+         A(ta)[i] = (REAL)((rnd() + 1.0L) * 0.5L);
+      }
+      TIME_NS(ns, fn(A(qo), A(qa), A(qb), A(ta), n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t out = A(get_q)(&A(qo)[i]);
+         refq_t ref = rq_slerp(A(get_q)(&A(qa)[i]), A(get_q)(&A(qb)[i]), (long double)A(ta)[i]);
+         stat_add(st, rq_angle(out, ref), ulp_q(out, ref, MANT), norm_q(out));
+      }
+   }
+}
+
+
+/* to_euler: random orientations and pitch near +-90 degrees (gimbal lock);
+   the angle error is measured on the rotation rebuilt from the result,
+   the ulp error on the angles themselves */
+static void A(check_to_euler)(void)
+{
+   static const char *cls[] = { "random", "pitch~90deg" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 2) {
+      FOR_N(i, n_samples) {
+         refq_t q;
+         if (c == 0) {
+            q = rq_random();
+         } else {
+            long double pitch = PI_L * 0.5L - small_angle();
+            q = rq_euler(PI_L * rnd(), rnd() < 0.0L ? -pitch : pitch, PI_L * rnd());
+         }
+         A(put_q)(&A(qa)[i], q);
+      }
+      TIME_NS(ns, FOR_N(i, n_samples) QFN(to_euler)(&A(eo)[i], &A(qa)[i]), n_samples);
+      stat_t *st = stat_new(STR(QFN(to_euler)), cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t q = A(get_q)(&A(qa)[i]);
+         long double o[3], r[3];
+         FOR_N(j, 3)
+            o[j] = (long double)A(eo)[i].vec[j];
+         rq_to_euler(q, &r[0], &r[1], &r[2]);
+         /* yaw may wrap around 2 pi */
+         if (o[0] - r[0] > PI_L)
+            o[0] -= 2.0L * PI_L;
+         else if (r[0] - o[0] > PI_L)
+            o[0] += 2.0L * PI_L;
+         stat_add(st, rq_angle(rq_euler(o[0], o[1], o[2]), q), ulp_err(o, r, 3, MANT), -1.0L);
+      }
+   }
+}
+
+
+/* from_euler: angles in [-pi, pi] and large angles up to 16384 rad,
+   against the rotation built from the same (rounded) angles */
+static void A(check_from_euler)(void)
+{
+   static const char *cls[] = { "random", "angles~16384" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 2) {
+      long double range = c == 0 ? PI_L : 16384.0L;
+      FOR_N(i, n_samples)
+         FOR_N(j, 3)
+            A(eo)[i].vec[j] = (REAL)(range * rnd());
+      TIME_NS(ns, FOR_N(i, n_samples) QFN(from_euler)(&A(qo)[i], &A(eo)[i]), n_samples);
+      stat_t *st = stat_new(STR(QFN(from_euler)), cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t out = A(get_q)(&A(qo)[i]);
+         refq_t ref = rq_euler((long double)A(eo)[i].yaw, (long double)A(eo)[i].pitch,
+                               (long double)A(eo)[i].roll);
+         if (rq_dot(out, ref) < 0.0L)
+            ref = rq_scale(ref, -1.0L);
+         stat_add(st, rq_angle(out, ref), ulp_q(out, ref, MANT), norm_q(out));
+      }
+   }
+}
+
+
+/* exponential map functions through the signature of quat_integrate_n;
+   t is the exponent of pow, omega and dt the rates of integrate */
+
+typedef void (*A(expmap_fn))(QUAT_T *qo, const QUAT_T *q, const REAL *t, const VEC3_T *omega,
+                              REAL dt, size_t n);
+
+static void A(exp_loop)(QUAT_T *qo, const QUAT_T *q, const REAL *t, const VEC3_T *omega, REAL dt, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(exp)(&qo[i], &q[i]);
+}
+
+
+static void A(log_loop)(QUAT_T *qo, const QUAT_T *q, const REAL *t, const VEC3_T *omega, REAL dt, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(log)(&qo[i], &q[i]);
+}
+
+
+static void A(pow_loop)(QUAT_T *qo, const QUAT_T *q, const REAL *t, const VEC3_T *omega, REAL dt, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(pow)(&qo[i], &q[i], t[i]);
+}
+
+
+static void A(integrate_loop)(QUAT_T *qo, const QUAT_T *q, const REAL *t, const VEC3_T *omega,
+                              REAL dt, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(integrate)(&qo[i], &q[i], &omega[i], dt);
+}
+
+
+/* op 0 exp: pure quaternions (rotations) up to pi and small, plus a
+   real part in [-1, 1]; op 1 log: random unit quaternions, near the
+   identity and near -1, the angle error is that of exp of the result;
+   op 2 pow: t in [-2, 2]; op 3 integrate: rotation per step up to
+   1 rad and small. The norm error is that of unit results. */
+static void A(check_expmap)(const char *name, A(expmap_fn) fn, int op)
+{
+   static const char *cls[] = { "random", "angle~0", "w!=0" };
+   static const char *log_cls[] = { "random", "angle~0", "angle~2pi" };
+   const REAL dt = (REAL)0.01;
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, (op == 0 || op == 1 ? 3 : 2)) {
+      FOR_N(i, n_samples) {
+         long double angle = c == 1 ? small_angle() : PI_L * (rnd() + 1.0L) * 0.5L;
+         refv_t axis = rv_random();
+         refq_t q = rq_random();
+         if (op == 0) {
+            q.w = c == 2 ? rnd() : 0.0L;
+            q.x = angle * 0.5L * axis.x;
+            q.y = angle * 0.5L * axis.y;
+            q.z = angle * 0.5L * axis.z;
+         } else if (op == 1 && c > 0) {
+            q = rq_axis(axis, c == 1 ? small_angle() : 2.0L * PI_L - small_angle());
+         } else if (op != 1 && c == 1) {
+            q = rq_axis(axis, small_angle());
+         }
+         A(put_q)(&A(qa)[i], q);
+         A(ta)[i] = (REAL)(2.0L * rnd());
+         A(put_v)(&A(va)[i], rv_scale(axis, angle / (long double)dt));
+      }
+      TIME_NS(ns, fn(A(qo), A(qa), A(ta), A(va), dt, n_samples), n_samples);
+      stat_t *st = stat_new(name, op == 1 ? log_cls[c] : cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t q = A(get_q)(&A(qa)[i]), out = A(get_q)(&A(qo)[i]), ref;
+         long double norm = norm_q(out);
+         if (op == 0) {
+            ref = rq_exp(q);
+            if (c == 2)
+               norm = -1.0L;
+         } else if (op == 1) {
+            ref = rq_log(q);
+         } else if (op == 2) {
+            ref = rq_exp(rq_scale(rq_log(q), (long double)A(ta)[i]));
+         } else {
+            refv_t w = A(get_v)(&A(va)[i]);
+            long double h = 0.5L * (long double)dt;
+            refq_t e = { 0.0L, w.x * h, w.y * h, w.z * h };
+            ref = rq_mul(q, rq_exp(e));
+         }
+         if (op == 1)
+            stat_add(st, rq_angle(rq_exp(out), q), ulp_q(out, ref, MANT), -1.0L);
+         else
+            stat_add(st, rq_angle(out, ref), ulp_q(out, ref, MANT), norm);
+      }
+   }
+}
+
+
+/* rotations from vector pairs a[i], b[i] with up vectors up[i] */
+typedef void (*A(aim_fn))(QUAT_T *q, const VEC3_T *a, const VEC3_T *b, const VEC3_T *up, size_t n);
+
+static void A(u2v_loop)(QUAT_T *q, const VEC3_T *u, const VEC3_T *v, const VEC3_T *up, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(from_u2v)(&q[i], &u[i], &v[i], up ? &up[i] : NULL);
+}
+
+static void A(look_at_loop)(QUAT_T *q, const VEC3_T *pos, const VEC3_T *target, const VEC3_T *up, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(look_at)(&q[i], &pos[i], &target[i], up ? &up[i] : NULL);
+}
+
+
+/* from_u2v: random, nearly parallel, nearly antiparallel and exactly
+   antiparallel pairs; the angle error is the angle between the rotated
+   u and v, since the rotation is not unique for antiparallel vectors */
+static void A(check_from_u2v)(const char *name, A(aim_fn) fn)
+{
+   static const char *cls[] = { "random", "parallel~", "antiparallel~", "antiparallel" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 4) {
+      FOR_N(i, n_samples) {
+         refv_t u = rv_random(), v;
+         if (c == 0)
+            v = rv_random();
+         else if (c == 3)
+            v = rv_scale(u, -1.0L);
+         else
+            v = rv_rot(u, rq_axis(rv_random_perp(u), small_angle() + (c == 2 ? PI_L : 0.0L)));
+         A(put_v)(&A(va)[i], rv_scale(u, powl(10.0L, rnd())));
+         A(put_v)(&A(vb)[i], rv_scale(v, powl(10.0L, rnd())));
+      }
+      TIME_NS(ns, fn(A(qo), A(va), A(vb), NULL, n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refv_t u = A(get_v)(&A(va)[i]), v = A(get_v)(&A(vb)[i]);
+         refq_t out = A(get_q)(&A(qo)[i]);
+         long double ulp = c >= 2 ? -1.0L : ulp_q(out, rq_u2v(u, v), MANT);
+         stat_add(st, rv_angle(rv_rot(u, out), v), ulp, norm_q(out));
+      }
+   }
+}
+
+
+/* look_at: random targets, targets nearly behind (forward is x) and
+   within 0.005 to 0.02 rad of up; the error is the larger of the angles
+   between the rotated x and the direction to the target and between the
+   rotated y and the part of up perpendicular to it */
+static void A(check_look_at)(const char *name, A(aim_fn) fn)
+{
+   static const char *cls[] = { "random", "behind~", "up~" };
+   const refv_t x = { 1.0L, 0.0L, 0.0L }, y = { 0.0L, 1.0L, 0.0L };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refv_t pos = rv_scale(rv_random(), 10.0L * rnd()), up = rv_random(), dir;
+         if (c == 0)
+            dir = rv_random();
+         else if (c == 1)
+            dir = rv_rot(rv_scale(x, -1.0L), rq_axis(rv_random_perp(x), small_angle()));
+         else
+            dir = rv_rot(up, rq_axis(rv_random_perp(up), 0.0125L + 0.0075L * rnd()));
+         dir = rv_scale(dir, powl(10.0L, rnd()));
+         refv_t target = { pos.x + dir.x, pos.y + dir.y, pos.z + dir.z };
+         A(put_v)(&A(va)[i], pos);
+         A(put_v)(&A(vb)[i], target);
+         A(put_v)(&A(vc)[i], rv_scale(up, powl(10.0L, rnd())));
+      }
+      TIME_NS(ns, fn(A(qo), A(va), A(vb), A(vc), n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refv_t pos = A(get_v)(&A(va)[i]), target = A(get_v)(&A(vb)[i]), up = A(get_v)(&A(vc)[i]);
+         refv_t d = { target.x - pos.x, target.y - pos.y, target.z - pos.z };
+         long double f = rv_dot(up, d) / rv_dot(d, d);
+         refv_t p = { up.x - f * d.x, up.y - f * d.y, up.z - f * d.z };
+         refq_t out = A(get_q)(&A(qo)[i]);
+         long double angle = fmaxl(rv_angle(rv_rot(x, out), d), rv_angle(rv_rot(y, out), p));
+         stat_add(st, angle, -1.0L, norm_q(out));
+      }
+   }
+}
+
+
+/* to_axis: random rotations and angles near 0 and pi */
+static void A(check_to_axis)(void)
+{
+   static const char *cls[] = { "random", "angle~0", "angle~pi" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refq_t q;
+         if (c == 0)
+            q = rq_random();
+         else
+            q = rq_axis(rv_random(), c == 1 ? small_angle() : PI_L + (rnd() < 0.0L ? -1.0L : 1.0L) * small_angle());
+         A(put_q)(&A(qa)[i], q);
+      }
+      TIME_NS(ns, FOR_N(i, n_samples) QFN(to_axis_v)(&A(qa)[i], &A(vo)[i], &A(fo)[i]), n_samples);
+      stat_t *st = stat_new(STR(QFN(to_axis)), cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t q = rq_normalize(A(get_q)(&A(qa)[i]));
+         refv_t axis = A(get_v)(&A(vo)[i]);
+         refv_t v = { q.x, q.y, q.z };
+         long double angle = (long double)A(fo)[i];
+         long double ref_angle = 2.0L * atan2l(rv_len(v), q.w);
+         long double ulp = -1.0L;
+         if (rv_len(v) > 0.0L) {
+            refv_t ref_axis = rv_normalize(v);
+            long double o[3] = { axis.x, axis.y, axis.z }, r[3] = { ref_axis.x, ref_axis.y, ref_axis.z };
+            ulp = ulp_err(o, r, 3, MANT);
+            long double ulp_angle = ulp_err(&angle, &ref_angle, 1, MANT);
+            if (ulp_angle > ulp)
+               ulp = ulp_angle;
+         }
+         stat_add(st, rq_angle(rq_axis(axis, angle), q), ulp, fabsl(rv_len(axis) - 1.0L));
+      }
+   }
+}
+
+
+/* rot_vec: random rotations and rotations near identity */
+static void A(check_rot_vec)(void)
+{
+   static const char *cls[] = { "random", "q~identity" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 2) {
+      FOR_N(i, n_samples) {
+         refq_t q = c == 0 ? rq_random() : rq_axis(rv_random(), small_angle());
+         A(put_q)(&A(qa)[i], q);
+         A(put_v)(&A(va)[i], rv_scale(rv_random(), powl(10.0L, 3.0L * rnd())));
+      }
+      TIME_NS(ns, FOR_N(i, n_samples) QFN(rot_vec)(&A(vo)[i], &A(va)[i], &A(qa)[i]), n_samples);
+      stat_t *st = stat_new(STR(QFN(rot_vec)), cls[c], ns);
+      FOR_N(i, n_samples) {
+         refv_t out = A(get_v)(&A(vo)[i]);
+         refv_t ref = rv_rot(A(get_v)(&A(va)[i]), A(get_q)(&A(qa)[i]));
+         long double o[3] = { out.x, out.y, out.z }, r[3] = { ref.x, ref.y, ref.z };
+         stat_add(st, rv_angle(out, ref), ulp_err(o, r, 3, MANT), fabsl(rv_len(out) / rv_len(ref) - 1.0L));
+      }
+   }
+}
+
+
+/* from_rh_rot_matrix: random rotations and angles near 0 and pi (trace
+   near -1, where the w = sqrt(1 + trace) / 2 form cancels); the input is
+   the exact matrix of q rounded to REAL */
+typedef void (*A(from_matrix_fn))(QUAT_T *q, const REAL *m, size_t n);
+
+static void A(from_matrix_loop)(QUAT_T *q, const REAL *m, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(from_rh_rot_matrix)(&q[i], &m[i * 16]);
+}
+
+
+static void A(check_from_matrix)(const char *name, A(from_matrix_fn) fn)
+{
+   static const char *cls[] = { "random", "angle~0", "angle~pi" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refq_t q;
+         if (c == 0)
+            q = rq_random();
+         else
+            q = rq_axis(rv_random(), c == 1 ? small_angle() : PI_L - small_angle());
+         A(put_q)(&A(qa)[i], q);
+         REAL *m = &A(ma)[i * 16];
+         FOR_N(col, 4) {
+            refv_t e = { col == 0, col == 1, col == 2 };
+            refv_t r = rv_rot(e, q);
+            m[col * 4] = (REAL)r.x;
+            m[col * 4 + 1] = (REAL)r.y;
+            m[col * 4 + 2] = (REAL)r.z;
+            m[col * 4 + 3] = 0;
+         }
+         m[15] = 1;
+      }
+      TIME_NS(ns, fn(A(qo), A(ma), n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t out = A(get_q)(&A(qo)[i]), ref = A(get_q)(&A(qa)[i]);
+         if (ref.w < 0.0L)
+            ref = rq_scale(ref, -1.0L);
+         stat_add(st, rq_angle(out, ref), ulp_q(out, ref, MANT), norm_q(out));
+      }
+   }
+}
+
+
+/* swing/twist decompositions: random, pure twist and swing near pi;
+   the reference swing is the shortest rotation from v1 to q v1 and the
+   twist the remainder, as documented; errors are the max over both */
+typedef void (*A(decompose_fn))(const QUAT_T *q, const VEC3_T *v1, QUAT_T *a, QUAT_T *b, size_t n);
+
+static void A(swing_twist_loop)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *swing, QUAT_T *twist, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(decompose_swing_twist)(&q[i], &v1[i], &swing[i], &twist[i]);
+}
+
+static void A(twist_swing_loop)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *twist, QUAT_T *swing, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      QFN(decompose_twist_swing)(&q[i], &v1[i], &twist[i], &swing[i]);
+}
+
+static void A(check_decompose)(const char *name, A(decompose_fn) fn, int swing_first)
+{
+   static const char *cls[] = { "random", "twist only", "swing~pi" };
+   double ns;
+
+   rnd_seed();
+   FOR_N(c, 3) {
+      FOR_N(i, n_samples) {
+         refv_t v1 = rv_random();
+         refq_t twist = rq_axis(v1, PI_L * rnd()), q;
+         if (c == 0)
+            q = rq_random();
+         else if (c == 1)
+            q = twist;
+         else
+            q = rq_mul(rq_axis(rv_random_perp(v1), PI_L - small_angle()), twist);
+         A(put_q)(&A(qa)[i], q);
+         A(put_v)(&A(va)[i], v1);
+      }
+      /* swing into qo, twist into qp */
+      if (swing_first)
+         TIME_NS(ns, fn(A(qa), A(va), A(qo), A(qp), n_samples), n_samples);
+      else
+         TIME_NS(ns, fn(A(qa), A(va), A(qp), A(qo), n_samples), n_samples);
+      stat_t *st = stat_new(name, cls[c], ns);
+      FOR_N(i, n_samples) {
+         refq_t q = rq_normalize(A(get_q)(&A(qa)[i]));
+         refv_t v1 = A(get_v)(&A(va)[i]);
+         refq_t swing = rq_u2v(v1, rv_rot(v1, q));
+         refq_t twist = swing_first ? rq_mul(rq_conj(swing), q) : rq_mul(q, rq_conj(swing));
+         refq_t out_swing = A(get_q)(&A(qo)[i]), out_twist = A(get_q)(&A(qp)[i]);
+         long double angle = fmaxl(rq_angle(out_swing, swing), rq_angle(out_twist, twist));
+         long double ulp = fmaxl(ulp_q(out_swing, swing, MANT), ulp_q(out_twist, twist, MANT));
+         long double norm = fmaxl(norm_q(out_swing), norm_q(out_twist));
+         stat_add(st, angle, ulp, norm);
+      }
+   }
+}
+
+
+static void A(check_all)(void)
+{
+   A(check_slerp)(STR(QFN(slerp)), A(slerp_loop));
+   A(check_to_euler)();
+   A(check_from_euler)();
+   A(check_expmap)(STR(QFN(exp)), A(exp_loop), 0);
+   A(check_expmap)(STR(QFN(log)), A(log_loop), 1);
+   A(check_expmap)(STR(QFN(pow)), A(pow_loop), 2);
+   A(check_expmap)(STR(QFN(integrate)), A(integrate_loop), 3);
+   A(check_from_u2v)(STR(QFN(from_u2v)), A(u2v_loop));
+   A(check_look_at)(STR(QFN(look_at)), A(look_at_loop));
+   A(check_to_axis)();
+   A(check_rot_vec)();
+   A(check_from_matrix)(STR(QFN(from_rh_rot_matrix)), A(from_matrix_loop));
+   A(check_decompose)(STR(QFN(decompose_swing_twist)), A(swing_twist_loop), 1);
+   A(check_decompose)(STR(QFN(decompose_twist_swing)), A(twist_swing_loop), 0);
+}
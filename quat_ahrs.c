@@ -0,0 +1,577 @@
+/*
+   quaternion library - attitude and heading reference system
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * see: S. Madgwick, An efficient orientation filter for inertial and
+ *      inertial/magnetic sensor arrays, 2010
+ *      R. Mahony et al., Nonlinear complementary filters on the special
+ *      orthogonal group, 2008
+ *
+ * Both filters compare the measured directions s (accelerometer,
+ * magnetometer) with the directions u = q* d q predicted from the world
+ * references d. The world magnetic reference is the measured field
+ * rotated into the world frame with its horizontal part put on the
+ * north axis, so the magnetometer only corrects heading.
+ *
+ * The gradient of |q* d q - s|^2 / 4 with respect to q is -d q f with
+ * f = u - s (all products are quaternion products, d and f pure).
+ */
+
+
+#include <math.h>
+#include <string.h>
+
+#include "quat_ahrs.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+/* small helpers on values, so the update loop keeps everything in registers */
+
+/* same evaluation order as quat_mul and quat4_mul/quat8_mul, so the
+   lanes of quat_ahrs_multi_t compute bit for bit what this code computes */
+static inline quat_t ahrs_mul(quat_t a, quat_t b)
+{
+   quat_t r;
+   r.x =  a.x * b.w + a.y * b.z - a.z * b.y + a.w * b.x;
+   r.y = -a.x * b.z + a.y * b.w + a.z * b.x + a.w * b.y;
+   r.z =  a.x * b.y - a.y * b.x + a.z * b.w + a.w * b.z;
+   r.w = -a.x * b.x - a.y * b.y - a.z * b.z + a.w * b.w;
+   return r;
+}
+
+
+static inline quat_t ahrs_pure(vec3_t v)
+{
+   quat_t r = { { 0.0f, v.x, v.y, v.z } };
+   return r;
+}
+
+
+static inline vec3_t ahrs_cross(vec3_t a, vec3_t b)
+{
+   vec3_t r = { { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x } };
+   return r;
+}
+
+
+/* v scaled to unit length; returns 0 for a zero vector */
+static inline int ahrs_normalize(vec3_t *v)
+{
+   float n2 = v->x * v->x + v->y * v->y + v->z * v->z;
+   if (n2 == 0.0f)
+      return 0;
+   float s = 1.0f / sqrtf(n2);
+   v->x *= s;
+   v->y *= s;
+   v->z *= s;
+   return 1;
+}
+
+
+/* rotation matrix of unit quaternion q, row major, body to world */
+static inline void ahrs_matrix(float *m, quat_t q)
+{
+   const float ww = q.w * q.w, xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+   const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+   const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+   m[0] = ww + xx - yy - zz;
+   m[1] = 2.0f * (xy - wz);
+   m[2] = 2.0f * (xz + wy);
+   m[3] = 2.0f * (xy + wz);
+   m[4] = ww - xx + yy - zz;
+   m[5] = 2.0f * (yz - wx);
+   m[6] = 2.0f * (xz - wy);
+   m[7] = 2.0f * (yz + wx);
+   m[8] = ww - xx - yy + zz;
+}
+
+
+/* predicted body direction of gravity: ua = q* (0, 0, -1) q */
+static inline void ahrs_predict_acc(const float *m, vec3_t *ua)
+{
+   ua->x = -m[6];
+   ua->y = -m[7];
+   ua->z = -m[8];
+}
+
+
+/* magnetic world reference b = (|h_xy|, 0, h_z) with h = q mag q*,
+   and its predicted body direction um = q* b q */
+static inline void ahrs_predict_mag(const float *m, vec3_t *um, vec3_t *b, const vec3_t *mag)
+{
+   float hx = m[0] * mag->x + m[1] * mag->y + m[2] * mag->z;
+   float hy = m[3] * mag->x + m[4] * mag->y + m[5] * mag->z;
+   b->x = sqrtf(hx * hx + hy * hy);
+   b->y = 0.0f;
+   b->z = m[6] * mag->x + m[7] * mag->y + m[8] * mag->z;
+   um->x = m[0] * b->x + m[6] * b->z;
+   um->y = m[1] * b->x + m[7] * b->z;
+   um->z = m[2] * b->x + m[8] * b->z;
+}
+
+
+/* q += dt * qdot, normalized */
+static inline quat_t ahrs_integrate(quat_t q, quat_t qdot, float dt)
+{
+   FOR_N(i, 4)
+      q.vec[i] += qdot.vec[i] * dt;
+   float s = 1.0f / sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+   FOR_N(i, 4)
+      q.vec[i] *= s;
+   return q;
+}
+
+
+static inline quat_t ahrs_madgwick(quat_t q, const quat_ahrs_sample_t *s, float beta, float dt)
+{
+   /* qdot = q (0, gyro) / 2 */
+   quat_t qdot = ahrs_mul(q, ahrs_pure(s->gyro));
+   FOR_N(i, 4)
+      qdot.vec[i] *= 0.5f;
+
+   vec3_t a = s->acc, mag = s->mag;
+   if (ahrs_normalize(&a)) {
+      float m[9];
+      vec3_t ua;
+      ahrs_matrix(m, q);
+      ahrs_predict_acc(m, &ua);
+
+      /* descent direction d q f summed over both references */
+      quat_t da = { { 0.0f, 0.0f, 0.0f, -1.0f } };
+      quat_t fa = { { 0.0f, ua.x - a.x, ua.y - a.y, ua.z - a.z } };
+      quat_t step = ahrs_mul(ahrs_mul(da, q), fa);
+      if (ahrs_normalize(&mag)) {
+         vec3_t um, b;
+         ahrs_predict_mag(m, &um, &b, &mag);
+         quat_t dm = ahrs_pure(b);
+         quat_t fm = { { 0.0f, um.x - mag.x, um.y - mag.y, um.z - mag.z } };
+         quat_t sm = ahrs_mul(ahrs_mul(dm, q), fm);
+         FOR_N(i, 4)
+            step.vec[i] += sm.vec[i];
+      }
+      float n2 = step.w * step.w + step.x * step.x + step.y * step.y + step.z * step.z;
+      if (n2 > 0.0f) {
+         float k = beta / sqrtf(n2);
+         FOR_N(i, 4)
+            qdot.vec[i] += step.vec[i] * k;
+      }
+   }
+   return ahrs_integrate(q, qdot, dt);
+}
+
+
+static inline quat_t ahrs_mahony(quat_t q, vec3_t *integral, const quat_ahrs_sample_t *s,
+                                 float kp, float ki, float dt)
+{
+   vec3_t g = s->gyro, a = s->acc, mag = s->mag;
+   if (ahrs_normalize(&a)) {
+      float m[9];
+      vec3_t ua;
+      ahrs_matrix(m, q);
+      ahrs_predict_acc(m, &ua);
+
+      /* error = measured x predicted */
+      vec3_t e = ahrs_cross(a, ua);
+      if (ahrs_normalize(&mag)) {
+         vec3_t um, b;
+         ahrs_predict_mag(m, &um, &b, &mag);
+         vec3_t em = ahrs_cross(mag, um);
+         FOR_N(i, 3)
+            e.vec[i] += em.vec[i];
+      }
+      if (ki > 0.0f) {
+         FOR_N(i, 3)
+            integral->vec[i] += ki * dt * e.vec[i];
+      }
+      FOR_N(i, 3)
+         g.vec[i] += kp * e.vec[i] + integral->vec[i];
+   }
+   quat_t qdot = ahrs_mul(q, ahrs_pure(g));
+   FOR_N(i, 4)
+      qdot.vec[i] *= 0.5f;
+   return ahrs_integrate(q, qdot, dt);
+}
+
+
+QUAT_API void quat_ahrs_init(quat_ahrs_t *f, quat_ahrs_type_t type, float dt,
+                             const vec3_t *acc, const vec3_t *mag)
+{
+   static const vec3_t no_mag = { { 0.0f, 0.0f, 0.0f } };
+   quaternion_init(&f->q, acc, mag ? mag : &no_mag);
+   f->dt = dt;
+   f->beta = QUAT_AHRS_BETA;
+   f->kp = QUAT_AHRS_KP;
+   f->ki = QUAT_AHRS_KI;
+   f->integral = no_mag;
+   f->type = type;
+}
+
+
+QUAT_API void quat_ahrs_update(quat_ahrs_t *f, const quat_ahrs_sample_t *s)
+{
+   quat_ahrs_update_n(f, s, 1);
+}
+
+
+QUAT_API void quat_ahrs_update_n(quat_ahrs_t *f, const quat_ahrs_sample_t *s, size_t n)
+{
+   quat_t q = f->q;
+   const float dt = f->dt;
+
+   if (f->type == QUAT_AHRS_MADGWICK) {
+      const float beta = f->beta;
+      for (size_t i = 0; i < n; i++)
+         q = ahrs_madgwick(q, &s[i], beta, dt);
+   } else {
+      const float kp = f->kp, ki = f->ki;
+      vec3_t integral = f->integral;
+      for (size_t i = 0; i < n; i++)
+         q = ahrs_mahony(q, &integral, &s[i], kp, ki, dt);
+      f->integral = integral;
+   }
+   f->q = q;
+}
+
+
+/* multi-stream filters: the code below mirrors ahrs_madgwick and
+   ahrs_mahony operation by operation on AHRS_LANES streams at once;
+   branches become lane masks that select between the same values the
+   scalar code would keep */
+
+#if defined(__AVX__)
+#define AHRS_LANES 8
+#define AHRS_V vfloat8_t
+#define AHRS_VI vint8_t
+#define AHRS_SQRT vfloat8_sqrt
+#define AHRS_QP_T quat8_t
+#define AHRS_QP(op) quat8_##op
+#else
+#define AHRS_LANES 4
+#define AHRS_V vfloat4_t
+#define AHRS_VI vint4_t
+#define AHRS_SQRT vfloat4_sqrt
+#define AHRS_QP_T quat4_t
+#define AHRS_QP(op) quat4_##op
+#endif
+
+
+typedef struct
+{
+   AHRS_V x, y, z;
+}
+ahrs_v3_t;
+
+
+static inline AHRS_V ahrs_vsplat(float f)
+{
+   return (AHRS_V){ 0.0f } + f;
+}
+
+
+/* lane-wise m ? a : b */
+static inline AHRS_V ahrs_vsel(AHRS_VI m, AHRS_V a, AHRS_V b)
+{
+   return (AHRS_V)((m & (AHRS_VI)a) | (~m & (AHRS_VI)b));
+}
+
+
+static inline void ahrs_qsel(AHRS_VI m, AHRS_QP_T *q, const AHRS_QP_T *a)
+{
+   q->w = ahrs_vsel(m, a->w, q->w);
+   q->x = ahrs_vsel(m, a->x, q->x);
+   q->y = ahrs_vsel(m, a->y, q->y);
+   q->z = ahrs_vsel(m, a->z, q->z);
+}
+
+
+static inline AHRS_QP_T ahrs_vpure(ahrs_v3_t v)
+{
+   AHRS_QP_T r = { ahrs_vsplat(0.0f), v.x, v.y, v.z };
+   return r;
+}
+
+
+/* ahrs_normalize; returns the mask of non zero lanes */
+static inline AHRS_VI ahrs_vnormalize(ahrs_v3_t *v)
+{
+   AHRS_V n2 = v->x * v->x + v->y * v->y + v->z * v->z;
+   AHRS_V s = 1.0f / AHRS_SQRT(n2);
+   v->x *= s;
+   v->y *= s;
+   v->z *= s;
+   return n2 != 0.0f;
+}
+
+
+static inline void ahrs_vmatrix(AHRS_V *m, const AHRS_QP_T *q)
+{
+   const AHRS_V ww = q->w * q->w, xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+   const AHRS_V wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+   const AHRS_V xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+   m[0] = ww + xx - yy - zz;
+   m[1] = 2.0f * (xy - wz);
+   m[2] = 2.0f * (xz + wy);
+   m[3] = 2.0f * (xy + wz);
+   m[4] = ww - xx + yy - zz;
+   m[5] = 2.0f * (yz - wx);
+   m[6] = 2.0f * (xz - wy);
+   m[7] = 2.0f * (yz + wx);
+   m[8] = ww - xx - yy + zz;
+}
+
+
+static inline void ahrs_vpredict_mag(const AHRS_V *m, ahrs_v3_t *um, ahrs_v3_t *b, const ahrs_v3_t *mag)
+{
+   AHRS_V hx = m[0] * mag->x + m[1] * mag->y + m[2] * mag->z;
+   AHRS_V hy = m[3] * mag->x + m[4] * mag->y + m[5] * mag->z;
+   b->x = AHRS_SQRT(hx * hx + hy * hy);
+   b->y = ahrs_vsplat(0.0f);
+   b->z = m[6] * mag->x + m[7] * mag->y + m[8] * mag->z;
+   um->x = m[0] * b->x + m[6] * b->z;
+   um->y = m[1] * b->x + m[7] * b->z;
+   um->z = m[2] * b->x + m[8] * b->z;
+}
+
+
+static inline void ahrs_vintegrate(AHRS_QP_T *q, const AHRS_QP_T *qdot, float dt)
+{
+   q->w += qdot->w * dt;
+   q->x += qdot->x * dt;
+   q->y += qdot->y * dt;
+   q->z += qdot->z * dt;
+   AHRS_QP(normalize)(q, q);
+}
+
+
+static inline void ahrs_vmadgwick(AHRS_QP_T *q, const ahrs_v3_t *gyro, ahrs_v3_t a, ahrs_v3_t mag,
+                                  float beta, float dt)
+{
+   AHRS_QP_T qdot, g = ahrs_vpure(*gyro);
+   AHRS_QP(mul)(&qdot, q, &g);
+   AHRS_QP(scale)(&qdot, &qdot, ahrs_vsplat(0.5f));
+
+   AHRS_VI acc_ok = ahrs_vnormalize(&a);
+   AHRS_VI mag_ok = ahrs_vnormalize(&mag);
+   AHRS_V m[9];
+   ahrs_vmatrix(m, q);
+
+   AHRS_V zero = ahrs_vsplat(0.0f);
+   AHRS_QP_T da = { zero, zero, zero, ahrs_vsplat(-1.0f) };
+   AHRS_QP_T fa = { zero, -m[6] - a.x, -m[7] - a.y, -m[8] - a.z };
+   AHRS_QP_T step;
+   AHRS_QP(mul)(&step, &da, q);
+   AHRS_QP(mul)(&step, &step, &fa);
+
+   ahrs_v3_t um, b;
+   ahrs_vpredict_mag(m, &um, &b, &mag);
+   AHRS_QP_T dm = ahrs_vpure(b);
+   AHRS_QP_T fm = { zero, um.x - mag.x, um.y - mag.y, um.z - mag.z };
+   AHRS_QP_T sm;
+   AHRS_QP(mul)(&sm, &dm, q);
+   AHRS_QP(mul)(&sm, &sm, &fm);
+   AHRS_QP(add)(&sm, &step, &sm);
+   ahrs_qsel(mag_ok, &step, &sm);
+
+   AHRS_V n2 = step.w * step.w + step.x * step.x + step.y * step.y + step.z * step.z;
+   AHRS_V k = beta / AHRS_SQRT(n2);
+   AHRS_QP_T corrected;
+   AHRS_QP(scale)(&corrected, &step, k);
+   AHRS_QP(add)(&corrected, &qdot, &corrected);
+   ahrs_qsel(acc_ok & (n2 > 0.0f), &qdot, &corrected);
+
+   ahrs_vintegrate(q, &qdot, dt);
+}
+
+
+static inline void ahrs_vmahony(AHRS_QP_T *q, ahrs_v3_t *integral, const ahrs_v3_t *gyro,
+                                ahrs_v3_t a, ahrs_v3_t mag, float kp, float ki, float dt)
+{
+   AHRS_VI acc_ok = ahrs_vnormalize(&a);
+   AHRS_VI mag_ok = ahrs_vnormalize(&mag);
+   AHRS_V m[9];
+   ahrs_vmatrix(m, q);
+
+   /* e = a x ua with ua = -(m[6], m[7], m[8]) */
+   AHRS_V uax = -m[6], uay = -m[7], uaz = -m[8];
+   ahrs_v3_t e = { a.y * uaz - a.z * uay, a.z * uax - a.x * uaz, a.x * uay - a.y * uax };
+
+   ahrs_v3_t um, b;
+   ahrs_vpredict_mag(m, &um, &b, &mag);
+   e.x = ahrs_vsel(mag_ok, e.x + (mag.y * um.z - mag.z * um.y), e.x);
+   e.y = ahrs_vsel(mag_ok, e.y + (mag.z * um.x - mag.x * um.z), e.y);
+   e.z = ahrs_vsel(mag_ok, e.z + (mag.x * um.y - mag.y * um.x), e.z);
+
+   if (ki > 0.0f) {
+      float kidt = ki * dt;
+      integral->x = ahrs_vsel(acc_ok, integral->x + kidt * e.x, integral->x);
+      integral->y = ahrs_vsel(acc_ok, integral->y + kidt * e.y, integral->y);
+      integral->z = ahrs_vsel(acc_ok, integral->z + kidt * e.z, integral->z);
+   }
+   ahrs_v3_t g =
+   {
+      ahrs_vsel(acc_ok, gyro->x + (kp * e.x + integral->x), gyro->x),
+      ahrs_vsel(acc_ok, gyro->y + (kp * e.y + integral->y), gyro->y),
+      ahrs_vsel(acc_ok, gyro->z + (kp * e.z + integral->z), gyro->z)
+   };
+
+   AHRS_QP_T qdot, gp = ahrs_vpure(g);
+   AHRS_QP(mul)(&qdot, q, &gp);
+   AHRS_QP(scale)(&qdot, &qdot, ahrs_vsplat(0.5f));
+   ahrs_vintegrate(q, &qdot, dt);
+}
+
+
+/* advance streams [i, i + AHRS_LANES) by k samples */
+static void ahrs_multi_lanes(quat_ahrs_multi_t *m, const quat_ahrs_sample_t *const *s, size_t k, size_t i)
+{
+   AHRS_QP_T q;
+   ahrs_v3_t integral;
+   memcpy(&q.w, &m->w[i], sizeof(AHRS_V));
+   memcpy(&q.x, &m->x[i], sizeof(AHRS_V));
+   memcpy(&q.y, &m->y[i], sizeof(AHRS_V));
+   memcpy(&q.z, &m->z[i], sizeof(AHRS_V));
+   memcpy(&integral.x, &m->ix[i], sizeof(AHRS_V));
+   memcpy(&integral.y, &m->iy[i], sizeof(AHRS_V));
+   memcpy(&integral.z, &m->iz[i], sizeof(AHRS_V));
+
+   for (size_t j = 0; j < k; j++) {
+      /* transpose the samples of the lanes into gyro, acc and mag vectors */
+      float in[9][AHRS_LANES];
+      ahrs_v3_t g, a, mag;
+      FOR_N(l, AHRS_LANES) {
+         const quat_ahrs_sample_t *p = &s[i + l][j];
+         FOR_N(c, 3) {
+            in[c][l] = p->gyro.vec[c];
+            in[3 + c][l] = p->acc.vec[c];
+            in[6 + c][l] = p->mag.vec[c];
+         }
+      }
+      memcpy(&g, in[0], sizeof(g));
+      memcpy(&a, in[3], sizeof(a));
+      memcpy(&mag, in[6], sizeof(mag));
+      if (m->type == QUAT_AHRS_MADGWICK)
+         ahrs_vmadgwick(&q, &g, a, mag, m->beta, m->dt);
+      else
+         ahrs_vmahony(&q, &integral, &g, a, mag, m->kp, m->ki, m->dt);
+   }
+
+   memcpy(&m->w[i], &q.w, sizeof(AHRS_V));
+   memcpy(&m->x[i], &q.x, sizeof(AHRS_V));
+   memcpy(&m->y[i], &q.y, sizeof(AHRS_V));
+   memcpy(&m->z[i], &q.z, sizeof(AHRS_V));
+   memcpy(&m->ix[i], &integral.x, sizeof(AHRS_V));
+   memcpy(&m->iy[i], &integral.y, sizeof(AHRS_V));
+   memcpy(&m->iz[i], &integral.z, sizeof(AHRS_V));
+}
+
+
+/* advance a single stream i by k samples with the scalar filter */
+static void ahrs_multi_single(quat_ahrs_multi_t *m, const quat_ahrs_sample_t *const *s, size_t k, size_t i)
+{
+   quat_ahrs_t f;
+   f.q.w = m->w[i];
+   f.q.x = m->x[i];
+   f.q.y = m->y[i];
+   f.q.z = m->z[i];
+   f.dt = m->dt;
+   f.beta = m->beta;
+   f.kp = m->kp;
+   f.ki = m->ki;
+   vec3_init(&f.integral, m->ix[i], m->iy[i], m->iz[i]);
+   f.type = m->type;
+   quat_ahrs_update_n(&f, s[i], k);
+   m->w[i] = f.q.w;
+   m->x[i] = f.q.x;
+   m->y[i] = f.q.y;
+   m->z[i] = f.q.z;
+   m->ix[i] = f.integral.x;
+   m->iy[i] = f.integral.y;
+   m->iz[i] = f.integral.z;
+}
+
+
+typedef struct
+{
+   quat_ahrs_multi_t *m;
+   const quat_ahrs_sample_t *const *s;
+   size_t k;
+}
+ahrs_job_t;
+
+
+/* streams [first, last) of a chunk */
+static void ahrs_multi_chunk(void *ctx, size_t first, size_t last)
+{
+   ahrs_job_t *job = ctx;
+   size_t i = first;
+   for (; i + AHRS_LANES <= last; i += AHRS_LANES)
+      ahrs_multi_lanes(job->m, job->s, job->k, i);
+   for (; i < last; i++)
+      ahrs_multi_single(job->m, job->s, job->k, i);
+}
+
+
+QUAT_API void quat_ahrs_multi_init(quat_ahrs_multi_t *m, float *storage, size_t n,
+                                   quat_ahrs_type_t type, float dt,
+                                   const vec3_t *acc, const vec3_t *mag)
+{
+   m->n = n;
+   m->dt = dt;
+   m->beta = QUAT_AHRS_BETA;
+   m->kp = QUAT_AHRS_KP;
+   m->ki = QUAT_AHRS_KI;
+   m->type = type;
+   m->w = storage;
+   m->x = storage + n;
+   m->y = storage + 2 * n;
+   m->z = storage + 3 * n;
+   m->ix = storage + 4 * n;
+   m->iy = storage + 5 * n;
+   m->iz = storage + 6 * n;
+   for (size_t i = 0; i < n; i++) {
+      quat_ahrs_t f;
+      quat_ahrs_init(&f, type, dt, &acc[i], mag ? &mag[i] : NULL);
+      m->w[i] = f.q.w;
+      m->x[i] = f.q.x;
+      m->y[i] = f.q.y;
+      m->z[i] = f.q.z;
+      m->ix[i] = 0.0f;
+      m->iy[i] = 0.0f;
+      m->iz[i] = 0.0f;
+   }
+}
+
+
+QUAT_API void quat_ahrs_multi_get(const quat_ahrs_multi_t *m, size_t i, quat_t *q)
+{
+   q->w = m->w[i];
+   q->x = m->x[i];
+   q->y = m->y[i];
+   q->z = m->z[i];
+}
+
+
+QUAT_API void quat_ahrs_multi_update_n(quat_pool_t *p, quat_ahrs_multi_t *m,
+                                       const quat_ahrs_sample_t *const *s, size_t k)
+{
+   ahrs_job_t job = { m, s, k };
+   quat_pool_for(p, m->n, QUAT_AHRS_CHUNK, 2 * QUAT_AHRS_CHUNK, ahrs_multi_chunk, &job);
+}
@@ -0,0 +1,130 @@
+/*
+   quaternion library - attitude and heading reference system interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_AHRS_H__
+#define __QUAT_AHRS_H__
+
+
+#include "quat.h"
+#include "quat_pool.h"
+
+
+/* Frames follow quaternion_init: q rotates body vectors into a north,
+ * east, down world frame. The accelerometer measures specific force,
+ * i.e. (0, 0, -g) in the body frame when lying flat at rest. The gyro
+ * gives body rates in rad/s. Accelerometer and magnetometer units do
+ * not matter, both are normalized.
+ */
+
+
+typedef enum
+{
+   QUAT_AHRS_MADGWICK,   /* gradient descent correction, gain beta */
+   QUAT_AHRS_MAHONY      /* PI correction of the gyro rates, gains kp and ki */
+}
+quat_ahrs_type_t;
+
+
+/* default gains, set by quat_ahrs_init */
+#define QUAT_AHRS_BETA 0.1f
+#define QUAT_AHRS_KP 1.0f
+#define QUAT_AHRS_KI 0.0f
+
+
+/* one IMU sample; a zero acc or mag vector marks it as missing */
+typedef struct
+{
+   vec3_t gyro;
+   vec3_t acc;
+   vec3_t mag;
+}
+quat_ahrs_sample_t;
+
+
+typedef struct
+{
+   quat_t q;             /* current orientation */
+   float dt;             /* fixed sample period in s */
+   float beta;           /* Madgwick gain */
+   float kp, ki;         /* Mahony gains */
+   vec3_t integral;      /* Mahony integral term, rad/s */
+   quat_ahrs_type_t type;
+}
+quat_ahrs_t;
+
+
+/* initialize filter f with sample period dt, seeded from the
+ * accelerometer and magnetometer via quaternion_init; mag may be NULL
+ */
+QUAT_API void quat_ahrs_init(quat_ahrs_t *f, quat_ahrs_type_t type, float dt,
+                             const vec3_t *acc, const vec3_t *mag);
+
+/* advance the filter by one sample */
+QUAT_API void quat_ahrs_update(quat_ahrs_t *f, const quat_ahrs_sample_t *s);
+
+/* advance the filter by n consecutive samples; this is the cheapest way
+ * to feed a sensor buffer, the filter state stays in registers
+ */
+QUAT_API void quat_ahrs_update_n(quat_ahrs_t *f, const quat_ahrs_sample_t *s, size_t n);
+
+
+/* n independent filters advanced in lockstep, one stream per SIMD lane;
+ * every stream gives bit for bit the result of its own quat_ahrs_t.
+ * State is stored as structure of arrays in caller provided storage
+ * of QUAT_AHRS_MULTI_FLOATS(n) floats. All streams share type and gains.
+ */
+typedef struct
+{
+   size_t n;             /* number of streams */
+   float dt;
+   float beta;
+   float kp, ki;
+   quat_ahrs_type_t type;
+   float *w, *x, *y, *z; /* orientation of stream i is (w[i], x[i], y[i], z[i]) */
+   float *ix, *iy, *iz;  /* Mahony integral terms */
+}
+quat_ahrs_multi_t;
+
+#define QUAT_AHRS_MULTI_FLOATS(n) (7 * (n))
+
+/* streams per chunk of quat_ahrs_multi_update_n on a pool */
+#define QUAT_AHRS_CHUNK 8
+
+
+/* initialize n filters like quat_ahrs_init, stream i from acc[i] and
+ * mag[i]; mag may be NULL
+ */
+QUAT_API void quat_ahrs_multi_init(quat_ahrs_multi_t *m, float *storage, size_t n,
+                                   quat_ahrs_type_t type, float dt,
+                                   const vec3_t *acc, const vec3_t *mag);
+
+/* orientation of stream i */
+QUAT_API void quat_ahrs_multi_get(const quat_ahrs_multi_t *m, size_t i, quat_t *q);
+
+/* advance every stream i by the k samples s[i][0 .. k - 1] on pool p
+ * (may be NULL); the result does not depend on the pool
+ */
+QUAT_API void quat_ahrs_multi_update_n(quat_pool_t *p, quat_ahrs_multi_t *m,
+                                       const quat_ahrs_sample_t *const *s, size_t k);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_ahrs.c"
+#endif
+
+
+#endif /* __QUAT_AHRS_H__ */
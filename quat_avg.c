@@ -0,0 +1,186 @@
+/*
+   quaternion library - orientation averaging implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quat_avg.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+/* index pairs of the 10 elements of M */
+static const int avg_pairs[10][2] =
+{
+   { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 1 }, { 1, 2 }, { 1, 3 }, { 2, 2 }, { 2, 3 }, { 3, 3 }
+};
+
+/* squarings of M; after k of them the second eigenvector is damped by
+   (l2 / l1)^(2^k) */
+#define AVG_SQUARINGS 24
+#define AVG_POWER_STEPS 2
+
+
+QUAT_API void quat_avg_init(quat_avg_t *a)
+{
+   memset(a, 0, sizeof(*a));
+}
+
+
+QUAT_API void quat_avg_add(quat_avg_t *a, const quat_t *q, float w)
+{
+   FOR_N(k, 10) {
+      const int i = avg_pairs[k][0], j = avg_pairs[k][1];
+      a->m[k] += ((double)w * (double)q->vec[i]) * (double)q->vec[j];
+   }
+   a->weight += (double)w;
+   a->n++;
+}
+
+
+QUAT_API void quat_avg_add_n(quat_avg_t *a, const quat_t *q, const float *w, size_t n)
+{
+   vdouble4_t s[10], ws = { 0.0 };
+   size_t full = n & ~(size_t)3;
+   FOR_N(k, 10)
+      s[k] = (vdouble4_t){ 0.0 };
+   for (size_t i = 0; i < full; i += 4) {
+      quat4_t p;
+      vdouble4_t v[4], wd = { 1.0, 1.0, 1.0, 1.0 };
+      quat4_load(&p, q + i);
+      if (w) {
+         vfloat4_t wf;
+         memcpy(&wf, w + i, sizeof(wf));
+         wd = __builtin_convertvector(wf, vdouble4_t);
+      }
+      v[0] = __builtin_convertvector(p.w, vdouble4_t);
+      v[1] = __builtin_convertvector(p.x, vdouble4_t);
+      v[2] = __builtin_convertvector(p.y, vdouble4_t);
+      v[3] = __builtin_convertvector(p.z, vdouble4_t);
+      FOR_N(k, 10)
+         s[k] += (wd * v[avg_pairs[k][0]]) * v[avg_pairs[k][1]];
+      ws += wd;
+   }
+   FOR_N(k, 10)
+      a->m[k] += (s[k][0] + s[k][1]) + (s[k][2] + s[k][3]);
+   a->weight += (ws[0] + ws[1]) + (ws[2] + ws[3]);
+   a->n += full;
+   for (size_t i = full; i < n; i++)
+      quat_avg_add(a, &q[i], w ? w[i] : 1.0f);
+}
+
+
+QUAT_API void quat_avg_merge(quat_avg_t *a, const quat_avg_t *b)
+{
+   FOR_N(k, 10)
+      a->m[k] += b->m[k];
+   a->weight += b->weight;
+   a->n += b->n;
+}
+
+
+typedef struct
+{
+   quat_avg_t *part;         /* one accumulator per chunk */
+   const quat_t *q;
+   const float *w;
+}
+avg_job_t;
+
+
+static void avg_chunk(void *ctx, size_t first, size_t last)
+{
+   avg_job_t *job = ctx;
+   quat_avg_t *a = &job->part[first / QUAT_POOL_CHUNK];
+   quat_avg_add_n(a, job->q + first, job->w ? job->w + first : NULL, last - first);
+}
+
+
+QUAT_API int quat_avg_add_pool(quat_pool_t *p, quat_avg_t *a, const quat_t *q, const float *w, size_t n)
+{
+   size_t chunks = (n + QUAT_POOL_CHUNK - 1) / QUAT_POOL_CHUNK;
+   avg_job_t job = { calloc(chunks ? chunks : 1, sizeof(quat_avg_t)), q, w };
+   if (!job.part)
+      return -1;
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, avg_chunk, &job);
+   for (size_t c = 0; c < chunks; c++)
+      quat_avg_merge(a, &job.part[c]);
+   free(job.part);
+   return 0;
+}
+
+
+/* r = s s / trace(s s) */
+static void avg_square(double r[4][4], double s[4][4])
+{
+   double t[4][4], tr = 0.0;
+   FOR_N(i, 4)
+      FOR_N(j, 4)
+         t[i][j] = ((s[i][0] * s[0][j] + s[i][1] * s[1][j]) + (s[i][2] * s[2][j] + s[i][3] * s[3][j]));
+   FOR_N(i, 4)
+      tr += t[i][i];
+   if (!(tr > 0.0))
+      return;
+   FOR_N(i, 4)
+      FOR_N(j, 4)
+         r[i][j] = t[i][j] / tr;
+}
+
+
+QUAT_API int quat_avg_get(const quat_avg_t *a, quat_t *q)
+{
+   double m[4][4], s[4][4], v[4];
+   if (!(a->weight > 0.0))
+      return -1;
+   FOR_N(k, 10) {
+      const int i = avg_pairs[k][0], j = avg_pairs[k][1];
+      m[i][j] = m[j][i] = a->m[k] / a->weight;
+   }
+   memcpy(s, m, sizeof(s));
+   /* s -> v v^T for the dominant eigenvector v; its largest diagonal
+      element picks the column with the best conditioned copy of v */
+   FOR_N(k, AVG_SQUARINGS)
+      avg_square(s, s);
+   int c = 0;
+   FOR_N(i, 4)
+      if (s[i][i] > s[c][c])
+         c = i;
+   FOR_N(i, 4)
+      v[i] = s[i][c];
+   FOR_N(k, AVG_POWER_STEPS + 1) {
+      double len = sqrt((v[0] * v[0] + v[1] * v[1]) + (v[2] * v[2] + v[3] * v[3]));
+      if (!(len > 0.0))
+         return -1;
+      FOR_N(i, 4)
+         v[i] /= len;
+      if (k == AVG_POWER_STEPS)
+         break;
+      double u[4];
+      FOR_N(i, 4)
+         u[i] = (m[i][0] * v[0] + m[i][1] * v[1]) + (m[i][2] * v[2] + m[i][3] * v[3]);
+      memcpy(v, u, sizeof(v));
+   }
+   /* q and -q average the same, return the one with w >= 0 */
+   double sign = v[0] < 0.0 ? -1.0 : 1.0;
+   FOR_N(i, 4)
+      q->vec[i] = (float)(sign * v[i]);
+   return 0;
+}
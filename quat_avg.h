@@ -0,0 +1,83 @@
+/*
+   quaternion library - orientation averaging interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_AVG_H__
+#define __QUAT_AVG_H__
+
+
+#include "quat.h"
+#include "quat_pool.h"
+
+
+/* see: F. L. Markley, Y. Cheng, J. L. Crassidis, Y. Oshman,
+ *      Averaging quaternions, 2007
+ *
+ * The average of unit quaternions q_i with weights w_i is the unit
+ * eigenvector of M = sum w_i q_i q_i^T with the largest eigenvalue. It
+ * minimizes the weighted sum of squared chordal distances between the
+ * rotations, and q and -q give the same M, so signs do not matter.
+ *
+ * The accumulator holds the 10 distinct elements of M in double, so
+ * samples can be added one at a time or in arrays, and accumulators of
+ * separate threads or data sets can be merged.
+ */
+typedef struct
+{
+   double m[10];             /* ww wx wy wz xx xy xz yy yz zz */
+   double weight;            /* sum of the weights */
+   size_t n;                 /* number of samples */
+}
+quat_avg_t;
+
+
+QUAT_API void quat_avg_init(quat_avg_t *a);
+
+/* add unit quaternion q with weight w >= 0 */
+QUAT_API void quat_avg_add(quat_avg_t *a, const quat_t *q, float w);
+
+/* add n quaternions q[i] with weights w[i], or weight 1 if w is NULL,
+ * at full vector width
+ */
+QUAT_API void quat_avg_add_n(quat_avg_t *a, const quat_t *q, const float *w, size_t n);
+
+/* add the same as quat_avg_add_n, with the array split into chunks on
+ * pool p (may be NULL); the partial sums are merged in chunk order, so
+ * the result does not depend on the number of threads. Returns 0 on
+ * success, -1 if there is no memory for the partial sums.
+ */
+QUAT_API int quat_avg_add_pool(quat_pool_t *p, quat_avg_t *a, const quat_t *q, const float *w, size_t n);
+
+/* a += b */
+QUAT_API void quat_avg_merge(quat_avg_t *a, const quat_avg_t *b);
+
+/* average of the samples so far, with w >= 0; returns 0 on success or
+ * -1 if the weights sum to 0. The eigenvector is found by repeated
+ * squaring of M, which converges even when the two largest eigenvalues
+ * are close (widely spread samples), then polished by power iteration;
+ * the average is within 1e-6 rad of the exact one (quat_accuracy).
+ * It is not unique if the two largest eigenvalues are equal, e.g. for
+ * two samples 180 degrees apart.
+ */
+QUAT_API int quat_avg_get(const quat_avg_t *a, quat_t *q);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_avg.c"
+#endif
+
+
+#endif /* __QUAT_AVG_H__ */
@@ -0,0 +1,1695 @@
+/*
+   quaternion library - benchmarks
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * usage: quat_bench [--json] [--filter substr] [--compare baseline.json]
+ *                   [--threshold percent]
+ *
+ * Times every public function with fixed-seed inputs and reports ns/op,
+ * Mop/s and (on x86) TSC cycles/op. --json prints the results as JSON,
+ * which can be saved as baseline; --compare flags every function that
+ * got slower than the baseline by more than the threshold (default 10%)
+ * and exits with status 1 if there is any.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "quat.h"
+#include "quat_track.h"
+#include "quat_ahrs.h"
+#include "quat_xform.h"
+#include "quat_dq.h"
+#include "quat_wire.h"
+#include "quat_trace.h"
+#include "quat_store.h"
+#include "quat_pool.h"
+#include "quat_avg.h"
+#include "quat_nn.h"
+#include "quat_spline.h"
+#include "quat_joint.h"
+
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+
+#define N_SCALAR 1024    /* inputs per pass of the scalar benchmarks */
+#define N_BATCH 16384    /* elements per pass of the batch benchmarks */
+#define N_RUNS 5         /* report the fastest of these runs */
+#define MIN_TIME 0.01    /* minimum duration of a run in seconds */
+
+
+typedef struct
+{
+   const char *name;
+   void (*fn)(void);
+   int ops;              /* operations per call of fn */
+}
+bench_t;
+
+
+typedef struct
+{
+   const char *name;
+   double ns;            /* per op */
+   double cycles;        /* per op, 0 if not available */
+}
+result_t;
+
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+
+static unsigned long long cycles(void)
+{
+#if defined(HAVE_TSC)
+   return __rdtsc();
+#else
+   return 0;
+#endif
+}
+
+
+/* fixed-seed xorshift generator, uniform in [-1, 1] */
+static unsigned int rnd_state = 2463534242u;
+
+static double rnd(void)
+{
+   rnd_state ^= rnd_state << 13;
+   rnd_state ^= rnd_state >> 17;
+   rnd_state ^= rnd_state << 5;
+   return rnd_state / 2147483647.5 - 1.0;
+}
+
+
+/* scalar API, float and double */
+
+#define REAL float
+#define QUAT_T quat_t
+#define VEC3_T vec3_t
+#define EULER_T euler_t
+#define QFN(name) quat_##name
+#define VFN(name) vec3_##name
+#define QUAT_INIT quaternion_init
+#define NORMALIZE_EULER normalize_euler_0_2pi
+#define LIT(x) x##f
+#define B(name) f_##name
+#define BTABLE float_benches
+#include "quat_bench_tmpl.c"
+#include "quat_tmpl_undef.h"
+#undef B
+#undef BTABLE
+
+#define REAL double
+#define QUAT_T quatd_t
+#define VEC3_T vec3d_t
+#define EULER_T eulerd_t
+#define QFN(name) quatd_##name
+#define VFN(name) vec3d_##name
+#define QUAT_INIT quaterniond_init
+#define NORMALIZE_EULER normalize_eulerd_0_2pi
+#define LIT(x) x
+#define B(name) d_##name
+#define BTABLE double_benches
+#include "quat_bench_tmpl.c"
+#include "quat_tmpl_undef.h"
+#undef B
+#undef BTABLE
+
+
+/* batch API */
+
+#define N_KEYS 64
+
+static vec3_t bv_in[N_BATCH], bv_out[N_BATCH];
+static float bx[N_BATCH], by[N_BATCH], bz[N_BATCH];
+static quat_t bq1[N_BATCH], bq2[N_BATCH], bqo[N_BATCH];
+static float bf[N_BATCH], bt[N_BATCH];
+static euler_t be[N_BATCH], be2[N_BATCH];
+static vec3_t bomega[N_BATCH];
+
+/* large arrays for the pool */
+#define N_POOL (8 * N_BATCH)
+static quat_t pq1[N_POOL], pq2[N_POOL], pqo[N_POOL];
+static vec3_t pomega[N_POOL];
+static quat_pool_t pool4;
+static quat_avg_t avg;
+
+/* pose library of the nearest neighbour index */
+#define N_NN_QUERIES 64
+#define N_NN_K 8
+static quat_t nnq[N_POOL];
+static quat_nn_node_t nn_nodes[N_POOL];
+static quat_nn_t nn;
+static quat_nn_hit_t nn_hits[N_BATCH * N_NN_K];
+static float bm[N_BATCH * 16], bm_in[N_BATCH * 16];
+static quat_key_t keys[N_KEYS];
+static quat_seg_t segs[N_KEYS];
+static quat_track_t track;
+static quat_track_t tracks[N_KEYS];
+static quat_spline_seg_t spline_segs[N_KEYS];
+static quat_spline_t spline;
+
+/* a skeleton worth of joint limits around the bone axes bv_in */
+static quat_joint_t joints[N_BATCH];
+static quat_t bswing[N_BATCH], btwist[N_BATCH];
+static quat_ahrs_sample_t imu[N_BATCH];
+static quat_ahrs_t madgwick, mahony;
+
+#define N_STREAMS 64
+#define N_STREAM_SAMPLES (N_BATCH / N_STREAMS)
+
+/* 4-ary tree of transforms, in breadth first and depth first order */
+#define N_NODES 131072
+
+static quat_xform_t local[N_NODES], world[N_NODES];
+static int bfs_parent[N_NODES], dfs_parent[N_NODES];
+
+/* skinned vertices with 4 or 8 influences from N_BONES bones */
+#define N_BONES 64
+#define N_INFLUENCES 8
+
+static quat_dq_t palette[N_BONES];
+static int bones[N_BATCH * N_INFLUENCES];
+static float weights[N_BATCH * N_INFLUENCES];
+static vec3_t bn_in[N_BATCH], bn_out[N_BATCH];
+static quat_wire32_t bw32[N_BATCH];
+static quat_wire48_t bw48[N_BATCH];
+static quat_wire64_t bw64[N_BATCH];
+
+#define N_TRACE (4 * N_BATCH)
+#define N_TRACE_BLOCK 1024
+static quat_trace_t trace48, trace_float;
+static double trace_t[N_TRACE];
+static double bts[N_BATCH], btr[N_BATCH];   /* sorted and random sample times */
+
+/* entity orientations steered by small per tick angles */
+static float store_storage[QUAT_STORE_FLOATS(N_BATCH)];
+static quat_store_t store;
+static float steer[3][N_BATCH];
+
+static const quat_ahrs_sample_t *streams[N_STREAMS];
+static float multi_storage[QUAT_AHRS_MULTI_FLOATS(N_STREAMS)];
+static quat_ahrs_multi_t multi;
+
+
+static void batch_init(void)
+{
+   FOR_N(i, N_BATCH) {
+      vec3_init(&bv_in[i], (float)rnd(), (float)rnd(), (float)rnd());
+      bx[i] = bv_in[i].x;
+      by[i] = bv_in[i].y;
+      bz[i] = bv_in[i].z;
+      FOR_N(j, 4) {
+         bq1[i].vec[j] = (float)rnd();
+         bq2[i].vec[j] = (float)rnd();
+      }
+      quat_normalize_self(&bq1[i]);
+      quat_normalize_self(&bq2[i]);
+      FOR_N(j, 3)
+         steer[j][i] = 0.01f * (float)rnd();
+      vec3_init(&bomega[i], 10.0f * (float)rnd(), 10.0f * (float)rnd(), 10.0f * (float)rnd());
+      bt[i] = (float)i / N_BATCH;
+   }
+   FOR_N(i, N_BATCH)
+      quat_to_rh_rot_matrix(&bq1[i], &bm_in[i * 16]);
+   FOR_N(i, N_KEYS) {
+      keys[i].t = i;
+      keys[i].q = bq1[i];
+   }
+   quat_track_init(&track, segs, keys, N_KEYS);
+   FOR_N(i, N_KEYS)
+      tracks[i] = track;
+   quat_spline_init(&spline, spline_segs, keys, N_KEYS);
+   FOR_N(i, N_BATCH)
+      quat_joint_init(&joints[i], &bv_in[i], 1.0f + 0.5f * (float)rnd(), -1.0f + 0.5f * (float)rnd(),
+                      1.0f + 0.5f * (float)rnd());
+   quat_store_init(&store, store_storage, N_BATCH, bq1);
+   FOR_N(i, N_POOL) {
+      pq1[i] = bq1[i % N_BATCH];
+      pq2[i] = bq2[(i + 7) % N_BATCH];
+      pomega[i] = bomega[(i + 3) % N_BATCH];
+   }
+   quat_pool_init(&pool4, 4);
+   FOR_N(i, N_POOL) {
+      FOR_N(j, 4)
+         nnq[i].vec[j] = (float)rnd();
+      quat_normalize_self(&nnq[i]);
+   }
+   quat_nn_build(&nn, nn_nodes, nnq, N_POOL);
+
+   /* noisy IMU at rest, 1 kHz */
+   FOR_N(i, N_BATCH) {
+      vec3_init(&imu[i].gyro, 0.01f * (float)rnd(), 0.01f * (float)rnd(), 0.01f * (float)rnd());
+      vec3_init(&imu[i].acc, 0.05f * (float)rnd(), 0.05f * (float)rnd(), -9.81f + 0.05f * (float)rnd());
+      vec3_init(&imu[i].mag, 0.2f + 0.01f * (float)rnd(), 0.01f * (float)rnd(), 0.4f + 0.01f * (float)rnd());
+      /* some dropped measurements */
+      if (i % 13 == 0)
+         vec3_init(&imu[i].mag, 0.0f, 0.0f, 0.0f);
+      if (i % 97 == 0)
+         vec3_init(&imu[i].acc, 0.0f, 0.0f, 0.0f);
+   }
+   quat_ahrs_init(&madgwick, QUAT_AHRS_MADGWICK, 0.001f, &imu[1].acc, &imu[1].mag);
+   quat_ahrs_init(&mahony, QUAT_AHRS_MAHONY, 0.001f, &imu[1].acc, &imu[1].mag);
+
+   vec3_t acc[N_STREAMS], mag[N_STREAMS];
+   FOR_N(i, N_STREAMS) {
+      streams[i] = &imu[i * N_STREAM_SAMPLES];
+      acc[i] = imu[i * N_STREAM_SAMPLES + 1].acc;
+      mag[i] = imu[i * N_STREAM_SAMPLES + 1].mag;
+   }
+   quat_ahrs_multi_init(&multi, multi_storage, N_STREAMS, QUAT_AHRS_MADGWICK, 0.001f, acc, mag);
+
+   static int stack[N_NODES], dfs_index[N_NODES];
+   int top = 0, next = 0;
+   FOR_N(i, N_NODES) {
+      quat_xform_init(&local[i], &bq1[i % N_BATCH], &bv_in[i % N_BATCH]);
+      bfs_parent[i] = i ? (i - 1) / 4 : -1;
+   }
+   FOR_N(i, N_BONES)
+      quat_dq_from_xform(&palette[i], &local[i]);
+   FOR_N(i, N_BATCH * N_INFLUENCES) {
+      bones[i] = (int)((rnd() + 1.0) * 0.5 * (N_BONES - 1) + 0.5);
+      weights[i] = (float)(rnd() + 1.0);
+   }
+   FOR_N(i, N_BATCH)
+      bn_in[i] = bv_in[(i + 1) % N_BATCH];
+
+   /* preorder numbering of the same tree */
+   stack[top++] = 0;
+   while (top) {
+      int b = stack[--top];
+      dfs_index[b] = next++;
+      for (int c = 4 * b + 4; c > 4 * b; c--)
+         if (c < N_NODES)
+            stack[top++] = c;
+   }
+   FOR_N(i, N_NODES)
+      dfs_parent[dfs_index[i]] = i ? dfs_index[bfs_parent[i]] : -1;
+
+   /* 100 Hz traces with jitter; the files are unlinked right away,
+      the mappings stay valid */
+   FOR_N(i, N_TRACE)
+      trace_t[i] = 100.0 + 0.01 * i + 0.002 * rnd();
+   FOR_N(f, 2) {
+      char path[] = "/tmp/quat_bench_XXXXXX";
+      quat_trace_writer_t w;
+      int fd = mkstemp(path);
+      if (fd < 0)
+         goto trace_fail;
+      close(fd);
+      if (quat_trace_writer_open(&w, path, f ? QUAT_TRACE_FLOAT : QUAT_TRACE_WIRE48, 1.0e-6, N_TRACE_BLOCK))
+         goto trace_fail;
+      FOR_N(i, N_TRACE)
+         quat_trace_writer_append(&w, trace_t[i], &bq1[i % N_BATCH]);
+      int err = quat_trace_writer_close(&w) || quat_trace_open(f ? &trace_float : &trace48, path);
+      unlink(path);
+      if (err)
+         goto trace_fail;
+   }
+   FOR_N(i, N_BATCH) {
+      bts[i] = 100.0 + 0.04 * i + 0.001;
+      btr[i] = 100.0 + 0.01 * N_TRACE * 0.5 * (rnd() + 1.0);
+   }
+   return;
+
+trace_fail:
+   fprintf(stderr, "cannot write trace file\n");
+   exit(EXIT_FAILURE);
+}
+
+
+static void b_rot_vec_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_rot_vec(&bv_out[i], &bv_in[i], &bq1[0]);
+}
+
+static void b_rot_vec_n(void) { quat_rot_vec_n(bv_out, bv_in, &bq1[0], N_BATCH); }
+static void b_rot_vec_soa(void) { quat_rot_vec_soa(bx, by, bz, bx, by, bz, &bq1[0], N_BATCH); }
+static void b_mul_n(void) { quat_mul_n(bqo, bq1, bq2, N_BATCH); }
+static void b_conj_n(void) { quat_conj_n(bqo, bq1, N_BATCH); }
+static void b_normalize_n(void) { quat_normalize_n(bqo, bq1, N_BATCH); }
+static void b_dot_n(void) { quat_dot_n(bf, bq1, bq2, N_BATCH); }
+static void b_slerp_fast_n(void) { quat_slerp_fast_n(bqo, bq1, bq2, bt, N_BATCH); }
+
+static void b_slerp_fast(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_slerp_fast(&bqo[i], &bq1[i], &bq2[i], bt[i]);
+}
+
+static void b_pool_mul_1(void) { quat_mul_n(pqo, pq1, pq2, N_POOL); }
+static void b_pool_mul_4(void) { quat_pool_mul_n(&pool4, pqo, pq1, pq2, N_POOL); }
+static void b_pool_integrate_1(void) { quat_integrate_n(pqo, pq1, pomega, 0.001f, N_POOL); }
+static void b_pool_integrate_4(void) { quat_pool_integrate_n(&pool4, pqo, pq1, pomega, 0.001f, N_POOL); }
+
+/* nearest pose by brute force, the baseline of the index */
+static size_t nn_brute(const quat_t *q)
+{
+   size_t best = 0;
+   float best_dot = -1.0f;
+   FOR_N(i, N_POOL) {
+      float d = fabsf(quat_dot(q, &nnq[i]));
+      if (d > best_dot) {
+         best_dot = d;
+         best = i;
+      }
+   }
+   return best;
+}
+
+/* rotation angle between a and b in double, from the chord between the
+   normalized quaternions, 2 acos(|a . b|) is inaccurate near 0 */
+static float nn_ref_angle(const quat_t *a, const quat_t *b)
+{
+   double la = 0.0, lb = 0.0, m = 0.0, p = 0.0;
+   FOR_N(i, 4) {
+      la += (double)a->vec[i] * (double)a->vec[i];
+      lb += (double)b->vec[i] * (double)b->vec[i];
+   }
+   FOR_N(i, 4) {
+      double u = (double)a->vec[i] / sqrt(la), v = (double)b->vec[i] / sqrt(lb);
+      m += (u - v) * (u - v);
+      p += (u + v) * (u + v);
+   }
+   return (float)(4.0 * asin(0.5 * sqrt(m < p ? m : p)));
+}
+
+static void b_nn_brute(void)
+{
+   FOR_N(i, N_NN_QUERIES)
+      nn_hits[i].id = (uint32_t)nn_brute(&bq2[i]);
+}
+
+static void b_nn_build(void) { quat_nn_build(&nn, nn_nodes, nnq, N_POOL); }
+
+static void b_nn_knn_1(void)
+{
+   FOR_N(i, N_NN_QUERIES)
+      quat_nn_knn(&nn, &bq2[i], 1, &nn_hits[i]);
+}
+
+static void b_nn_knn_n_8(void) { quat_nn_knn_n(NULL, &nn, bq2, N_BATCH, N_NN_K, nn_hits); }
+static void b_nn_knn_n_8_4(void) { quat_nn_knn_n(&pool4, &nn, bq2, N_BATCH, N_NN_K, nn_hits); }
+
+static void b_nn_within(void)
+{
+   FOR_N(i, N_NN_QUERIES)
+      quat_nn_within(&nn, &bq2[i], 0.1f, nn_hits, N_BATCH);
+}
+
+static void b_avg_add_loop(void)
+{
+   quat_avg_init(&avg);
+   FOR_N(i, N_POOL)
+      quat_avg_add(&avg, &pq1[i], 1.0f);
+}
+
+static void b_avg_add_n(void)
+{
+   quat_avg_init(&avg);
+   quat_avg_add_n(&avg, pq1, NULL, N_POOL);
+}
+
+static void b_avg_add_pool_4(void)
+{
+   quat_avg_init(&avg);
+   quat_avg_add_pool(&pool4, &avg, pq1, NULL, N_POOL);
+}
+
+static void b_to_euler_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_to_euler(&be[i], &bq1[i]);
+}
+
+static void b_to_euler_n(void) { quat_to_euler_n(be, bq1, N_BATCH, QUAT_EULER_ZYX); }
+static void b_to_euler_n_xyz(void) { quat_to_euler_n(be, bq1, N_BATCH, QUAT_EULER_XYZ); }
+
+static void b_from_euler_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_from_euler(&bqo[i], &be[i]);
+}
+
+static void b_from_euler_n(void) { quat_from_euler_n(bqo, be, N_BATCH, QUAT_EULER_ZYX); }
+
+static void b_integrate_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_integrate(&bqo[i], &bq1[i], &bomega[i], 0.001f);
+}
+
+static void b_integrate_n(void) { quat_integrate_n(bqo, bq1, bomega, 0.001f, N_BATCH); }
+
+static void b_exp_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_exp(&bqo[i], &bq1[i]);
+}
+
+static void b_exp_n(void) { quat_exp_n(bqo, bq1, N_BATCH); }
+
+static void b_log_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_log(&bqo[i], &bq1[i]);
+}
+
+static void b_log_n(void) { quat_log_n(bqo, bq1, N_BATCH); }
+
+static void b_pow_n(void) { quat_pow_n(bqo, bq1, bt, N_BATCH); }
+
+static void b_to_rh_rot_matrix(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_to_rh_rot_matrix(&bq1[i], &bm[i * 16]);
+}
+
+static void b_to_matrix_4x4(void)
+{
+   quat_to_matrix_n(bm, 16, bq1, NULL, N_BATCH, QUAT_MATRIX_4X4 | QUAT_MATRIX_COL_MAJOR);
+}
+
+static void b_to_matrix_3x4(void)
+{
+   quat_to_matrix_n(bm, 12, bq1, bv_in, N_BATCH, QUAT_MATRIX_3X4 | QUAT_MATRIX_UNIT);
+}
+
+static void b_to_matrix_3x3(void)
+{
+   quat_to_matrix_n(bm, 9, bq1, NULL, N_BATCH, QUAT_MATRIX_3X3 | QUAT_MATRIX_UNIT);
+}
+
+static void b_from_rh_rot_matrix(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_from_rh_rot_matrix(&bqo[i], &bm_in[i * 16]);
+}
+
+static void b_from_matrix_4x4(void)
+{
+   quat_from_matrix_n(bqo, bm_in, 16, N_BATCH, QUAT_MATRIX_4X4 | QUAT_MATRIX_COL_MAJOR);
+}
+
+static void b_xform_mul_loop(void)
+{
+   for (int i = 1; i < N_NODES; i++)
+      quat_xform_mul(&world[i], &world[bfs_parent[i]], &local[i]);
+}
+
+static void b_xform_bfs_1(void) { quat_xform_hierarchy(NULL, world, local, bfs_parent, N_NODES); }
+static void b_xform_bfs_4(void) { quat_xform_hierarchy(&pool4, world, local, bfs_parent, N_NODES); }
+static void b_xform_dfs_1(void) { quat_xform_hierarchy(NULL, world, local, dfs_parent, N_NODES); }
+
+static void b_dq_skin_loop(void)
+{
+   FOR_N(i, N_BATCH) {
+      quat_dq_t dq;
+      quat_dq_blend(&dq, palette, &bones[i * 4], &weights[i * 4], 4);
+      quat_dq_apply(&bv_out[i], &dq, &bv_in[i]);
+      quat_dq_rot(&bn_out[i], &dq, &bn_in[i]);
+   }
+}
+
+static void b_dq_skin_4(void)
+{
+   quat_dq_skin_n(NULL, bv_out, bn_out, bv_in, bn_in, bones, weights, 4, palette, N_BATCH);
+}
+
+static void b_dq_skin_4_mt(void)
+{
+   quat_dq_skin_n(&pool4, bv_out, bn_out, bv_in, bn_in, bones, weights, 4, palette, N_BATCH);
+}
+
+static void b_dq_skin_8(void)
+{
+   quat_dq_skin_n(NULL, bv_out, bn_out, bv_in, bn_in, bones, weights, 8, palette, N_BATCH);
+}
+
+static void b_wire_encode32_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      bw32[i] = quat_wire_encode32(&bq1[i]);
+}
+
+static void b_wire_decode32_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_wire_decode32(&bqo[i], bw32[i]);
+}
+
+static void b_wire_encode32_n(void) { quat_wire_encode32_n(bw32, bq1, N_BATCH); }
+static void b_wire_decode32_n(void) { quat_wire_decode32_n(bqo, bw32, N_BATCH); }
+static void b_wire_encode48_n(void) { quat_wire_encode48_n(bw48, bq1, N_BATCH); }
+static void b_wire_decode48_n(void) { quat_wire_decode48_n(bqo, bw48, N_BATCH); }
+static void b_wire_encode64_n(void) { quat_wire_encode64_n(bw64, bq1, N_BATCH); }
+static void b_wire_decode64_n(void) { quat_wire_decode64_n(bqo, bw64, N_BATCH); }
+
+static void b_trace_sample_n(void) { quat_trace_sample_n(&trace48, bqo, bts, N_BATCH, QUAT_TRACE_SLERP); }
+static void b_trace_sample_n_nlerp(void) { quat_trace_sample_n(&trace48, bqo, bts, N_BATCH, QUAT_TRACE_NLERP); }
+static void b_trace_sample_n_float(void) { quat_trace_sample_n(&trace_float, bqo, bts, N_BATCH, QUAT_TRACE_SLERP); }
+static void b_trace_sample_random(void) { quat_trace_sample_n(&trace48, bqo, btr, N_BATCH, QUAT_TRACE_SLERP); }
+
+static void b_steer_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_apply_relative_yaw_pitch_roll(&bqo[i], steer[0][i], steer[1][i], steer[2][i]);
+}
+
+static void b_store_steer_1(void)
+{
+   quat_store_apply_relative_yaw_pitch_roll(NULL, &store, steer[0], steer[1], steer[2]);
+}
+
+static void b_store_steer_4(void)
+{
+   quat_store_apply_relative_yaw_pitch_roll(&pool4, &store, steer[0], steer[1], steer[2]);
+}
+
+static void b_steer_yp_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_apply_relative_yaw_pitch(&bqo[i], steer[0][i], steer[1][i]);
+}
+
+static void b_store_steer_yp(void) { quat_store_apply_relative_yaw_pitch(NULL, &store, steer[0], steer[1]); }
+
+static void b_track_eval(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_track_eval(&track, &bqo[i], bt[i] * (N_KEYS - 1));
+}
+
+static void b_track_eval_n(void)
+{
+   /* bt scaled to the key range once per pass is part of the cost */
+   FOR_N(i, N_BATCH)
+      bf[i] = bt[i] * (N_KEYS - 1);
+   quat_track_eval_n(&track, bqo, bf, N_BATCH);
+}
+
+static void b_track_eval_tracks(void)
+{
+   FOR_N(i, N_BATCH / N_KEYS)
+      quat_track_eval_tracks(tracks, &bqo[i * N_KEYS], bt[i * N_KEYS] * (N_KEYS - 1), N_KEYS);
+}
+
+static void b_spline_eval(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_spline_eval(&spline, &bqo[i], bt[i] * (N_KEYS - 1));
+}
+
+static void b_spline_eval_n(void)
+{
+   FOR_N(i, N_BATCH)
+      bf[i] = bt[i] * (N_KEYS - 1);
+   quat_spline_eval_n(&spline, bqo, bf, N_BATCH);
+}
+
+static void b_spline_set_key(void)
+{
+   FOR_N(i, N_KEYS)
+      quat_spline_set_key(&spline, i, &keys[i]);
+}
+
+static void b_decompose_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_decompose_swing_twist(&bq1[i], &bv_in[i], &bswing[i], &btwist[i]);
+}
+
+static void b_decompose_n(void) { quat_decompose_swing_twist_n(bq1, bv_in, bswing, btwist, N_BATCH); }
+
+static void b_joint_clamp_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_joint_clamp(&joints[i], &bqo[i], &bq1[i]);
+}
+
+static void b_joint_clamp_n(void) { quat_joint_clamp_n(joints, bqo, bq1, N_BATCH); }
+
+static void b_from_u2v_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_from_u2v(&bqo[i], &bv_in[i], &bomega[i], NULL);
+}
+
+static void b_from_u2v_n(void) { quat_from_u2v_n(bqo, bv_in, bomega, NULL, N_BATCH); }
+
+/* turrets at bv_in aiming at bomega */
+static void b_look_at_loop(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_look_at(&bqo[i], &bv_in[i], &bomega[i], NULL);
+}
+
+static void b_look_at_n(void) { quat_look_at_n(bqo, bv_in, bomega, NULL, N_BATCH); }
+
+static void b_ahrs_update(void)
+{
+   FOR_N(i, N_BATCH)
+      quat_ahrs_update(&madgwick, &imu[i]);
+}
+
+static void b_madgwick_n(void) { quat_ahrs_update_n(&madgwick, imu, N_BATCH); }
+static void b_mahony_n(void) { quat_ahrs_update_n(&mahony, imu, N_BATCH); }
+static void b_ahrs_multi_1(void) { quat_ahrs_multi_update_n(NULL, &multi, streams, N_STREAM_SAMPLES); }
+static void b_ahrs_multi_4(void) { quat_ahrs_multi_update_n(&pool4, &multi, streams, N_STREAM_SAMPLES); }
+
+
+static const bench_t batch_benches[] =
+{
+   { "quat_rot_vec (loop)", b_rot_vec_loop, N_BATCH },
+   { "quat_rot_vec_n", b_rot_vec_n, N_BATCH },
+   { "quat_rot_vec_soa", b_rot_vec_soa, N_BATCH },
+   { "quat_mul_n", b_mul_n, N_BATCH },
+   { "quat_conj_n", b_conj_n, N_BATCH },
+   { "quat_normalize_n", b_normalize_n, N_BATCH },
+   { "quat_dot_n", b_dot_n, N_BATCH },
+   { "quat_slerp_fast", b_slerp_fast, N_BATCH },
+   { "quat_slerp_fast_n", b_slerp_fast_n, N_BATCH },
+   { "quat_integrate (loop)", b_integrate_loop, N_BATCH },
+   { "quat_integrate_n", b_integrate_n, N_BATCH },
+   { "quat_exp (loop)", b_exp_loop, N_BATCH },
+   { "quat_exp_n", b_exp_n, N_BATCH },
+   { "quat_log (loop)", b_log_loop, N_BATCH },
+   { "quat_log_n", b_log_n, N_BATCH },
+   { "quat_pow_n", b_pow_n, N_BATCH },
+   { "quat_mul_n (large)", b_pool_mul_1, N_POOL },
+   { "quat_pool_mul_n (large, 4 threads)", b_pool_mul_4, N_POOL },
+   { "quat_integrate_n (large)", b_pool_integrate_1, N_POOL },
+   { "quat_pool_integrate_n (large, 4 threads)", b_pool_integrate_4, N_POOL },
+   { "quat_avg_add (loop, large)", b_avg_add_loop, N_POOL },
+   { "quat_avg_add_n (large)", b_avg_add_n, N_POOL },
+   { "quat_avg_add_pool (large, 4 threads)", b_avg_add_pool_4, N_POOL },
+   { "nearest pose, brute force (large)", b_nn_brute, N_NN_QUERIES },
+   { "quat_nn_build (large)", b_nn_build, N_POOL },
+   { "quat_nn_knn (k=1, large)", b_nn_knn_1, N_NN_QUERIES },
+   { "quat_nn_knn_n (k=8, large)", b_nn_knn_n_8, N_BATCH },
+   { "quat_nn_knn_n (k=8, large, 4 threads)", b_nn_knn_n_8_4, N_BATCH },
+   { "quat_nn_within (0.1 rad, large)", b_nn_within, N_NN_QUERIES },
+   { "quat_to_euler (loop)", b_to_euler_loop, N_BATCH },
+   { "quat_to_euler_n (zyx)", b_to_euler_n, N_BATCH },
+   { "quat_to_euler_n (xyz)", b_to_euler_n_xyz, N_BATCH },
+   { "quat_from_euler (loop)", b_from_euler_loop, N_BATCH },
+   { "quat_from_euler_n (zyx)", b_from_euler_n, N_BATCH },
+   { "quat_to_rh_rot_matrix (loop)", b_to_rh_rot_matrix, N_BATCH },
+   { "quat_to_matrix_n (4x4)", b_to_matrix_4x4, N_BATCH },
+   { "quat_to_matrix_n (3x4, unit)", b_to_matrix_3x4, N_BATCH },
+   { "quat_to_matrix_n (3x3, unit)", b_to_matrix_3x3, N_BATCH },
+   { "quat_from_rh_rot_matrix (loop)", b_from_rh_rot_matrix, N_BATCH },
+   { "quat_from_matrix_n (4x4)", b_from_matrix_4x4, N_BATCH },
+   { "quat_xform_mul (hierarchy loop)", b_xform_mul_loop, N_NODES },
+   { "quat_xform_hierarchy (bfs, 1 thread)", b_xform_bfs_1, N_NODES },
+   { "quat_xform_hierarchy (bfs, 4 threads)", b_xform_bfs_4, N_NODES },
+   { "quat_xform_hierarchy (dfs, 1 thread)", b_xform_dfs_1, N_NODES },
+   { "quat_dq_blend + apply + rot (4 bones)", b_dq_skin_loop, N_BATCH },
+   { "quat_dq_skin_n (4 bones, 1 thread)", b_dq_skin_4, N_BATCH },
+   { "quat_dq_skin_n (4 bones, 4 threads)", b_dq_skin_4_mt, N_BATCH },
+   { "quat_dq_skin_n (8 bones, 1 thread)", b_dq_skin_8, N_BATCH },
+   { "quat_wire_encode32 (loop)", b_wire_encode32_loop, N_BATCH },
+   { "quat_wire_decode32 (loop)", b_wire_decode32_loop, N_BATCH },
+   { "quat_wire_encode32_n", b_wire_encode32_n, N_BATCH },
+   { "quat_wire_decode32_n", b_wire_decode32_n, N_BATCH },
+   { "quat_wire_encode48_n", b_wire_encode48_n, N_BATCH },
+   { "quat_wire_decode48_n", b_wire_decode48_n, N_BATCH },
+   { "quat_wire_encode64_n", b_wire_encode64_n, N_BATCH },
+   { "quat_wire_decode64_n", b_wire_decode64_n, N_BATCH },
+   { "quat_trace_sample_n (48 bit, slerp)", b_trace_sample_n, N_BATCH },
+   { "quat_trace_sample_n (48 bit, nlerp)", b_trace_sample_n_nlerp, N_BATCH },
+   { "quat_trace_sample_n (float, slerp)", b_trace_sample_n_float, N_BATCH },
+   { "quat_trace_sample (48 bit, random t)", b_trace_sample_random, N_BATCH },
+   { "quat_apply_relative_yaw_pitch_roll (loop)", b_steer_loop, N_BATCH },
+   { "quat_store yaw/pitch/roll (1 thread)", b_store_steer_1, N_BATCH },
+   { "quat_store yaw/pitch/roll (4 threads)", b_store_steer_4, N_BATCH },
+   { "quat_apply_relative_yaw_pitch (loop)", b_steer_yp_loop, N_BATCH },
+   { "quat_store yaw/pitch (1 thread)", b_store_steer_yp, N_BATCH },
+   { "quat_track_eval", b_track_eval, N_BATCH },
+   { "quat_track_eval_n", b_track_eval_n, N_BATCH },
+   { "quat_track_eval_tracks", b_track_eval_tracks, N_BATCH },
+   { "quat_spline_eval", b_spline_eval, N_BATCH },
+   { "quat_spline_eval_n", b_spline_eval_n, N_BATCH },
+   { "quat_spline_set_key", b_spline_set_key, N_KEYS },
+   { "quat_decompose_swing_twist (loop)", b_decompose_loop, N_BATCH },
+   { "quat_decompose_swing_twist_n", b_decompose_n, N_BATCH },
+   { "quat_joint_clamp (loop)", b_joint_clamp_loop, N_BATCH },
+   { "quat_joint_clamp_n", b_joint_clamp_n, N_BATCH },
+   { "quat_from_u2v (loop)", b_from_u2v_loop, N_BATCH },
+   { "quat_from_u2v_n", b_from_u2v_n, N_BATCH },
+   { "quat_look_at (loop)", b_look_at_loop, N_BATCH },
+   { "quat_look_at_n", b_look_at_n, N_BATCH },
+   { "quat_ahrs_update (madgwick)", b_ahrs_update, N_BATCH },
+   { "quat_ahrs_update_n (madgwick)", b_madgwick_n, N_BATCH },
+   { "quat_ahrs_update_n (mahony)", b_mahony_n, N_BATCH },
+   { "quat_ahrs_multi_update_n (1 thread)", b_ahrs_multi_1, N_BATCH },
+   { "quat_ahrs_multi_update_n (4 threads)", b_ahrs_multi_4, N_BATCH },
+   { NULL, NULL, 0 }
+};
+
+
+/* reports the function and element of a failed check and exits;
+   i < 0 for checks that are not about one element */
+static void mismatch(const char *name, long i) __attribute__((noreturn));
+
+static void mismatch(const char *name, long i)
+{
+   if (i >= 0)
+      fprintf(stderr, "%s: mismatch at %ld\n", name, i);
+   else
+      fprintf(stderr, "%s: mismatch\n", name);
+   exit(EXIT_FAILURE);
+}
+
+
+/* n elements of size bytes must be equal bit for bit */
+static void check_array(const char *name, const void *a, const void *b, size_t size, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      if (memcmp((const char *)a + i * size, (const char *)b + i * size, size))
+         mismatch(name, (long)i);
+}
+
+
+/* batch functions must give the same results as the scalar ones */
+static void verify(void)
+{
+   /* vector rotation, both layouts, and the packet arithmetic on a
+      partial last packet; normalize on quaternions of other lengths */
+   {
+      static float xo[N_BATCH], yo[N_BATCH], zo[N_BATCH], d[N_BATCH];
+      static quat_t q[N_BATCH];
+      size_t n = N_BATCH - 3;
+      quat_rot_vec_n(bv_out, bv_in, &bq2[0], n);
+      quat_rot_vec_soa(xo, yo, zo, bx, by, bz, &bq2[0], n);
+      FOR_N(i, n) {
+         vec3_t v;
+         quat_rot_vec(&v, &bv_in[i], &bq2[0]);
+         if (memcmp(&v, &bv_out[i], sizeof(v)))
+            mismatch("quat_rot_vec_n", i);
+         if (v.x != xo[i] || v.y != yo[i] || v.z != zo[i])
+            mismatch("quat_rot_vec_soa", i);
+      }
+      FOR_N(i, n)
+         quat_mul(&q[i], &bq1[i], &bq2[i]);
+      quat_mul_n(bqo, bq1, bq2, n);
+      check_array("quat_mul_n", q, bqo, sizeof(quat_t), n);
+      FOR_N(i, n)
+         quat_conj(&q[i], &bq1[i]);
+      quat_conj_n(bqo, bq1, n);
+      check_array("quat_conj_n", q, bqo, sizeof(quat_t), n);
+      FOR_N(i, n) {
+         quat_scale(&bqo[i], &bq2[i], 0.25f + (float)(i % 7));
+         quat_normalize(&q[i], &bqo[i]);
+      }
+      quat_normalize_n(bqo, bqo, n);
+      check_array("quat_normalize_n", q, bqo, sizeof(quat_t), n);
+      quat_dot_n(d, bq1, bq2, n);
+      FOR_N(i, n)
+         if (d[i] != quat_dot(&bq1[i], &bq2[i]))
+            mismatch("quat_dot_n", i);
+   }
+   quat_slerp_fast_n(bqo, bq1, bq2, bt, N_BATCH);
+   FOR_N(i, N_BATCH) {
+      quat_t q;
+      quat_slerp_fast(&q, &bq1[i], &bq2[i], bt[i]);
+      if (memcmp(&q, &bqo[i], sizeof(q)))
+         mismatch("quat_slerp_fast_n", i);
+   }
+   /* matrices: 4x4 column major against the scalar functions, row major
+      3x4 with translations and an odd stride against the transposed 4x4 */
+   FOR_N(lh, 2) {
+      unsigned int flags = QUAT_MATRIX_COL_MAJOR | (lh ? QUAT_MATRIX_LH : 0);
+      quat_to_matrix_n(bm, 16, bq2, NULL, N_BATCH - 1, QUAT_MATRIX_4X4 | flags);
+      FOR_N(i, N_BATCH - 1) {
+         float ref[16];
+         (lh ? quat_to_lh_rot_matrix : quat_to_rh_rot_matrix)(&bq2[i], ref);
+         if (memcmp(ref, &bm[i * 16], sizeof(ref)))
+            mismatch("quat_to_matrix_n", i);
+      }
+   }
+   quat_to_matrix_n(bm, 13, bq2, bv_in, N_BATCH - 1, QUAT_MATRIX_3X4);
+   FOR_N(i, N_BATCH - 1) {
+      float ref[16];
+      quat_to_rh_rot_matrix(&bq2[i], ref);
+      FOR_N(r, 3) {
+         FOR_N(c, 3)
+            if (bm[i * 13 + r * 4 + c] != ref[c * 4 + r])
+               mismatch("quat_to_matrix_n", i);
+         if (bm[i * 13 + r * 4 + 3] != bv_in[i].vec[r])
+            mismatch("quat_to_matrix_n", i);
+      }
+   }
+   /* back to quaternions, from both handednesses and the 3x4 layout */
+   FOR_N(lh, 2) {
+      unsigned int flags = QUAT_MATRIX_4X4 | QUAT_MATRIX_COL_MAJOR | (lh ? QUAT_MATRIX_LH : 0);
+      quat_to_matrix_n(bm, 16, bq2, NULL, N_BATCH, flags);
+      quat_from_matrix_n(bqo, bm, 16, N_BATCH - 1, flags);
+      FOR_N(i, N_BATCH - 1) {
+         quat_t q;
+         (lh ? quat_from_lh_rot_matrix : quat_from_rh_rot_matrix)(&q, &bm[i * 16]);
+         if (memcmp(&q, &bqo[i], sizeof(q)))
+            mismatch("quat_from_matrix_n", i);
+      }
+   }
+   quat_to_matrix_n(bm, 13, bq2, bv_in, N_BATCH - 1, QUAT_MATRIX_3X4);
+   quat_from_matrix_n(bqo, bm, 13, N_BATCH - 1, QUAT_MATRIX_3X4);
+   quat_to_matrix_n(bm, 16, bq2, NULL, N_BATCH - 1, QUAT_MATRIX_4X4 | QUAT_MATRIX_COL_MAJOR);
+   FOR_N(i, N_BATCH - 1) {
+      quat_t q;
+      quat_from_rh_rot_matrix(&q, &bm[i * 16]);
+      if (memcmp(&q, &bqo[i], sizeof(q)))
+         mismatch("quat_from_matrix_n", i);
+   }
+   /* hierarchies against one quat_xform_mul per node, on a pool of 3 threads */
+   FOR_N(dfs, 2) {
+      const int *parent = dfs ? dfs_parent : bfs_parent;
+      quat_pool_t p;
+      if (quat_pool_init(&p, 3))
+         mismatch("quat_pool_init", 3);
+      quat_xform_hierarchy(&p, world, local, parent, N_NODES - 5);
+      quat_pool_destroy(&p);
+      FOR_N(i, N_NODES - 5) {
+         quat_xform_t x = local[i];
+         if (parent[i] >= 0)
+            quat_xform_mul(&x, &world[parent[i]], &local[i]);
+         if (memcmp(&x, &world[i], sizeof(x)))
+            mismatch("quat_xform_hierarchy", i);
+      }
+   }
+   /* skinning with 3 and 8 influences, a pool of 3 threads, partial lane group */
+   for (int k = 3; k <= 8; k += 5) {
+      quat_pool_t p;
+      if (quat_pool_init(&p, 3))
+         mismatch("quat_pool_init", 3);
+      quat_dq_skin_n(&p, bv_out, bn_out, bv_in, bn_in, bones, weights, k, palette, N_BATCH - 3);
+      quat_pool_destroy(&p);
+      FOR_N(i, N_BATCH - 3) {
+         quat_dq_t dq;
+         vec3_t p, n;
+         quat_dq_blend(&dq, palette, &bones[i * k], &weights[i * k], k);
+         quat_dq_apply(&p, &dq, &bv_in[i]);
+         quat_dq_rot(&n, &dq, &bn_in[i]);
+         if (memcmp(&p, &bv_out[i], sizeof(p)) || memcmp(&n, &bn_out[i], sizeof(n)))
+            mismatch("quat_dq_skin_n", i);
+      }
+   }
+   /* wire formats, with ties and negative largest components in front */
+   {
+      static const quat_t special[] =
+      {
+         { .w = 1.0f }, { .y = -1.0f }, { .w = 0.5f, .x = -0.5f, .y = 0.5f, .z = -0.5f },
+         { .w = -0.5f, .x = -0.5f, .y = -0.5f, .z = -0.5f },
+         { .x = 0.70710678f, .z = -0.70710678f }, { .w = -0.6f, .x = 0.8f }
+      };
+      size_t n = N_BATCH - 3;
+      memcpy(bqo, bq2, sizeof(bq2));
+      memcpy(bqo, special, sizeof(special));
+      quat_wire_encode32_n(bw32, bqo, n);
+      quat_wire_encode48_n(bw48, bqo, n);
+      quat_wire_encode64_n(bw64, bqo, n);
+      FOR_N(i, n) {
+         quat_wire48_t c48 = quat_wire_encode48(&bqo[i]);
+         if (bw32[i] != quat_wire_encode32(&bqo[i]))
+            mismatch("quat_wire_encode32_n", i);
+         if (memcmp(&c48, &bw48[i], sizeof(c48)))
+            mismatch("quat_wire_encode48_n", i);
+         if (bw64[i] != quat_wire_encode64(&bqo[i]))
+            mismatch("quat_wire_encode64_n", i);
+      }
+      FOR_N(f, 3) {
+         static const char *name[] = { "quat_wire_decode32_n", "quat_wire_decode48_n", "quat_wire_decode64_n" };
+         if (f == 0)
+            quat_wire_decode32_n(bqo, bw32, n);
+         else if (f == 1)
+            quat_wire_decode48_n(bqo, bw48, n);
+         else
+            quat_wire_decode64_n(bqo, bw64, n);
+         FOR_N(i, n) {
+            quat_t q;
+            if (f == 0)
+               quat_wire_decode32(&q, bw32[i]);
+            else if (f == 1)
+               quat_wire_decode48(&q, bw48[i]);
+            else
+               quat_wire_decode64(&q, bw64[i]);
+            if (memcmp(&q, &bqo[i], sizeof(q)))
+               mismatch(name[f], i);
+         }
+      }
+   }
+   /* trace files: stored samples, then sampling at random times and
+      outside the trace against a linear search */
+   FOR_N(f, 2) {
+      quat_trace_t *tr = f ? &trace_float : &trace48;
+      static quat_t tq[N_TRACE];
+      static double tt[N_TRACE];
+      if (quat_trace_count(tr) != N_TRACE || quat_trace_get(tr, N_TRACE, NULL, NULL) != -1)
+         mismatch("quat_trace_get", N_TRACE);
+      FOR_N(i, N_TRACE) {
+         quat_t q = bq1[i % N_BATCH];
+         if (!f)
+            quat_wire_decode48(&q, quat_wire_encode48(&q));
+         quat_trace_get(tr, i, &tt[i], &tq[i]);
+         if (memcmp(&q, &tq[i], sizeof(q)) || fabs(tt[i] - trace_t[i]) > 0.6e-6)
+            mismatch("quat_trace_get", i);
+      }
+      FOR_N(interp, 2) {
+         size_t j = 0;
+         bts[0] = 0.0;
+         bts[N_BATCH - 1] = 1.0e9;
+         quat_trace_sample_n(tr, bqo, bts, N_BATCH, interp);
+         FOR_N(i, N_BATCH) {
+            double t = bts[i];
+            quat_t q;
+            while (j + 1 < N_TRACE && tt[j + 1] <= t)
+               j++;
+            if (t <= tt[0])
+               q = tq[0];
+            else if (j + 1 == N_TRACE)
+               q = tq[j];
+            else {
+               float u = (float)((t - tt[j]) / (tt[j + 1] - tt[j]));
+               if (interp == QUAT_TRACE_NLERP)
+                  quat_nlerp(&q, &tq[j], &tq[j + 1], u);
+               else
+                  quat_slerp(&q, &tq[j], &tq[j + 1], u);
+            }
+            if (memcmp(&q, &bqo[i], sizeof(q)))
+               mismatch("quat_trace_sample_n", i);
+         }
+         bts[0] = 100.001;
+         bts[N_BATCH - 1] = 100.0 + 0.04 * (N_BATCH - 1) + 0.001;
+      }
+   }
+   /* a time just below t_last that rounds onto the last sample */
+   {
+      char path[] = "/tmp/quat_bench_XXXXXX";
+      quat_trace_writer_t w;
+      quat_trace_t tr;
+      quat_t q;
+      int fd = mkstemp(path);
+      if (fd < 0)
+         mismatch("quat_trace_writer_open", -1);
+      close(fd);
+      int err = quat_trace_writer_open(&w, path, QUAT_TRACE_FLOAT, 1.0e-6, N_TRACE_BLOCK)
+         || quat_trace_writer_append(&w, 0.0, &bq1[0])
+         || quat_trace_writer_append(&w, 3.0e-6, &bq1[1])
+         || quat_trace_writer_close(&w) || quat_trace_open(&tr, path);
+      unlink(path);
+      if (err)
+         mismatch("quat_trace_open", -1);
+      quat_trace_sample(&tr, &q, 2.9999999999999997e-06, QUAT_TRACE_SLERP);
+      quat_trace_close(&tr);
+      if (memcmp(&q, &bq1[1], sizeof(q)))
+         mismatch("quat_trace_sample", 1);
+   }
+   /* euler conversions: a partial last packet gives the same results as
+      a full one, yaw wrapping only adds 2 pi to negative yaws */
+   FOR_N(order, 6) {
+      static quat_t q[N_BATCH];
+      size_t n = N_BATCH - 3;
+      quat_to_euler_n(be, bq1, N_BATCH, order);
+      quat_to_euler_n(be2 + 1, bq1 + 1, n, order | QUAT_EULER_YAW_0_2PI);
+      FOR_N(i, n) {
+         euler_t e = be[i + 1];
+         if (e.yaw < 0.0f)
+            e.yaw += 6.283185307f;
+         if (memcmp(&e, &be2[i + 1], sizeof(e)) || !(e.yaw >= 0.0f && e.yaw <= 6.283185307f))
+            mismatch("quat_to_euler_n", i + 1);
+      }
+      quat_from_euler_n(bqo, be, N_BATCH, order);
+      quat_from_euler_n(q + 1, be + 1, n, order);
+      check_array("quat_from_euler_n", q + 1, bqo + 1, sizeof(quat_t), n);
+   }
+   /* unknown orders are refused */
+   if (quat_to_euler_n(be, bq1, 1, 6) != -1 || quat_to_euler_n(be, bq1, 1, 0x20) != -1)
+      mismatch("quat_to_euler_n", -1);
+   if (quat_from_euler_n(bqo, be, 1, 6) != -1 || quat_from_euler_n(bqo, be, 1, 0x20) != -1)
+      mismatch("quat_from_euler_n", -1);
+   /* exponential map: a partial last packet and in place outputs give
+      the results of a full packet, integrate stays near the scalar one */
+   FOR_N(op, 4) {
+      static const char *name[] = { "quat_exp_n", "quat_log_n", "quat_pow_n", "quat_integrate_n" };
+      static quat_t q[N_BATCH];
+      size_t n = N_BATCH - 3;
+      memcpy(q, bq1, sizeof(q));
+      if (op == 0) {
+         quat_exp_n(bqo, bq1, N_BATCH);
+         quat_exp_n(q + 1, q + 1, n);
+      } else if (op == 1) {
+         quat_log_n(bqo, bq1, N_BATCH);
+         quat_log_n(q + 1, q + 1, n);
+      } else if (op == 2) {
+         quat_pow_n(bqo, bq1, bt, N_BATCH);
+         quat_pow_n(q + 1, q + 1, bt + 1, n);
+      } else {
+         quat_integrate_n(bqo, bq1, bomega, 0.001f, N_BATCH);
+         quat_integrate_n(q + 1, q + 1, bomega + 1, 0.001f, n);
+      }
+      check_array(name[op], q + 1, bqo + 1, sizeof(quat_t), n);
+   }
+   FOR_N(i, N_BATCH) {
+      quat_t q;
+      quat_integrate(&q, &bq1[i], &bomega[i], 0.001f);
+      FOR_N(c, 4)
+         if (fabsf(q.vec[c] - bqo[i].vec[c]) > 1.0e-6f)
+            mismatch("quat_integrate_n", i);
+   }
+   /* pools of 1 to 5 threads and no pool, on an odd number of elements */
+   FOR_N(t, 6) {
+      static quat_t ref[N_POOL];
+      static vec3_t vref[N_POOL], vo[N_POOL];
+      quat_pool_t p;
+      size_t n = N_POOL - 5;
+      if (t && quat_pool_init(&p, t))
+         mismatch("quat_pool_init", t);
+      quat_mul_n(ref, pq1, pq2, n);
+      quat_pool_mul_n(t ? &p : NULL, pqo, pq1, pq2, n);
+      check_array("quat_pool_mul_n", ref, pqo, sizeof(quat_t), n);
+      quat_integrate_n(ref, pq1, pomega, 0.001f, n);
+      quat_pool_integrate_n(t ? &p : NULL, pqo, pq1, pomega, 0.001f, n);
+      check_array("quat_pool_integrate_n", ref, pqo, sizeof(quat_t), n);
+      quat_normalize_n(ref, pq2, n);
+      quat_pool_normalize_n(t ? &p : NULL, pqo, pq2, n);
+      check_array("quat_pool_normalize_n", ref, pqo, sizeof(quat_t), n);
+      quat_slerp_fast_n(ref, pq1, pq2, bt, N_BATCH);
+      quat_pool_slerp_fast_n(t ? &p : NULL, pqo, pq1, pq2, bt, N_BATCH);
+      check_array("quat_pool_slerp_fast_n", ref, pqo, sizeof(quat_t), N_BATCH);
+      FOR_N(i, n)
+         vo[i] = pomega[i];
+      quat_rot_vec_n(vref, pomega, &pq1[0], n);
+      quat_pool_rot_vec_n(t ? &p : NULL, vo, vo, &pq1[0], n);
+      check_array("quat_pool_rot_vec_n", vref, vo, sizeof(vec3_t), n);
+      if (t)
+         quat_pool_destroy(&p);
+   }
+   /* averager: pools of 0 to 4 threads with weights give the same sums,
+      arrays and single samples the same mean, and sign flips no change */
+   {
+      static quat_t cq[N_POOL];
+      static float w[N_POOL];
+      quat_avg_t ref, a;
+      quat_t m1, m2;
+      size_t n = N_POOL - 5;
+      FOR_N(i, n) {
+         w[i] = (float)(i % 7) + 0.5f;
+         quat_integrate(&cq[i], &bq1[0], &pomega[i], 0.02f);
+      }
+      FOR_N(t, 5) {
+         quat_pool_t p;
+         if (t && quat_pool_init(&p, t))
+            mismatch("quat_pool_init", t);
+         quat_avg_init(&a);
+         if (quat_avg_add_pool(t ? &p : NULL, &a, cq, w, n))
+            mismatch("quat_avg_add_pool", t);
+         if (t)
+            quat_pool_destroy(&p);
+         if (!t)
+            ref = a;
+         else if (memcmp(&ref, &a, sizeof(a)))
+            mismatch("quat_avg_add_pool", t);
+      }
+      quat_avg_init(&a);
+      FOR_N(i, n)
+         quat_avg_add(&a, &cq[i], w[i]);
+      if (a.n != n || quat_avg_get(&ref, &m1) || quat_avg_get(&a, &m2))
+         mismatch("quat_avg_add", -1);
+      FOR_N(c, 4)
+         if (fabsf(m1.vec[c] - m2.vec[c]) > 1.0e-6f)
+            mismatch("quat_avg_get", c);
+      FOR_N(i, n)
+         if (i % 3 == 0)
+            quat_scale_self(&cq[i], -1.0f);
+      quat_avg_init(&a);
+      quat_avg_add_pool(NULL, &a, cq, w, n);
+      if (memcmp(&ref, &a, sizeof(a)))
+         mismatch("quat_avg_add_pool", -1);
+      quat_avg_init(&a);
+      if (quat_avg_get(&a, &m2) != -1)
+         mismatch("quat_avg_get", -1);
+   }
+   /* nearest neighbour index: k nearest and within-angle queries against
+      brute force on an odd size, sign flipped queries, pools and a
+      serialized copy */
+   {
+      static quat_nn_node_t nodes[N_BATCH];
+      static quat_nn_hit_t h1[N_BATCH * N_NN_K], h2[N_BATCH * N_NN_K];
+      static uint64_t buf[(sizeof(quat_nn_header_t) + sizeof(nodes)) / 8 + 1];
+      quat_nn_t t, t2;
+      size_t n = N_BATCH - 3, nq = 256;
+      if (quat_nn_build(&t, nodes, nnq, n))
+         mismatch("quat_nn_build", -1);
+      FOR_N(i, nq) {
+         quat_t q = bq2[i];
+         float angle[N_NN_K], limit = 0.2f;
+         size_t within = 0;
+         if (quat_nn_knn(&t, &q, N_NN_K, h1) != N_NN_K)
+            mismatch("quat_nn_knn", i);
+         /* the k smallest angles, by insertion into a sorted list */
+         FOR_N(j, N_NN_K)
+            angle[j] = INFINITY;
+         FOR_N(j, n) {
+            float a = nn_ref_angle(&q, &nnq[j]);
+            within += a <= limit;
+            for (int m = N_NN_K - 1; m >= 0 && a < angle[m]; m--) {
+               if (m + 1 < N_NN_K)
+                  angle[m + 1] = angle[m];
+               angle[m] = a;
+            }
+         }
+         FOR_N(j, N_NN_K)
+            if (h1[j].id >= n || fabsf(h1[j].angle - angle[j]) > 1.0e-5f
+                || fabsf(h1[j].angle - nn_ref_angle(&q, &nnq[h1[j].id])) > 1.0e-5f)
+               mismatch("quat_nn_knn", i);
+         quat_scale_self(&q, -1.0f);
+         if (quat_nn_knn(&t, &q, N_NN_K, h2) != N_NN_K || memcmp(h1, h2, sizeof(h1[0]) * N_NN_K))
+            mismatch("quat_nn_knn", i);
+         /* angles within rounding of the limit may go either way */
+         size_t found = quat_nn_within(&t, &q, limit, h2, N_BATCH);
+         if (found + 2 < within || found > within + 2)
+            mismatch("quat_nn_within", i);
+         FOR_N(j, found)
+            if (h2[j].angle > limit + 1.0e-5f)
+               mismatch("quat_nn_within", i);
+      }
+      if (quat_nn_knn(&t, &bq2[0], N_BATCH, h1) != n)
+         mismatch("quat_nn_knn", -1);
+      quat_nn_knn_n(NULL, &t, bq2, N_BATCH, N_NN_K, h1);
+      FOR_N(i, N_BATCH)
+         if (quat_nn_knn(&t, &bq2[i], N_NN_K, h2) != N_NN_K
+             || memcmp(h2, &h1[i * N_NN_K], sizeof(h2[0]) * N_NN_K))
+            mismatch("quat_nn_knn_n", i);
+      if (quat_nn_save(&t, buf, quat_nn_size(&t) - 1) != -1 || quat_nn_save(&t, buf, sizeof(buf))
+          || quat_nn_load(&t2, buf, quat_nn_size(&t) - 1) != -1 || quat_nn_load(&t2, buf, sizeof(buf)))
+         mismatch("quat_nn_save", -1);
+      FOR_N(threads, 4) {
+         quat_pool_t p;
+         if (quat_pool_init(&p, threads + 1))
+            mismatch("quat_pool_init", threads + 1);
+         quat_nn_knn_n(&p, &t2, bq2, N_BATCH, N_NN_K, h2);
+         quat_pool_destroy(&p);
+         check_array("quat_nn_knn_n", h1, h2, sizeof(h1[0]), N_BATCH * N_NN_K);
+      }
+   }
+   /* keyframe track: forward and backward playback and random seeks
+      against quat_slerp on the key pair found by a linear search, with
+      the cursor on that pair; clamping before the first and after the
+      last key; both batch forms against quat_track_eval */
+   {
+      static quat_seg_t sg[N_KEYS];
+      static quat_key_t k[N_KEYS];
+      static quat_track_t trs[N_KEYS];
+      quat_track_t tr;
+      size_t n = N_BATCH - 3;
+      k[0].t = -2.0f;
+      k[0].q = bq1[0];
+      for (int i = 1; i < N_KEYS; i++) {
+         k[i].t = k[i - 1].t + 0.25f + 0.5f * (float)(i % 3);
+         k[i].q = bq1[i];
+      }
+      if (quat_track_init(&tr, sg, k, N_KEYS))
+         mismatch("quat_track_init", -1);
+      float t0 = k[0].t - 1.0f, span = k[N_KEYS - 1].t + 1.0f - t0;
+      FOR_N(pass, 3) {
+         FOR_N(i, n) {
+            float u = (float)i / (float)(n - 1);
+            bf[i] = t0 + span * (pass == 0 ? u : pass == 1 ? 1.0f - u : 0.5f * (float)(rnd() + 1.0));
+         }
+         FOR_N(i, n) {
+            float t = bf[i];
+            int j = 0;
+            quat_t q, e;
+            while (j + 1 < N_KEYS && k[j + 1].t <= t)
+               j++;
+            quat_track_eval(&tr, &q, t);
+            if (t <= k[0].t)
+               e = k[0].q;
+            else if (j == N_KEYS - 1)
+               e = k[j].q;
+            else
+               quat_slerp(&e, &k[j].q, &k[j + 1].q, (t - k[j].t) / (k[j + 1].t - k[j].t));
+            if (tr.cursor != j || 1.0f - fabsf(quat_dot(&q, &e)) > 1.0e-6f
+                || (j == N_KEYS - 1 && memcmp(&q, &e, sizeof(q))))
+               mismatch("quat_track_eval", i);
+         }
+      }
+      quat_track_eval_n(&tr, bqo, bf, n);
+      FOR_N(i, n) {
+         quat_t q;
+         quat_track_eval(&tr, &q, bf[i]);
+         if (memcmp(&q, &bqo[i], sizeof(q)))
+            mismatch("quat_track_eval_n", i);
+      }
+      FOR_N(i, N_KEYS) {
+         trs[i] = tr;
+         trs[i].cursor = i;
+      }
+      FOR_N(i, 16) {
+         quat_t q;
+         quat_track_eval_tracks(trs, bqo, bf[i], N_KEYS);
+         quat_track_eval(&tr, &q, bf[i]);
+         FOR_N(m, N_KEYS)
+            if (memcmp(&q, &bqo[m], sizeof(q)))
+               mismatch("quat_track_eval_tracks", m);
+      }
+   }
+   /* spline: through the keys, the batch evaluator against the scalar one
+      on a partial vector, and key edits against building anew */
+   {
+      static quat_spline_seg_t sg[N_KEYS], sg2[N_KEYS];
+      static quat_key_t k[N_KEYS];
+      quat_spline_t sp, sp2;
+      size_t n = N_BATCH - 3;
+      k[0].t = 0.0f;
+      k[0].q = bq1[0];
+      for (int i = 1; i < N_KEYS; i++) {
+         k[i].t = k[i - 1].t + 0.5f + 0.5f * (float)(i % 3);
+         quat_integrate(&k[i].q, &k[i - 1].q, &bomega[i], 0.1f);
+      }
+      if (quat_spline_init(&sp, sg, k, N_KEYS))
+         mismatch("quat_spline_init", -1);
+      FOR_N(i, N_KEYS) {
+         quat_t q;
+         quat_spline_eval(&sp, &q, k[i].t);
+         FOR_N(c, 4)
+            if (fabsf(q.vec[c] - k[i].q.vec[c]) > 1.0e-6f)
+               mismatch("quat_spline_eval", i);
+      }
+      FOR_N(i, n)
+         bf[i] = (bt[i] * 1.1f - 0.05f) * k[N_KEYS - 1].t;
+      quat_spline_eval_n(&sp, bqo, bf, n);
+      FOR_N(i, n) {
+         quat_t q;
+         quat_spline_eval(&sp, &q, bf[i]);
+         FOR_N(c, 4)
+            if (fabsf(q.vec[c] - bqo[i].vec[c]) > 1.0e-6f)
+               mismatch("quat_spline_eval_n", i);
+      }
+      FOR_N(e, 3) {
+         int i = e == 0 ? 0 : e == 1 ? N_KEYS / 2 : N_KEYS - 1;
+         k[i].q = bq2[i];
+         k[i].t += 0.25f;
+         if (quat_spline_set_key(&sp, i, &k[i]) || quat_spline_init(&sp2, sg2, k, N_KEYS)
+             || memcmp(sg, sg2, sizeof(sg)))
+            mismatch("quat_spline_set_key", i);
+      }
+      k[1].t = k[2].t;
+      if (quat_spline_set_key(&sp, 1, &k[1]) != -1 || quat_spline_set_key(&sp, N_KEYS, &k[1]) != -1)
+         mismatch("quat_spline_set_key", 1);
+   }
+   /* swing-twist: both batch decompositions against the scalar ones on
+      a partial vector; joint limits: clamped rotations within the limits
+      and close to the scalar result, rotations inside left unchanged */
+   {
+      size_t n = N_BATCH - 3;
+      FOR_N(twist_first, 2) {
+         if (twist_first)
+            quat_decompose_twist_swing_n(bq1, bv_in, btwist, bswing, n);
+         else
+            quat_decompose_swing_twist_n(bq1, bv_in, bswing, btwist, n);
+         FOR_N(i, n) {
+            quat_t sw, tw;
+            if (twist_first)
+               quat_decompose_twist_swing(&bq1[i], &bv_in[i], &tw, &sw);
+            else
+               quat_decompose_swing_twist(&bq1[i], &bv_in[i], &sw, &tw);
+            FOR_N(c, 4)
+               if (fabsf(sw.vec[c] - bswing[i].vec[c]) > 1.0e-6f || fabsf(tw.vec[c] - btwist[i].vec[c]) > 1.0e-6f)
+                  mismatch(twist_first ? "quat_decompose_twist_swing_n" : "quat_decompose_swing_twist_n", i);
+         }
+      }
+      size_t clamped = quat_joint_clamp_n(joints, bqo, bq1, n);
+      if (clamped == 0 || clamped == n)
+         mismatch("quat_joint_clamp_n", -1);
+      FOR_N(i, n) {
+         const quat_joint_t *j = &joints[i];
+         quat_t q, sw, tw;
+         int bits = quat_joint_clamp(j, &q, &bq1[i]);
+         if (!bits && memcmp(&q, &bq1[i], sizeof(q)))
+            mismatch("quat_joint_clamp", i);
+         float sign = quat_dot(&q, &bqo[i]) < 0.0f ? -1.0f : 1.0f;
+         FOR_N(c, 4)
+            if (fabsf(q.vec[c] - sign * bqo[i].vec[c]) > 1.0e-6f)
+               mismatch("quat_joint_clamp_n", i);
+         quat_decompose_swing_twist(&bqo[i], &j->axis, &sw, &tw);
+         float ts = tw.x * j->axis.x + tw.y * j->axis.y + tw.z * j->axis.z;
+         if (tw.w < 0.0f)
+            ts = -ts;
+         if (sw.w < j->swing_cos - 1.0e-6f || ts > j->twist_max_sin + 1.0e-6f
+             || ts < j->twist_min_sin - 1.0e-6f)
+            mismatch("quat_joint_clamp_n", i);
+      }
+      quat_joint_t j;
+      vec3_t zero = { { 0.0f, 0.0f, 0.0f } };
+      if (quat_joint_init(&j, &bv_in[0], 4.0f, 0.0f, 0.0f) != -1 || quat_joint_init(&j, &bv_in[0], 1.0f, 0.5f, 0.0f) != -1
+          || quat_joint_init(&j, &zero, 1.0f, 0.0f, 0.0f) != -1)
+         mismatch("quat_joint_init", -1);
+      /* twist ranges without 0: an out of range twist goes to the limit
+         nearer around the circle, { min, max, twist, expected } in degrees */
+      static const float limits[4][4] =
+      {
+         { -170.0f, -160.0f, 179.0f, -170.0f },
+         { -170.0f, -160.0f, -150.0f, -160.0f },
+         { -30.0f, 150.0f, -170.0f, 150.0f },
+         { -30.0f, 150.0f, -60.0f, -30.0f },
+      };
+      FOR_N(i, 4) {
+         const float deg = (float)M_PI / 180.0f;
+         quat_t q, e;
+         if (quat_joint_init(&j, &bv_in[i], 1.0f, limits[i][0] * deg, limits[i][1] * deg))
+            mismatch("quat_joint_init", i);
+         float a = 0.5f * limits[i][2] * deg, b = 0.5f * limits[i][3] * deg;
+         q.w = cosf(a);
+         q.x = sinf(a) * j.axis.x;
+         q.y = sinf(a) * j.axis.y;
+         q.z = sinf(a) * j.axis.z;
+         e.w = cosf(b);
+         e.x = sinf(b) * j.axis.x;
+         e.y = sinf(b) * j.axis.y;
+         e.z = sinf(b) * j.axis.z;
+         if (quat_joint_clamp(&j, &q, &q) != QUAT_JOINT_TWIST)
+            mismatch("quat_joint_clamp", i);
+         float sign = quat_dot(&q, &e) < 0.0f ? -1.0f : 1.0f;
+         FOR_N(c, 4)
+            if (fabsf(q.vec[c] - sign * e.vec[c]) > 1.0e-6f)
+               mismatch("quat_joint_clamp", i);
+      }
+   }
+   /* aiming: both batch functions against the scalar ones on a partial
+      vector, with and without up vectors; half turns for antiparallel
+      vectors and targets straight behind */
+   {
+      size_t n = N_BATCH - 3;
+      FOR_N(look, 2)
+         FOR_N(with_up, 2) {
+            const vec3_t *up = with_up ? bn_in : NULL;
+            if (look)
+               quat_look_at_n(bqo, bv_in, bomega, up, n);
+            else
+               quat_from_u2v_n(bqo, bv_in, bomega, up, n);
+            FOR_N(i, n) {
+               quat_t q;
+               if (look)
+                  quat_look_at(&q, &bv_in[i], &bomega[i], up ? &up[i] : NULL);
+               else
+                  quat_from_u2v(&q, &bv_in[i], &bomega[i], up ? &up[i] : NULL);
+               float sign = quat_dot(&q, &bqo[i]) < 0.0f ? -1.0f : 1.0f;
+               FOR_N(c, 4)
+                  if (fabsf(q.vec[c] - sign * bqo[i].vec[c]) > 1.0e-6f)
+                     mismatch(look ? "quat_look_at_n" : "quat_from_u2v_n", i);
+            }
+         }
+      vec3_t u[8], v[8], pos[8], up[8];
+      quat_t q[8];
+      FOR_N(i, 8) {
+         u[i] = bv_in[i];
+         vec3_init(&v[i], -2.0f * u[i].x, -2.0f * u[i].y, -2.0f * u[i].z);
+         vec3_init(&pos[i], 0.0f, 0.0f, 0.0f);
+         vec3_init(&up[i], 0.0f, 1.0f, 0.0f);
+      }
+      vec3_init(&v[0], 1.0f, 0.0f, 0.0f);
+      vec3_init(&u[0], -1.0f, 0.0f, 0.0f);
+      quat_from_u2v_n(q, u, v, up, 8);
+      if (fabsf(q[0].w) > 1.0e-6f || fabsf(fabsf(q[0].y) - 1.0f) > 1.0e-6f)
+         mismatch("quat_from_u2v_n", 0);
+      FOR_N(i, 8) {
+         vec3_t r, side;
+         quat_rot_vec(&r, &u[i], &q[i]);
+         vec3_cross(&side, &u[i], &up[i]);
+         if (fabsf(q[i].w) > 1.0e-6f
+             || fabsf(q[i].x * side.x + q[i].y * side.y + q[i].z * side.z) > 1.0e-5f * sqrtf(vec3_len2(&side)))
+            mismatch("quat_from_u2v_n", i);
+         FOR_N(c, 3)
+            if (fabsf(r.vec[c] + u[i].vec[c]) > 1.0e-5f)
+               mismatch("quat_from_u2v_n", i);
+      }
+      quat_look_at_n(q, pos, u, NULL, 8);
+      if (fabsf(q[0].w) > 1.0e-6f || fabsf(fabsf(q[0].y) - 1.0f) > 1.0e-6f)
+         mismatch("quat_look_at_n", 0);
+   }
+   /* orientation store: a partial lane group and a pool of 3 threads
+      against no pool, and the tolerance against the scalar functions */
+   FOR_N(roll, 2) {
+      static float storage[QUAT_STORE_FLOATS(N_BATCH)];
+      quat_store_t s1, s3;
+      quat_pool_t p;
+      size_t n = N_BATCH - 3;
+      if (quat_pool_init(&p, 3))
+         mismatch("quat_pool_init", 3);
+      quat_store_init(&s1, store_storage, n, bq1);
+      quat_store_init(&s3, storage, n, bq1);
+      if (roll) {
+         quat_store_apply_relative_yaw_pitch_roll(NULL, &s1, steer[0], steer[1], steer[2]);
+         quat_store_apply_relative_yaw_pitch_roll(&p, &s3, steer[0], steer[1], steer[2]);
+      } else {
+         quat_store_apply_relative_yaw_pitch(NULL, &s1, steer[0], steer[1]);
+         quat_store_apply_relative_yaw_pitch(&p, &s3, steer[0], steer[1]);
+      }
+      quat_pool_destroy(&p);
+      check_array(roll ? "quat_store_apply_relative_yaw_pitch_roll" : "quat_store_apply_relative_yaw_pitch",
+                  storage, store_storage, sizeof(float), QUAT_STORE_FLOATS(n));
+      FOR_N(i, n) {
+         quat_t q = bq1[i], o;
+         if (roll)
+            quat_apply_relative_yaw_pitch_roll(&q, steer[0][i], steer[1][i], steer[2][i]);
+         else
+            quat_apply_relative_yaw_pitch(&q, steer[0][i], steer[1][i]);
+         quat_store_get(&s1, i, &o);
+         float sign = quat_dot(&q, &o) < 0.0f ? -1.0f : 1.0f;
+         FOR_N(c, 4)
+            if (fabsf(q.vec[c] - sign * o.vec[c]) > 1.0e-6f)
+               mismatch(roll ? "quat_store_apply_relative_yaw_pitch_roll" : "quat_store_apply_relative_yaw_pitch", i);
+      }
+   }
+   /* verify used the storage of the benchmarked store */
+   quat_store_init(&store, store_storage, N_BATCH, bq1);
+   /* both filters at rest in a known attitude, started 49 degrees off
+      it, must find it from gravity and the magnetic field within 40 s;
+      Madgwick keeps stepping by about beta dt around it */
+   FOR_N(type, 2) {
+      static quat_ahrs_sample_t rest[4096];
+      const float half = 0.5f * 49.0f * (float)M_PI / 180.0f;
+      quat_t truth = bq1[7], tc, off, e;
+      vec3_t g = { { 0.0f, 0.0f, -9.81f } }, h = { { 0.45f, 0.0f, 0.2f } }, axis = bv_in[3];
+      quat_ahrs_t f;
+      quat_conj(&tc, &truth);
+      FOR_N(i, 4096) {
+         vec3_init(&rest[i].gyro, 0.0f, 0.0f, 0.0f);
+         quat_rot_vec(&rest[i].acc, &g, &tc);
+         quat_rot_vec(&rest[i].mag, &h, &tc);
+      }
+      vec3_normalize(&axis, &axis);
+      off.w = cosf(half);
+      off.x = sinf(half) * axis.x;
+      off.y = sinf(half) * axis.y;
+      off.z = sinf(half) * axis.z;
+      quat_ahrs_init(&f, type, 0.01f, &rest[0].acc, &rest[0].mag);
+      quat_mul(&f.q, &truth, &off);
+      quat_ahrs_update_n(&f, rest, 4096);
+      quat_mul(&e, &tc, &f.q);
+      float err = 2.0f * atan2f(sqrtf(e.x * e.x + e.y * e.y + e.z * e.z), fabsf(e.w));
+      if (err > 4.0f * QUAT_AHRS_BETA * 0.01f)
+         mismatch("quat_ahrs_update_n", -1);
+   }
+   /* multi-stream filters: both types, a partial lane group, a pool of 3 threads */
+   FOR_N(type, 2) {
+      static float storage[QUAT_AHRS_MULTI_FLOATS(N_STREAMS)];
+      quat_ahrs_multi_t m;
+      quat_pool_t p;
+      size_t n = N_STREAMS - 3;
+      vec3_t acc[N_STREAMS];
+      FOR_N(i, n)
+         acc[i] = streams[i][1].acc;
+      quat_ahrs_multi_init(&m, storage, n, type, 0.001f, acc, NULL);
+      m.ki = 0.1f;
+      if (quat_pool_init(&p, 3))
+         mismatch("quat_pool_init", 3);
+      quat_ahrs_multi_update_n(&p, &m, streams, N_STREAM_SAMPLES);
+      quat_pool_destroy(&p);
+      FOR_N(i, n) {
+         quat_ahrs_t f;
+         quat_t q;
+         quat_ahrs_init(&f, type, 0.001f, &acc[i], NULL);
+         f.ki = 0.1f;
+         quat_ahrs_update_n(&f, streams[i], N_STREAM_SAMPLES);
+         quat_ahrs_multi_get(&m, i, &q);
+         if (memcmp(&q, &f.q, sizeof(q)))
+            mismatch("quat_ahrs_multi_update_n", i);
+      }
+   }
+}
+
+
+static void run(const bench_t *b, result_t *r)
+{
+   long reps = 1;
+   double t;
+
+   /* warm up and find a repetition count that runs for MIN_TIME */
+   for (;;) {
+      t = now();
+      for (long k = 0; k < reps; k++)
+         b->fn();
+      t = now() - t;
+      if (t >= MIN_TIME)
+         break;
+      reps *= 2;
+   }
+
+   double best_t = 1.0e30;
+   unsigned long long best_c = 0;
+   FOR_N(run, N_RUNS) {
+      unsigned long long c = cycles();
+      t = now();
+      for (long k = 0; k < reps; k++)
+         b->fn();
+      t = now() - t;
+      c = cycles() - c;
+      if (t <= best_t) {
+         best_t = t;
+         best_c = c;
+      }
+   }
+   double ops = (double)reps * b->ops;
+   r->name = b->name;
+   r->ns = best_t * 1.0e9 / ops;
+   r->cycles = best_c / ops;
+}
+
+
+static double baseline_ns(FILE *f, const char *name)
+{
+   char line[256], n[128];
+   double ns;
+
+   rewind(f);
+   while (fgets(line, sizeof(line), f))
+      if (sscanf(line, " {\"name\": \"%127[^\"]\", \"ns_per_op\": %lf", n, &ns) == 2 && !strcmp(n, name))
+         return ns;
+   return -1.0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   static const bench_t *tables[] = { float_benches, double_benches, batch_benches };
+   static result_t results[256];
+   const char *filter = NULL;
+   const char *compare = NULL;
+   double threshold = 10.0;
+   int json = 0;
+   int n = 0;
+
+   FOR_N(i, argc - 1) {
+      const char *a = argv[i + 1];
+      if (!strcmp(a, "--json"))
+         json = 1;
+      else if (!strcmp(a, "--filter") && i + 2 < argc)
+         filter = argv[++i + 1];
+      else if (!strcmp(a, "--compare") && i + 2 < argc)
+         compare = argv[++i + 1];
+      else if (!strcmp(a, "--threshold") && i + 2 < argc)
+         threshold = atof(argv[++i + 1]);
+      else {
+         fprintf(stderr, "usage: %s [--json] [--filter substr] [--compare baseline.json] [--threshold percent]\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   f_init();
+   d_init();
+   batch_init();
+   verify();
+
+#if defined(QUAT_INLINE)
+   const char *mode = "inline";
+#else
+   const char *mode = "linked";
+#endif
+   if (!json)
+      printf("mode: %s\n%-40s %10s %10s %10s\n", mode, "function", "ns/op", "Mop/s", "cyc/op");
+
+   FOR_N(t, 3)
+      for (const bench_t *b = tables[t]; b->name; b++) {
+         if (filter && !strstr(b->name, filter))
+            continue;
+         result_t *r = &results[n++];
+         run(b, r);
+         if (!json)
+            printf("%-40s %10.3f %10.2f %10.2f\n", r->name, r->ns, 1.0e3 / r->ns, r->cycles);
+      }
+
+   if (json) {
+      printf("{\n  \"mode\": \"%s\",\n  \"results\": [\n", mode);
+      FOR_N(i, n)
+         printf("    {\"name\": \"%s\", \"ns_per_op\": %.4f, \"mops\": %.3f, \"cycles_per_op\": %.3f}%s\n",
+                results[i].name, results[i].ns, 1.0e3 / results[i].ns, results[i].cycles, i + 1 < n ? "," : "");
+      printf("  ]\n}\n");
+   }
+
+   if (compare) {
+      FILE *f = fopen(compare, "r");
+      int slower = 0;
+      if (!f) {
+         perror(compare);
+         return EXIT_FAILURE;
+      }
+      fprintf(stderr, "\ncomparison against %s (threshold %.1f%%):\n", compare, threshold);
+      FOR_N(i, n) {
+         double base = baseline_ns(f, results[i].name);
+         if (base <= 0.0)
+            continue;
+         double change = (results[i].ns / base - 1.0) * 100.0;
+         const char *flag = "";
+         if (change > threshold) {
+            flag = "SLOWER";
+            slower++;
+         } else if (change < -threshold) {
+            flag = "faster";
+         }
+         fprintf(stderr, "%-40s %10.3f -> %10.3f ns/op %+7.1f%% %s\n",
+                 results[i].name, base, results[i].ns, change, flag);
+      }
+      fclose(f);
+      fprintf(stderr, "%d function(s) slower than baseline\n", slower);
+      if (slower)
+         return EXIT_FAILURE;
+   }
+   return 0;
+}
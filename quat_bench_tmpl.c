@@ -0,0 +1,179 @@
+/*
+   quaternion library - generic scalar benchmarks
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * Included by quat_bench.c once per scalar type with the macros from
+ * quat_tmpl.h plus:
+ *
+ *    B(name)         name of a benchmark function or input array
+ *    BTABLE          name of the resulting benchmark table
+ */
+
+
+static QUAT_T B(qa)[N_SCALAR], B(qb)[N_SCALAR], B(qo)[N_SCALAR];
+static VEC3_T B(va)[N_SCALAR], B(vb)[N_SCALAR], B(vo)[N_SCALAR];
+static EULER_T B(eo)[N_SCALAR];
+static REAL B(fa)[N_SCALAR], B(fo)[N_SCALAR];
+static REAL B(mo)[16];
+static REAL B(ma)[N_SCALAR][16];
+
+
+static void B(init)(void)
+{
+   FOR_N(i, N_SCALAR) {
+      FOR_N(j, 4) {
+         B(qa)[i].vec[j] = (REAL)rnd();
+         B(qb)[i].vec[j] = (REAL)rnd();
+      }
+      QFN(normalize_self)(&B(qa)[i]);
+      QFN(normalize_self)(&B(qb)[i]);
+      VFN(init)(&B(va)[i], (REAL)rnd(), (REAL)rnd(), (REAL)rnd());
+      VFN(init)(&B(vb)[i], (REAL)rnd(), (REAL)rnd(), (REAL)rnd());
+      B(vo)[i] = B(va)[i];
+      B(qo)[i] = B(qa)[i];
+      B(fa)[i] = (REAL)rnd();
+      QFN(to_rh_rot_matrix)(&B(qa)[i], B(ma)[i]);
+   }
+}
+
+
+/* one benchmark = one pass over the N_SCALAR inputs */
+#define SCALAR_BENCH(name, stmt) \
+   static void B(name)(void) \
+   { \
+      FOR_N(i, N_SCALAR) { \
+         stmt; \
+      } \
+   }
+
+SCALAR_BENCH(vec3_copy, VFN(copy)(&B(vo)[i], &B(va)[i]))
+SCALAR_BENCH(quat_init, QUAT_INIT(&B(qo)[i], &B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(quat_init_axis, QFN(init_axis)(&B(qo)[i], B(va)[i].x, B(va)[i].y, B(va)[i].z, B(fa)[i]))
+SCALAR_BENCH(quat_init_axis_v, QFN(init_axis_v)(&B(qo)[i], &B(va)[i], B(fa)[i]))
+SCALAR_BENCH(quat_to_axis, QFN(to_axis)(&B(qa)[i], &B(vo)[i].x, &B(vo)[i].y, &B(vo)[i].z, &B(fo)[i]))
+SCALAR_BENCH(quat_to_axis_v, QFN(to_axis_v)(&B(qa)[i], &B(vo)[i], &B(fo)[i]))
+SCALAR_BENCH(quat_rot_vec, QFN(rot_vec)(&B(vo)[i], &B(va)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_rot_vec_self, QFN(rot_vec_self)(&B(vo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_len, B(fo)[i] = QFN(len)(&B(qa)[i]))
+SCALAR_BENCH(quat_copy, QFN(copy)(&B(qo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_scale, QFN(scale)(&B(qo)[i], &B(qa)[i], B(fa)[i]))
+SCALAR_BENCH(quat_scale_self, QFN(scale_self)(&B(qo)[i], B(fa)[i] < 0 ? LIT(-1.0) : LIT(1.0)))
+SCALAR_BENCH(quat_conj, QFN(conj)(&B(qo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_add, QFN(add)(&B(qo)[i], &B(qa)[i], &B(qb)[i]))
+SCALAR_BENCH(quat_add_self, QFN(add_self)(&B(qo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_mul, QFN(mul)(&B(qo)[i], &B(qa)[i], &B(qb)[i]))
+SCALAR_BENCH(quat_normalize, QFN(normalize)(&B(qo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_normalize_self, QFN(normalize_self)(&B(qo)[i]))
+SCALAR_BENCH(quat_to_euler, QFN(to_euler)(&B(eo)[i], &B(qa)[i]))
+SCALAR_BENCH(quat_from_euler, QFN(from_euler)(&B(qo)[i], &B(eo)[i]))
+SCALAR_BENCH(normalize_euler, B(fo)[i] = NORMALIZE_EULER(B(fa)[i]))
+SCALAR_BENCH(quat_to_rh_rot_matrix, QFN(to_rh_rot_matrix)(&B(qa)[i], B(mo)))
+SCALAR_BENCH(quat_to_lh_rot_matrix, QFN(to_lh_rot_matrix)(&B(qa)[i], B(mo)))
+SCALAR_BENCH(quat_from_rh_rot_matrix, QFN(from_rh_rot_matrix)(&B(qo)[i], B(ma)[i]))
+SCALAR_BENCH(quat_from_lh_rot_matrix, QFN(from_lh_rot_matrix)(&B(qo)[i], B(ma)[i]))
+SCALAR_BENCH(vec3_init, VFN(init)(&B(vo)[i], B(fa)[i], B(fa)[i], B(fa)[i]))
+SCALAR_BENCH(vec3_add, VFN(add)(&B(vo)[i], &B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(vec3_add_self, VFN(add_self)(&B(vo)[i], &B(va)[i]))
+SCALAR_BENCH(vec3_add_c_self, VFN(add_c_self)(&B(vo)[i], B(fa)[i], B(fa)[i], B(fa)[i]))
+SCALAR_BENCH(vec3_sub, VFN(sub)(&B(vo)[i], &B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(vec3_sub_self, VFN(sub_self)(&B(vo)[i], &B(va)[i]))
+SCALAR_BENCH(vec3_sub_c_self, VFN(sub_c_self)(&B(vo)[i], B(fa)[i], B(fa)[i], B(fa)[i]))
+SCALAR_BENCH(vec3_mul, VFN(mul)(&B(vo)[i], &B(va)[i], B(fa)[i]))
+SCALAR_BENCH(vec3_mul_self, VFN(mul_self)(&B(vo)[i], B(fa)[i] < 0 ? LIT(-1.0) : LIT(1.0)))
+SCALAR_BENCH(vec3_dot, B(fo)[i] = VFN(dot)(&B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(vec3_cross, VFN(cross)(&B(vo)[i], &B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(vec3_len2, B(fo)[i] = VFN(len2)(&B(va)[i]))
+SCALAR_BENCH(vec3_normalize, VFN(normalize)(&B(vo)[i], &B(va)[i]))
+SCALAR_BENCH(vec3_rot_axis, VFN(rot_axis)(&B(vo)[i], &B(va)[i], B(vb)[i].x, B(vb)[i].y, B(vb)[i].z, B(fa)[i]))
+SCALAR_BENCH(vec3_rot_axis_self, VFN(rot_axis_self)(&B(vo)[i], B(vb)[i].x, B(vb)[i].y, B(vb)[i].z, B(fa)[i]))
+SCALAR_BENCH(vec3_dist, B(fo)[i] = (REAL)VFN(dist)(&B(va)[i], &B(vb)[i]))
+SCALAR_BENCH(vec3_dist_c, B(fo)[i] = (REAL)VFN(dist_c)(&B(va)[i], B(fa)[i], B(fa)[i], B(fa)[i]))
+SCALAR_BENCH(quat_from_u2v, QFN(from_u2v)(&B(qo)[i], &B(va)[i], &B(vb)[i], NULL))
+SCALAR_BENCH(quat_look_at, QFN(look_at)(&B(qo)[i], &B(va)[i], &B(vb)[i], NULL))
+SCALAR_BENCH(quat_dot, B(fo)[i] = QFN(dot)(&B(qa)[i], &B(qb)[i]))
+SCALAR_BENCH(quat_nlerp, QFN(nlerp)(&B(qo)[i], &B(qa)[i], &B(qb)[i], B(fa)[i]))
+SCALAR_BENCH(quat_slerp, QFN(slerp)(&B(qo)[i], &B(qa)[i], &B(qb)[i], B(fa)[i]))
+SCALAR_BENCH(quat_apply_relative_yaw_pitch_roll,
+             QFN(apply_relative_yaw_pitch_roll)(&B(qo)[i], (double)B(va)[i].x, (double)B(va)[i].y, (double)B(va)[i].z))
+SCALAR_BENCH(quat_apply_relative_yaw_pitch,
+             QFN(apply_relative_yaw_pitch)(&B(qo)[i], (double)B(va)[i].x, (double)B(va)[i].y))
+SCALAR_BENCH(quat_decompose_twist_swing, QFN(decompose_twist_swing)(&B(qa)[i], &B(va)[i], &B(qo)[i], &B(qb)[i]))
+SCALAR_BENCH(quat_decompose_swing_twist, QFN(decompose_swing_twist)(&B(qa)[i], &B(va)[i], &B(qb)[i], &B(qo)[i]))
+
+#undef SCALAR_BENCH
+
+
+/* labels are the real function names, e.g. quatd_mul for the double version */
+#define ENTRY(name, fn) { STR(fn), B(name), N_SCALAR }
+
+static const bench_t BTABLE[] =
+{
+   ENTRY(vec3_copy, VFN(copy)),
+   ENTRY(quat_init, QUAT_INIT),
+   ENTRY(quat_init_axis, QFN(init_axis)),
+   ENTRY(quat_init_axis_v, QFN(init_axis_v)),
+   ENTRY(quat_to_axis, QFN(to_axis)),
+   ENTRY(quat_to_axis_v, QFN(to_axis_v)),
+   ENTRY(quat_rot_vec, QFN(rot_vec)),
+   ENTRY(quat_rot_vec_self, QFN(rot_vec_self)),
+   ENTRY(quat_len, QFN(len)),
+   ENTRY(quat_copy, QFN(copy)),
+   ENTRY(quat_scale, QFN(scale)),
+   ENTRY(quat_scale_self, QFN(scale_self)),
+   ENTRY(quat_conj, QFN(conj)),
+   ENTRY(quat_add, QFN(add)),
+   ENTRY(quat_add_self, QFN(add_self)),
+   ENTRY(quat_mul, QFN(mul)),
+   ENTRY(quat_normalize, QFN(normalize)),
+   ENTRY(quat_normalize_self, QFN(normalize_self)),
+   ENTRY(quat_to_euler, QFN(to_euler)),
+   ENTRY(quat_from_euler, QFN(from_euler)),
+   ENTRY(normalize_euler, NORMALIZE_EULER),
+   ENTRY(quat_to_rh_rot_matrix, QFN(to_rh_rot_matrix)),
+   ENTRY(quat_to_lh_rot_matrix, QFN(to_lh_rot_matrix)),
+   ENTRY(quat_from_rh_rot_matrix, QFN(from_rh_rot_matrix)),
+   ENTRY(quat_from_lh_rot_matrix, QFN(from_lh_rot_matrix)),
+   ENTRY(vec3_init, VFN(init)),
+   ENTRY(vec3_add, VFN(add)),
+   ENTRY(vec3_add_self, VFN(add_self)),
+   ENTRY(vec3_add_c_self, VFN(add_c_self)),
+   ENTRY(vec3_sub, VFN(sub)),
+   ENTRY(vec3_sub_self, VFN(sub_self)),
+   ENTRY(vec3_sub_c_self, VFN(sub_c_self)),
+   ENTRY(vec3_mul, VFN(mul)),
+   ENTRY(vec3_mul_self, VFN(mul_self)),
+   ENTRY(vec3_dot, VFN(dot)),
+   ENTRY(vec3_cross, VFN(cross)),
+   ENTRY(vec3_len2, VFN(len2)),
+   ENTRY(vec3_normalize, VFN(normalize)),
+   ENTRY(vec3_rot_axis, VFN(rot_axis)),
+   ENTRY(vec3_rot_axis_self, VFN(rot_axis_self)),
+   ENTRY(vec3_dist, VFN(dist)),
+   ENTRY(vec3_dist_c, VFN(dist_c)),
+   ENTRY(quat_from_u2v, QFN(from_u2v)),
+   ENTRY(quat_look_at, QFN(look_at)),
+   ENTRY(quat_dot, QFN(dot)),
+   ENTRY(quat_nlerp, QFN(nlerp)),
+   ENTRY(quat_slerp, QFN(slerp)),
+   ENTRY(quat_apply_relative_yaw_pitch_roll, QFN(apply_relative_yaw_pitch_roll)),
+   ENTRY(quat_apply_relative_yaw_pitch, QFN(apply_relative_yaw_pitch)),
+   ENTRY(quat_decompose_twist_swing, QFN(decompose_twist_swing)),
+   ENTRY(quat_decompose_swing_twist, QFN(decompose_swing_twist)),
+   { NULL, NULL, 0 }
+};
+
+#undef ENTRY
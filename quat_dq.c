@@ -0,0 +1,316 @@
+/*
+   quaternion library - dual quaternions and skinning
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * see: L. Kavan, S. Collins, J. Zara, C. O'Sullivan, Geometric skinning
+ *      with approximate dual quaternion blending, 2008
+ *
+ * A unit dual quaternion r + e d moves point p to
+ *    p + 2 r' x (r' x p + rw p) + 2 (rw d' - dw r' + r' x d'),
+ * where r' and d' are the vector parts; the second term is the
+ * translation 2 d r*.
+ */
+
+
+#include <math.h>
+#include <string.h>
+
+#include "quat_dq.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+QUAT_API void quat_dq_init(quat_dq_t *dq, const quat_t *q, const vec3_t *t)
+{
+   quat_t tq = { .w = 0.0f, .x = t->x, .y = t->y, .z = t->z };
+   quat_t d;
+   quat_mul(&d, &tq, q);
+   dq->r = *q;
+   quat_scale(&dq->d, &d, 0.5f);
+}
+
+
+QUAT_API void quat_dq_from_xform(quat_dq_t *dq, const quat_xform_t *x)
+{
+   quat_dq_init(dq, &x->q, &x->t);
+}
+
+
+QUAT_API void quat_dq_to_xform(quat_xform_t *x, const quat_dq_t *dq)
+{
+   quat_t rc, t;
+   quat_conj(&rc, &dq->r);
+   quat_mul(&t, &dq->d, &rc);
+   x->q = dq->r;
+   x->t.x = 2.0f * t.x;
+   x->t.y = 2.0f * t.y;
+   x->t.z = 2.0f * t.z;
+}
+
+
+QUAT_API void quat_dq_mul(quat_dq_t *o, const quat_dq_t *a, const quat_dq_t *b)
+{
+   quat_dq_t r;
+   quat_t d1, d2;
+   quat_mul(&r.r, &a->r, &b->r);
+   quat_mul(&d1, &a->r, &b->d);
+   quat_mul(&d2, &a->d, &b->r);
+   quat_add(&r.d, &d1, &d2);
+   *o = r;
+}
+
+
+/* the transform formulas for float and vector operands; vo, p and v
+   are x, y, z triples, r and d are w, x, y, z quadruples */
+#define DQ_APPLY(vo, r, d, p) \
+   do { \
+      __typeof__(p[0]) cx = (r[2] * p[2] - r[3] * p[1]) + r[0] * p[0]; \
+      __typeof__(p[0]) cy = (r[3] * p[0] - r[1] * p[2]) + r[0] * p[1]; \
+      __typeof__(p[0]) cz = (r[1] * p[1] - r[2] * p[0]) + r[0] * p[2]; \
+      __typeof__(p[0]) tx = (r[0] * d[1] - d[0] * r[1]) + (r[2] * d[3] - r[3] * d[2]); \
+      __typeof__(p[0]) ty = (r[0] * d[2] - d[0] * r[2]) + (r[3] * d[1] - r[1] * d[3]); \
+      __typeof__(p[0]) tz = (r[0] * d[3] - d[0] * r[3]) + (r[1] * d[2] - r[2] * d[1]); \
+      vo[0] = p[0] + 2.0f * ((r[2] * cz - r[3] * cy) + tx); \
+      vo[1] = p[1] + 2.0f * ((r[3] * cx - r[1] * cz) + ty); \
+      vo[2] = p[2] + 2.0f * ((r[1] * cy - r[2] * cx) + tz); \
+   } while (0)
+
+#define DQ_ROT(vo, r, v) \
+   do { \
+      __typeof__(v[0]) cx = (r[2] * v[2] - r[3] * v[1]) + r[0] * v[0]; \
+      __typeof__(v[0]) cy = (r[3] * v[0] - r[1] * v[2]) + r[0] * v[1]; \
+      __typeof__(v[0]) cz = (r[1] * v[1] - r[2] * v[0]) + r[0] * v[2]; \
+      vo[0] = v[0] + 2.0f * (r[2] * cz - r[3] * cy); \
+      vo[1] = v[1] + 2.0f * (r[3] * cx - r[1] * cz); \
+      vo[2] = v[2] + 2.0f * (r[1] * cy - r[2] * cx); \
+   } while (0)
+
+
+QUAT_API void quat_dq_apply(vec3_t *vo, const quat_dq_t *dq, const vec3_t *p)
+{
+   const float *r = dq->r.vec, *d = dq->d.vec, pv[3] = { p->x, p->y, p->z };
+   DQ_APPLY(vo->vec, r, d, pv);
+}
+
+
+QUAT_API void quat_dq_rot(vec3_t *vo, const quat_dq_t *dq, const vec3_t *v)
+{
+   const float *r = dq->r.vec, vv[3] = { v->x, v->y, v->z };
+   DQ_ROT(vo->vec, r, vv);
+}
+
+
+QUAT_API void quat_dq_blend(quat_dq_t *o, const quat_dq_t *palette,
+                            const int *bones, const float *weights, int k)
+{
+   const quat_t *r0 = &palette[bones[0]].r;
+   float b[8] = { 0.0f };
+   FOR_N(j, k) {
+      const quat_dq_t *dq = &palette[bones[j]];
+      float w = weights[j];
+      /* q and -q are the same rotation, blend in the hemisphere of the first */
+      if (r0->w * dq->r.w + r0->x * dq->r.x + r0->y * dq->r.y + r0->z * dq->r.z < 0.0f)
+         w = -w;
+      FOR_N(c, 4) {
+         b[c] = b[c] + w * dq->r.vec[c];
+         b[4 + c] = b[4 + c] + w * dq->d.vec[c];
+      }
+   }
+   float inv = 1.0f / sqrtf(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+   FOR_N(c, 4) {
+      o->r.vec[c] = b[c] * inv;
+      o->d.vec[c] = b[4 + c] * inv;
+   }
+}
+
+
+/* one vertex, the scalar reference of the lane code below */
+static void dq_skin_one(vec3_t *pos_out, vec3_t *nrm_out, const vec3_t *pos, const vec3_t *nrm,
+                        const int *bones, const float *weights, int k, const quat_dq_t *palette)
+{
+   quat_dq_t dq;
+   quat_dq_blend(&dq, palette, bones, weights, k);
+   quat_dq_apply(pos_out, &dq, pos);
+   if (nrm_out)
+      quat_dq_rot(nrm_out, &dq, nrm);
+}
+
+
+#if defined(__AVX__)
+#define DQ_LANES 8
+#define DQ_V vfloat8_t
+#define DQ_VI vint8_t
+#define DQ_SQRT vfloat8_sqrt
+#define DQ_SELECT vfloat8_select
+#define DQ_V3_T vec3x8_t
+#define DQ_V3(op) vec3x8_##op
+#else
+#define DQ_LANES 4
+#define DQ_V vfloat4_t
+#define DQ_VI vint4_t
+#define DQ_SQRT vfloat4_sqrt
+#define DQ_SELECT vfloat4_select
+#define DQ_V3_T vec3x4_t
+#define DQ_V3(op) vec3x4_##op
+#endif
+
+
+#if defined(__SSE__)
+
+/* 4 dual quaternions into 8 vectors r.w .. r.z, d.w .. d.z */
+static inline void dq_load4(__m128 *v, const quat_dq_t *const *x)
+{
+   __m128 r0 = _mm_loadu_ps(x[0]->r.vec), d0 = _mm_loadu_ps(x[0]->d.vec);
+   __m128 r1 = _mm_loadu_ps(x[1]->r.vec), d1 = _mm_loadu_ps(x[1]->d.vec);
+   __m128 r2 = _mm_loadu_ps(x[2]->r.vec), d2 = _mm_loadu_ps(x[2]->d.vec);
+   __m128 r3 = _mm_loadu_ps(x[3]->r.vec), d3 = _mm_loadu_ps(x[3]->d.vec);
+   _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+   _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+   v[0] = r0;
+   v[1] = r1;
+   v[2] = r2;
+   v[3] = r3;
+   v[4] = d0;
+   v[5] = d1;
+   v[6] = d2;
+   v[7] = d3;
+}
+
+#endif /* __SSE__ */
+
+
+/* palette entries x[0 .. DQ_LANES - 1] into lanes */
+static inline void dq_load(DQ_V *v, const quat_dq_t *const *x)
+{
+#if defined(__AVX__)
+   __m128 lo[8], hi[8];
+   dq_load4(lo, x);
+   dq_load4(hi, x + 4);
+   FOR_N(c, 8)
+      v[c] = (DQ_V)_mm256_set_m128(hi[c], lo[c]);
+#elif defined(__SSE__)
+   __m128 r[8];
+   dq_load4(r, x);
+   FOR_N(c, 8)
+      v[c] = (DQ_V)r[c];
+#else
+   float g[8][DQ_LANES];
+   FOR_N(l, DQ_LANES)
+      FOR_N(c, 4) {
+         g[c][l] = x[l]->r.vec[c];
+         g[4 + c][l] = x[l]->d.vec[c];
+      }
+   memcpy(v, g, sizeof(g));
+#endif
+}
+
+
+/* vertices i .. i + DQ_LANES - 1 */
+static void dq_skin_lanes(vec3_t *pos_out, vec3_t *nrm_out, const vec3_t *pos, const vec3_t *nrm,
+                          const int *bones, const float *weights, int k,
+                          const quat_dq_t *palette, size_t i)
+{
+   const quat_dq_t *x[DQ_LANES];
+   DQ_V r0[8], v[8], b[8];
+   FOR_N(c, 8)
+      b[c] = (DQ_V){ 0.0f };
+   FOR_N(l, DQ_LANES)
+      x[l] = &palette[bones[(i + l) * k]];
+   dq_load(r0, x);
+
+   FOR_N(j, k) {
+      const float *wp = weights + i * k + j;
+      FOR_N(l, DQ_LANES)
+         x[l] = &palette[bones[(i + l) * k + j]];
+      dq_load(v, x);
+#if DQ_LANES == 8
+      DQ_V w = { wp[0], wp[k], wp[2 * k], wp[3 * k], wp[4 * k], wp[5 * k], wp[6 * k], wp[7 * k] };
+#else
+      DQ_V w = { wp[0], wp[k], wp[2 * k], wp[3 * k] };
+#endif
+      DQ_VI neg = r0[0] * v[0] + r0[1] * v[1] + r0[2] * v[2] + r0[3] * v[3] < 0.0f;
+      w = DQ_SELECT(neg, -w, w);
+      FOR_N(c, 8)
+         b[c] = b[c] + w * v[c];
+   }
+   DQ_V inv = 1.0f / DQ_SQRT(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+   FOR_N(c, 8)
+      b[c] = b[c] * inv;
+
+   DQ_V3_T p, o;
+   DQ_V pv[3], ov[3];
+   DQ_V3(load)(&p, pos + i);
+   pv[0] = p.x;
+   pv[1] = p.y;
+   pv[2] = p.z;
+   DQ_APPLY(ov, b, (b + 4), pv);
+   o.x = ov[0];
+   o.y = ov[1];
+   o.z = ov[2];
+   DQ_V3(store)(pos_out + i, &o);
+   if (nrm_out) {
+      DQ_V3(load)(&p, nrm + i);
+      pv[0] = p.x;
+      pv[1] = p.y;
+      pv[2] = p.z;
+      DQ_ROT(ov, b, pv);
+      o.x = ov[0];
+      o.y = ov[1];
+      o.z = ov[2];
+      DQ_V3(store)(nrm_out + i, &o);
+   }
+}
+
+
+typedef struct
+{
+   vec3_t *pos_out, *nrm_out;
+   const vec3_t *pos, *nrm;
+   const int *bones;
+   const float *weights;
+   int k;
+   const quat_dq_t *palette;
+}
+dq_job_t;
+
+
+/* vertices [first, last) of a chunk */
+static void dq_skin_chunk(void *ctx, size_t first, size_t last)
+{
+   dq_job_t *job = ctx;
+   size_t i = first;
+   for (; i + DQ_LANES <= last; i += DQ_LANES)
+      dq_skin_lanes(job->pos_out, job->nrm_out, job->pos, job->nrm,
+                    job->bones, job->weights, job->k, job->palette, i);
+   for (; i < last; i++)
+      dq_skin_one(&job->pos_out[i], job->nrm_out ? &job->nrm_out[i] : NULL,
+                  &job->pos[i], job->nrm ? &job->nrm[i] : NULL,
+                  &job->bones[i * job->k], &job->weights[i * job->k], job->k, job->palette);
+}
+
+
+QUAT_API void quat_dq_skin_n(quat_pool_t *p, vec3_t *pos_out, vec3_t *nrm_out,
+                             const vec3_t *pos, const vec3_t *nrm,
+                             const int *bones, const float *weights, int k,
+                             const quat_dq_t *palette, size_t n)
+{
+   dq_job_t job = { pos_out, nrm ? nrm_out : NULL, pos, nrm, bones, weights, k, palette };
+   quat_pool_for(p, n, QUAT_DQ_CHUNK, 2 * QUAT_DQ_CHUNK, dq_skin_chunk, &job);
+}
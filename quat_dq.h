@@ -0,0 +1,86 @@
+/*
+   quaternion library - dual quaternion interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_DQ_H__
+#define __QUAT_DQ_H__
+
+
+#include "quat.h"
+#include "quat_xform.h"
+#include "quat_pool.h"
+
+
+/* unit dual quaternion r + e d for the rigid transform rotating by r
+ * and then translating by t, with d = 1/2 (0, t) r
+ */
+typedef struct
+{
+   quat_t r;   /* real part: rotation */
+   quat_t d;   /* dual part: translation */
+}
+quat_dq_t;
+
+
+/* vertices per chunk of quat_dq_skin_n on a pool */
+#define QUAT_DQ_CHUNK 1024
+
+
+/* initialize dual quaternion from unit quaternion q and translation t */
+QUAT_API void quat_dq_init(quat_dq_t *dq, const quat_t *q, const vec3_t *t);
+
+/* conversions from and to rigid transforms */
+QUAT_API void quat_dq_from_xform(quat_dq_t *dq, const quat_xform_t *x);
+QUAT_API void quat_dq_to_xform(quat_xform_t *x, const quat_dq_t *dq);
+
+/* o = a * b, the transform that applies b first and then a;
+ * o may be equal to a or b
+ */
+QUAT_API void quat_dq_mul(quat_dq_t *o, const quat_dq_t *a, const quat_dq_t *b);
+
+/* transform point p via unit dual quaternion dq */
+QUAT_API void quat_dq_apply(vec3_t *vo, const quat_dq_t *dq, const vec3_t *p);
+
+/* rotate direction v (e.g. a normal) via unit dual quaternion dq */
+QUAT_API void quat_dq_rot(vec3_t *vo, const quat_dq_t *dq, const vec3_t *v);
+
+/* dual quaternion linear blending (Kavan et al. 2008): the k weighted
+ * palette entries palette[bones[j]], with the real parts flipped into
+ * the hemisphere of the first one, summed and normalized; the weights
+ * must have a positive sum
+ */
+QUAT_API void quat_dq_blend(quat_dq_t *o, const quat_dq_t *palette,
+                            const int *bones, const float *weights, int k);
+
+/* skin n vertices with k >= 1 influences each (typically 4 to 8):
+ * vertex i uses bones[i * k + j] and weights[i * k + j], j < k.
+ * Positions go to pos_out, normals to nrm_out; nrm and nrm_out may be
+ * NULL. Vertices are processed at full vector width on pool p (may be
+ * NULL); results match quat_dq_blend followed by quat_dq_apply and
+ * quat_dq_rot, with any pool.
+ */
+QUAT_API void quat_dq_skin_n(quat_pool_t *p, vec3_t *pos_out, vec3_t *nrm_out,
+                             const vec3_t *pos, const vec3_t *nrm,
+                             const int *bones, const float *weights, int k,
+                             const quat_dq_t *palette, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_dq.c"
+#endif
+
+
+#endif /* __QUAT_DQ_H__ */
@@ -0,0 +1,105 @@
+/*
+   quaternion library - joint limit implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+
+#include "quat_joint.h"
+
+
+QUAT_API int quat_joint_init(quat_joint_t *j, const vec3_t *axis, float swing_max,
+                             float twist_min, float twist_max)
+{
+   const float pi = (float)M_PI;
+   float l = sqrtf(axis->x * axis->x + axis->y * axis->y + axis->z * axis->z);
+   if (!(l > 0.0f) || !(swing_max >= 0.0f && swing_max <= pi)
+       || !(twist_min >= -pi && twist_min <= twist_max && twist_max <= pi))
+      return -1;
+   j->axis.x = axis->x / l;
+   j->axis.y = axis->y / l;
+   j->axis.z = axis->z / l;
+   j->swing_cos = cosf(0.5f * swing_max);
+   j->swing_sin = sinf(0.5f * swing_max);
+   j->twist_min_cos = cosf(0.5f * twist_min);
+   j->twist_min_sin = sinf(0.5f * twist_min);
+   j->twist_max_cos = cosf(0.5f * twist_max);
+   j->twist_max_sin = sinf(0.5f * twist_max);
+   return 0;
+}
+
+
+/* limits swing s (w >= 0) and twist t of q = s t; on clamping, qo = s t */
+static int joint_limit(const quat_joint_t *j, quat_t *qo, const quat_t *q, quat_t *s, quat_t *t)
+{
+   int clamped = 0;
+   if (s->w < j->swing_cos) {
+      float l = sqrtf(s->x * s->x + s->y * s->y + s->z * s->z);
+      if (l > 0.0f) {
+         float f = j->swing_sin / l;
+         s->w = j->swing_cos;
+         s->x *= f;
+         s->y *= f;
+         s->z *= f;
+         clamped |= QUAT_JOINT_SWING;
+      }
+   }
+   /* t = (cos(a / 2), sin(a / 2) axis) for twist angle a in [-pi, pi] */
+   float ts = t->x * j->axis.x + t->y * j->axis.y + t->z * j->axis.z, tw = fabsf(t->w);
+   if (t->w < 0.0f)
+      ts = -ts;
+   if (ts > j->twist_max_sin || ts < j->twist_min_sin) {
+      /* |t . limit| = |cos(half the angle between them)|, so the larger
+         dot product is the nearer limit around the circle */
+      int hi = fabsf(tw * j->twist_max_cos + ts * j->twist_max_sin)
+         > fabsf(tw * j->twist_min_cos + ts * j->twist_min_sin);
+      float c = hi ? j->twist_max_cos : j->twist_min_cos, sn = hi ? j->twist_max_sin : j->twist_min_sin;
+      t->w = c;
+      t->x = sn * j->axis.x;
+      t->y = sn * j->axis.y;
+      t->z = sn * j->axis.z;
+      clamped |= QUAT_JOINT_TWIST;
+   }
+   if (clamped)
+      quat_mul(qo, s, t);
+   else
+      *qo = *q;
+   return clamped;
+}
+
+
+QUAT_API int quat_joint_clamp(const quat_joint_t *j, quat_t *qo, const quat_t *q)
+{
+   quat_t s, t;
+   quat_decompose_swing_twist(q, &j->axis, &s, &t);
+   return joint_limit(j, qo, q, &s, &t);
+}
+
+
+QUAT_API size_t quat_joint_clamp_n(const quat_joint_t *j, quat_t *qo, const quat_t *q, size_t n)
+{
+   quat_t s[QUAT_JOINT_CHUNK], t[QUAT_JOINT_CHUNK];
+   vec3_t axis[QUAT_JOINT_CHUNK];
+   size_t clamped = 0;
+   for (size_t i = 0; i < n; i += QUAT_JOINT_CHUNK) {
+      size_t m = n - i < QUAT_JOINT_CHUNK ? n - i : QUAT_JOINT_CHUNK;
+      for (size_t k = 0; k < m; k++)
+         axis[k] = j[i + k].axis;
+      quat_decompose_swing_twist_n(q + i, axis, s, t, m);
+      for (size_t k = 0; k < m; k++)
+         clamped += joint_limit(&j[i + k], &qo[i + k], &q[i + k], &s[k], &t[k]) != 0;
+   }
+   return clamped;
+}
@@ -0,0 +1,83 @@
+/*
+   quaternion library - joint limit interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_JOINT_H__
+#define __QUAT_JOINT_H__
+
+
+#include "quat.h"
+
+
+/* Cone and twist limits of a ball joint. The local rotation q of the
+ * joint is split into q = swing twist around the bone axis with
+ * quat_decompose_swing_twist; the swing angle is limited to a circular
+ * cone of half angle swing_max around the axis and the twist angle to
+ * [twist_min, twist_max].
+ *
+ * Both are compared through the half angle terms of the quaternions
+ * against cosines and sines precomputed by quat_joint_init: cos(a / 2)
+ * is the w of a swing of angle a, and sin(a / 2) the component along
+ * the axis of a twist of angle a with w >= 0. A clamped swing keeps its
+ * direction, a clamped twist goes to the nearer limit. No trigonometry
+ * is evaluated per rotation.
+ */
+typedef struct
+{
+   vec3_t axis;              /* unit bone axis in the joint frame */
+   float swing_cos;          /* cos(swing_max / 2) */
+   float swing_sin;          /* sin(swing_max / 2) */
+   float twist_min_cos;      /* cos(twist_min / 2) */
+   float twist_min_sin;      /* sin(twist_min / 2) */
+   float twist_max_cos;      /* cos(twist_max / 2) */
+   float twist_max_sin;      /* sin(twist_max / 2) */
+}
+quat_joint_t;
+
+/* bits of the quat_joint_clamp result */
+#define QUAT_JOINT_SWING 1
+#define QUAT_JOINT_TWIST 2
+
+/* joints per chunk of quat_joint_clamp_n */
+#define QUAT_JOINT_CHUNK 64
+
+
+/* limits around axis, angles in rad; returns 0 on success, -1 if the
+ * axis is zero or not 0 <= swing_max <= pi and
+ * -pi <= twist_min <= twist_max <= pi
+ */
+QUAT_API int quat_joint_init(quat_joint_t *j, const vec3_t *axis, float swing_max,
+                             float twist_min, float twist_max);
+
+/* qo = q limited to joint j; returns the QUAT_JOINT_* bits of the parts
+ * that were clamped. Unclamped rotations are copied unchanged, clamped
+ * ones may come out with the opposite sign. qo may be equal to q.
+ */
+QUAT_API int quat_joint_clamp(const quat_joint_t *j, quat_t *qo, const quat_t *q);
+
+/* qo[i] = q[i] limited to joint j[i] for n joints, e.g. a skeleton in one
+ * IK iteration, with quat_decompose_swing_twist_n on chunks of
+ * QUAT_JOINT_CHUNK joints; returns the number of clamped joints
+ */
+QUAT_API size_t quat_joint_clamp_n(const quat_joint_t *j, quat_t *qo, const quat_t *q, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_joint.c"
+#endif
+
+
+#endif /* __QUAT_JOINT_H__ */
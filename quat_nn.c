@@ -0,0 +1,346 @@
+/*
+   quaternion library - orientation nearest neighbour index implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+#include <string.h>
+
+#include "quat_nn.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+#define NN_MAGIC "QUATNN"
+#define NN_BYTE_ORDER 0x01020304u
+#define NN_VERSION 1
+
+/* rounding error of nn_dist; pruning allows for it, so the triangle
+   inequality of the rounded distances does not lose neighbours */
+#define NN_SLACK 4.0e-6f
+
+
+static float nn_dist(const quat_t *a, const quat_t *b)
+{
+   float m = 0.0f, p = 0.0f;
+   FOR_N(i, 4) {
+      float d = a->vec[i] - b->vec[i], s = a->vec[i] + b->vec[i];
+      m += d * d;
+      p += s * s;
+   }
+   return sqrtf(m < p ? m : p);
+}
+
+
+static float nn_angle(float d)
+{
+   return 4.0f * asinf(0.5f * d);
+}
+
+
+/* subtree of nodes [lo, hi) below vantage point lo, split at mid */
+static size_t nn_mid(size_t lo, size_t hi)
+{
+   return lo + 1 + (hi - lo - 1) / 2;
+}
+
+
+static void nn_swap(quat_nn_node_t *nd, size_t i, size_t j)
+{
+   quat_nn_node_t t = nd[i];
+   nd[i] = nd[j];
+   nd[j] = t;
+}
+
+
+/* partially sort nd[lo, hi) by mu so that nd[k] is in place */
+static void nn_select(quat_nn_node_t *nd, size_t lo, size_t hi, size_t k)
+{
+   while (hi - lo > 1) {
+      float pivot = nd[lo + (hi - lo) / 2].mu;
+      size_t lt = lo, i = lo, gt = hi;
+      while (i < gt) {
+         if (nd[i].mu < pivot)
+            nn_swap(nd, lt++, i++);
+         else if (nd[i].mu > pivot)
+            nn_swap(nd, i, --gt);
+         else
+            i++;
+      }
+      if (k < lt)
+         hi = lt;
+      else if (k >= gt)
+         lo = gt;
+      else
+         return;
+   }
+}
+
+
+/* mu holds the distances to the vantage point while its range is split */
+static void nn_build(quat_nn_node_t *nd, size_t lo, size_t hi, uint32_t *seed)
+{
+   if (hi - lo <= QUAT_NN_LEAF) {
+      for (size_t i = lo; i < hi; i++)
+         nd[i].mu = 0.0f;
+      return;
+   }
+   *seed ^= *seed << 13;
+   *seed ^= *seed >> 17;
+   *seed ^= *seed << 5;
+   nn_swap(nd, lo, lo + *seed % (hi - lo));
+   for (size_t i = lo + 1; i < hi; i++)
+      nd[i].mu = nn_dist(&nd[lo].q, &nd[i].q);
+   size_t mid = nn_mid(lo, hi);
+   nn_select(nd, lo + 1, hi, mid);
+   nd[lo].mu = nd[mid].mu;
+   nn_build(nd, lo + 1, mid, seed);
+   nn_build(nd, mid, hi, seed);
+}
+
+
+QUAT_API int quat_nn_build(quat_nn_t *t, quat_nn_node_t *storage, const quat_t *q, size_t n)
+{
+   uint32_t seed = 2463534242u;
+   if (n >= QUAT_NN_NONE)
+      return -1;
+   for (size_t i = 0; i < n; i++) {
+      storage[i].q = q[i];
+      storage[i].id = (uint32_t)i;
+   }
+   nn_build(storage, 0, n, &seed);
+   t->n = n;
+   t->nodes = storage;
+   return 0;
+}
+
+
+/* k nearest search state, hits is a max heap on distance (kept in
+   angle until the end) and tau the distance of its root once full */
+typedef struct
+{
+   const quat_nn_node_t *nd;
+   quat_t q;
+   size_t k, found;
+   quat_nn_hit_t *hits;
+   float tau;
+}
+nn_knn_t;
+
+
+static void nn_sift_down(quat_nn_hit_t *h, size_t n, size_t i)
+{
+   for (;;) {
+      size_t c = 2 * i + 1;
+      if (c >= n)
+         return;
+      if (c + 1 < n && h[c + 1].angle > h[c].angle)
+         c++;
+      if (!(h[c].angle > h[i].angle))
+         return;
+      quat_nn_hit_t t = h[i];
+      h[i] = h[c];
+      h[c] = t;
+      i = c;
+   }
+}
+
+
+static void nn_offer(nn_knn_t *s, float d, uint32_t id)
+{
+   quat_nn_hit_t *h = s->hits;
+   if (s->found < s->k) {
+      size_t i = s->found++;
+      while (i > 0 && h[(i - 1) / 2].angle < d) {
+         h[i] = h[(i - 1) / 2];
+         i = (i - 1) / 2;
+      }
+      h[i].id = id;
+      h[i].angle = d;
+      if (s->found == s->k)
+         s->tau = h[0].angle;
+   } else if (d < h[0].angle) {
+      h[0].id = id;
+      h[0].angle = d;
+      nn_sift_down(h, s->k, 0);
+      s->tau = h[0].angle;
+   }
+}
+
+
+static void nn_knn_range(nn_knn_t *s, size_t lo, size_t hi)
+{
+   if (hi - lo <= QUAT_NN_LEAF) {
+      for (size_t i = lo; i < hi; i++)
+         nn_offer(s, nn_dist(&s->q, &s->nd[i].q), s->nd[i].id);
+      return;
+   }
+   const quat_nn_node_t *v = &s->nd[lo];
+   float d = nn_dist(&s->q, &v->q);
+   size_t mid = nn_mid(lo, hi);
+   nn_offer(s, d, v->id);
+   /* nearer side first, the other one if the ball of radius tau
+      around q reaches across mu */
+   if (d < v->mu) {
+      nn_knn_range(s, lo + 1, mid);
+      if (v->mu - d <= s->tau + NN_SLACK)
+         nn_knn_range(s, mid, hi);
+   } else {
+      nn_knn_range(s, mid, hi);
+      if (d - v->mu <= s->tau + NN_SLACK)
+         nn_knn_range(s, lo + 1, mid);
+   }
+}
+
+
+QUAT_API size_t quat_nn_knn(const quat_nn_t *t, const quat_t *q, size_t k, quat_nn_hit_t *hits)
+{
+   nn_knn_t s = { t->nodes, *q, k, 0, hits, INFINITY };
+   if (k == 0)
+      return 0;
+   nn_knn_range(&s, 0, t->n);
+   /* heap sort, the farthest goes to the end */
+   for (size_t n = s.found; n > 1; n--) {
+      quat_nn_hit_t h = hits[0];
+      hits[0] = hits[n - 1];
+      hits[n - 1] = h;
+      nn_sift_down(hits, n - 1, 0);
+   }
+   for (size_t i = 0; i < s.found; i++)
+      hits[i].angle = nn_angle(hits[i].angle);
+   return s.found;
+}
+
+
+typedef struct
+{
+   const quat_nn_node_t *nd;
+   quat_t q;
+   float r;
+   quat_nn_hit_t *hits;
+   size_t max_hits, found;
+}
+nn_within_t;
+
+
+static void nn_take(nn_within_t *s, float d, uint32_t id)
+{
+   if (d > s->r)
+      return;
+   if (s->found < s->max_hits) {
+      s->hits[s->found].id = id;
+      s->hits[s->found].angle = nn_angle(d);
+   }
+   s->found++;
+}
+
+
+static void nn_within_range(nn_within_t *s, size_t lo, size_t hi)
+{
+   if (hi - lo <= QUAT_NN_LEAF) {
+      for (size_t i = lo; i < hi; i++)
+         nn_take(s, nn_dist(&s->q, &s->nd[i].q), s->nd[i].id);
+      return;
+   }
+   const quat_nn_node_t *v = &s->nd[lo];
+   float d = nn_dist(&s->q, &v->q);
+   size_t mid = nn_mid(lo, hi);
+   nn_take(s, d, v->id);
+   if (d - v->mu <= s->r + NN_SLACK)
+      nn_within_range(s, lo + 1, mid);
+   if (v->mu - d <= s->r + NN_SLACK)
+      nn_within_range(s, mid, hi);
+}
+
+
+QUAT_API size_t quat_nn_within(const quat_nn_t *t, const quat_t *q, float angle,
+                               quat_nn_hit_t *hits, size_t max_hits)
+{
+   if (!(angle >= 0.0f))
+      return 0;
+   if (angle > (float)M_PI)
+      angle = (float)M_PI;
+   nn_within_t s = { t->nodes, *q, 2.0f * sinf(0.25f * angle), hits, max_hits, 0 };
+   nn_within_range(&s, 0, t->n);
+   return s.found;
+}
+
+
+typedef struct
+{
+   const quat_nn_t *t;
+   const quat_t *q;
+   size_t k;
+   quat_nn_hit_t *hits;
+}
+nn_batch_t;
+
+
+static void nn_knn_chunk(void *ctx, size_t first, size_t last)
+{
+   nn_batch_t *b = ctx;
+   for (size_t i = first; i < last; i++) {
+      quat_nn_hit_t *h = b->hits + i * b->k;
+      for (size_t j = quat_nn_knn(b->t, &b->q[i], b->k, h); j < b->k; j++) {
+         h[j].id = QUAT_NN_NONE;
+         h[j].angle = INFINITY;
+      }
+   }
+}
+
+
+QUAT_API void quat_nn_knn_n(quat_pool_t *p, const quat_nn_t *t, const quat_t *q, size_t n,
+                            size_t k, quat_nn_hit_t *hits)
+{
+   nn_batch_t b = { t, q, k, hits };
+   quat_pool_for(p, n, QUAT_NN_CHUNK, 2 * QUAT_NN_CHUNK, nn_knn_chunk, &b);
+}
+
+
+QUAT_API size_t quat_nn_size(const quat_nn_t *t)
+{
+   return sizeof(quat_nn_header_t) + t->n * sizeof(quat_nn_node_t);
+}
+
+
+QUAT_API int quat_nn_save(const quat_nn_t *t, void *buf, size_t size)
+{
+   quat_nn_header_t h;
+   if (size < quat_nn_size(t))
+      return -1;
+   memset(&h, 0, sizeof(h));
+   memcpy(h.magic, NN_MAGIC, sizeof(NN_MAGIC));
+   h.byte_order = NN_BYTE_ORDER;
+   h.version = NN_VERSION;
+   h.n = t->n;
+   memcpy(buf, &h, sizeof(h));
+   memcpy((char *)buf + sizeof(h), t->nodes, t->n * sizeof(quat_nn_node_t));
+   return 0;
+}
+
+
+QUAT_API int quat_nn_load(quat_nn_t *t, const void *buf, size_t size)
+{
+   const quat_nn_header_t *h = buf;
+   if ((uintptr_t)buf % 8 || size < sizeof(*h) || memcmp(h->magic, NN_MAGIC, sizeof(NN_MAGIC))
+       || h->byte_order != NN_BYTE_ORDER || h->version != NN_VERSION
+       || h->n >= QUAT_NN_NONE || h->n > (size - sizeof(*h)) / sizeof(quat_nn_node_t))
+      return -1;
+   t->n = h->n;
+   t->nodes = (const quat_nn_node_t *)(h + 1);
+   return 0;
+}
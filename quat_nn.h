@@ -0,0 +1,128 @@
+/*
+   quaternion library - orientation nearest neighbour index interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_NN_H__
+#define __QUAT_NN_H__
+
+
+#include <stdint.h>
+
+#include "quat.h"
+#include "quat_pool.h"
+
+
+/* A vantage point tree over rotations. The distance between unit
+ * quaternions p and q is d = min(|p - q|, |p + q|), which is the same
+ * for q and -q and is a metric on rotations; it grows with the rotation
+ * angle between them, angle = 4 asin(d / 2). Computed from the
+ * component differences it stays accurate for small angles, unlike
+ * 2 acos(|p . q|).
+ *
+ * The tree lives in a single array in build order: the node at the start
+ * of a range is the vantage point, the first half of the rest lies within
+ * its radius mu and the second half outside, so no child links are
+ * stored. The array is position independent and is the serialized form.
+ * Ranges of up to QUAT_NN_LEAF nodes are scanned linearly.
+ */
+
+#define QUAT_NN_LEAF 8
+
+/* id of unused k-nearest results */
+#define QUAT_NN_NONE UINT32_MAX
+
+/* queries per chunk of quat_nn_knn_n on a pool */
+#define QUAT_NN_CHUNK 64
+
+
+typedef struct
+{
+   quat_t q;
+   float mu;                 /* radius around q splitting the subtree */
+   uint32_t id;              /* index of q in the array the tree was built from */
+}
+quat_nn_node_t;
+
+typedef struct
+{
+   size_t n;
+   const quat_nn_node_t *nodes;
+}
+quat_nn_t;
+
+/* query result, angle in rad */
+typedef struct
+{
+   uint32_t id;
+   float angle;
+}
+quat_nn_hit_t;
+
+/* serialized index: this header, then n quat_nn_node_t, host byte order */
+typedef struct
+{
+   char magic[8];            /* "QUATNN" */
+   uint32_t byte_order;      /* 0x01020304 */
+   uint32_t version;         /* 1 */
+   uint64_t n;
+}
+quat_nn_header_t;
+
+
+/* build index t over the n unit quaternions q in caller provided storage
+ * of n nodes; q is not referenced afterwards. Expected O(n log n).
+ * Returns 0 on success, -1 if n is QUAT_NN_NONE or more.
+ */
+QUAT_API int quat_nn_build(quat_nn_t *t, quat_nn_node_t *storage, const quat_t *q, size_t n);
+
+/* up to k nearest neighbours of q into hits[0 .. k - 1], nearest first;
+ * returns the number found, min(k, t->n)
+ */
+QUAT_API size_t quat_nn_knn(const quat_nn_t *t, const quat_t *q, size_t k, quat_nn_hit_t *hits);
+
+/* all entries within angle rad of q; the first max_hits found are stored
+ * in hits in no particular order, the return value is the total number
+ */
+QUAT_API size_t quat_nn_within(const quat_nn_t *t, const quat_t *q, float angle,
+                               quat_nn_hit_t *hits, size_t max_hits);
+
+/* k nearest neighbours of each of the n queries q[i] into
+ * hits[i * k .. i * k + k - 1], split into chunks of QUAT_NN_CHUNK queries
+ * on pool p (may be NULL); results beyond t->n have id QUAT_NN_NONE and
+ * angle infinity
+ */
+QUAT_API void quat_nn_knn_n(quat_pool_t *p, const quat_nn_t *t, const quat_t *q, size_t n,
+                            size_t k, quat_nn_hit_t *hits);
+
+/* bytes of the serialized form of t */
+QUAT_API size_t quat_nn_size(const quat_nn_t *t);
+
+/* write t to buf of size bytes; returns 0 on success, -1 if it is too small */
+QUAT_API int quat_nn_save(const quat_nn_t *t, void *buf, size_t size);
+
+/* index t over the serialized form in buf (e.g. a memory mapped file),
+ * which must stay valid and 8 byte aligned; nothing is copied. Returns 0
+ * on success, -1 if buf holds no complete index of this byte order.
+ */
+QUAT_API int quat_nn_load(quat_nn_t *t, const void *buf, size_t size);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_nn.c"
+#endif
+
+
+#endif /* __QUAT_NN_H__ */
@@ -0,0 +1,614 @@
+/*
+   quaternion library - packet (SIMD) interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_PACKET_H__
+#define __QUAT_PACKET_H__
+
+
+#include <math.h>
+#include <string.h>
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+#include "quat.h"
+
+
+/* 4 and 8 float lanes; plain C operators work lane-wise on these.
+ * Without SSE/AVX the compiler lowers them to scalar code.
+ */
+typedef float vfloat4_t __attribute__((vector_size(16)));
+typedef float vfloat8_t __attribute__((vector_size(32)));
+
+/* lane masks, as produced by comparisons: all bits set where true */
+typedef int vint4_t __attribute__((vector_size(16)));
+typedef int vint8_t __attribute__((vector_size(32)));
+
+/* 4 and 8 double lanes, for sums that would cancel in float */
+typedef double vdouble4_t __attribute__((vector_size(32)));
+typedef double vdouble8_t __attribute__((vector_size(64)));
+
+
+/* all packet functions are static inline, so passing 8 lanes by value
+   without AVX does not affect any external ABI */
+#pragma GCC diagnostic push
+#if !defined(__AVX__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+
+/* 4 quaternions in structure of arrays form, lane i holds quaternion i */
+typedef struct
+{
+   vfloat4_t w;
+   vfloat4_t x;
+   vfloat4_t y;
+   vfloat4_t z;
+}
+quat4_t;
+
+
+/* 8 quaternions in structure of arrays form, lane i holds quaternion i */
+typedef struct
+{
+   vfloat8_t w;
+   vfloat8_t x;
+   vfloat8_t y;
+   vfloat8_t z;
+}
+quat8_t;
+
+
+/* 4 and 8 vectors in structure of arrays form */
+typedef struct
+{
+   vfloat4_t x;
+   vfloat4_t y;
+   vfloat4_t z;
+}
+vec3x4_t;
+
+typedef struct
+{
+   vfloat8_t x;
+   vfloat8_t y;
+   vfloat8_t z;
+}
+vec3x8_t;
+
+
+/*
+ * All packet functions compute exactly what the corresponding scalar
+ * function from quat.h computes for each lane, in the same evaluation order.
+ */
+
+
+/* lane-wise square root */
+static inline vfloat4_t vfloat4_sqrt(vfloat4_t v)
+{
+#if defined(__SSE__)
+   return (vfloat4_t)_mm_sqrt_ps((__m128)v);
+#else
+   for (int i = 0; i < 4; i++)
+      v[i] = sqrtf(v[i]);
+   return v;
+#endif
+}
+
+
+static inline vfloat8_t vfloat8_sqrt(vfloat8_t v)
+{
+#if defined(__AVX__)
+   return (vfloat8_t)_mm256_sqrt_ps((__m256)v);
+#else
+   for (int i = 0; i < 8; i++)
+      v[i] = sqrtf(v[i]);
+   return v;
+#endif
+}
+
+
+/* lane-wise m ? a : b */
+static inline vfloat4_t vfloat4_select(vint4_t m, vfloat4_t a, vfloat4_t b)
+{
+   return (vfloat4_t)((m & (vint4_t)a) | (~m & (vint4_t)b));
+}
+
+
+static inline vfloat8_t vfloat8_select(vint8_t m, vfloat8_t a, vfloat8_t b)
+{
+   return (vfloat8_t)((m & (vint8_t)a) | (~m & (vint8_t)b));
+}
+
+
+/* sincos, atan2, asin and angle wrapping, see quat_vmath_tmpl.h */
+#define VM_V vfloat4_t
+#define VM_VI vint4_t
+#define VM(name) vfloat4_##name
+#include "quat_vmath_tmpl.h"
+#undef VM_V
+#undef VM_VI
+#undef VM
+
+#define VM_V vfloat8_t
+#define VM_VI vint8_t
+#define VM(name) vfloat8_##name
+#include "quat_vmath_tmpl.h"
+#undef VM_V
+#undef VM_VI
+#undef VM
+
+
+/* load 4 quaternions from array q */
+static inline void quat4_load(quat4_t *p, const quat_t *q)
+{
+#if defined(__SSE__)
+   __m128 r0 = _mm_loadu_ps(q[0].vec);
+   __m128 r1 = _mm_loadu_ps(q[1].vec);
+   __m128 r2 = _mm_loadu_ps(q[2].vec);
+   __m128 r3 = _mm_loadu_ps(q[3].vec);
+   _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+   p->w = (vfloat4_t)r0;
+   p->x = (vfloat4_t)r1;
+   p->y = (vfloat4_t)r2;
+   p->z = (vfloat4_t)r3;
+#else
+   for (int i = 0; i < 4; i++) {
+      p->w[i] = q[i].w;
+      p->x[i] = q[i].x;
+      p->y[i] = q[i].y;
+      p->z[i] = q[i].z;
+   }
+#endif
+}
+
+
+/* store 4 quaternions to array q */
+static inline void quat4_store(quat_t *q, const quat4_t *p)
+{
+#if defined(__SSE__)
+   __m128 r0 = (__m128)p->w;
+   __m128 r1 = (__m128)p->x;
+   __m128 r2 = (__m128)p->y;
+   __m128 r3 = (__m128)p->z;
+   _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+   _mm_storeu_ps(q[0].vec, r0);
+   _mm_storeu_ps(q[1].vec, r1);
+   _mm_storeu_ps(q[2].vec, r2);
+   _mm_storeu_ps(q[3].vec, r3);
+#else
+   for (int i = 0; i < 4; i++) {
+      q[i].w = p->w[i];
+      q[i].x = p->x[i];
+      q[i].y = p->y[i];
+      q[i].z = p->z[i];
+   }
+#endif
+}
+
+
+/* set all 4 lanes to q */
+static inline void quat4_splat(quat4_t *p, const quat_t *q)
+{
+   p->w = (vfloat4_t){ q->w, q->w, q->w, q->w };
+   p->x = (vfloat4_t){ q->x, q->x, q->x, q->x };
+   p->y = (vfloat4_t){ q->y, q->y, q->y, q->y };
+   p->z = (vfloat4_t){ q->z, q->z, q->z, q->z };
+}
+
+
+/* o = q1 * q2 */
+static inline void quat4_mul(quat4_t *o, const quat4_t *q1, const quat4_t *q2)
+{
+   vfloat4_t x =  q1->x * q2->w + q1->y * q2->z - q1->z * q2->y + q1->w * q2->x;
+   vfloat4_t y = -q1->x * q2->z + q1->y * q2->w + q1->z * q2->x + q1->w * q2->y;
+   vfloat4_t z =  q1->x * q2->y - q1->y * q2->x + q1->z * q2->w + q1->w * q2->z;
+   vfloat4_t w = -q1->x * q2->x - q1->y * q2->y - q1->z * q2->z + q1->w * q2->w;
+   o->x = x;
+   o->y = y;
+   o->z = z;
+   o->w = w;
+}
+
+
+/* conjugate quaternions */
+static inline void quat4_conj(quat4_t *o, const quat4_t *q)
+{
+   o->x = -q->x;
+   o->y = -q->y;
+   o->z = -q->z;
+   o->w = q->w;
+}
+
+
+/* o = q1 + q2 */
+static inline void quat4_add(quat4_t *o, const quat4_t *q1, const quat4_t *q2)
+{
+   o->x = q1->x + q2->x;
+   o->y = q1->y + q2->y;
+   o->z = q1->z + q2->z;
+   o->w = q1->w + q2->w;
+}
+
+
+/* o = q * f */
+static inline void quat4_scale(quat4_t *o, const quat4_t *q, vfloat4_t f)
+{
+   o->w = q->w * f;
+   o->x = q->x * f;
+   o->y = q->y * f;
+   o->z = q->z * f;
+}
+
+
+/* lane-wise dot product q1 . q2 */
+static inline vfloat4_t quat4_dot(const quat4_t *q1, const quat4_t *q2)
+{
+   return q1->w * q2->w + q1->x * q2->x + q1->y * q2->y + q1->z * q2->z;
+}
+
+
+/* lane-wise length */
+static inline vfloat4_t quat4_len(const quat4_t *q)
+{
+   return vfloat4_sqrt(quat4_dot(q, q));
+}
+
+
+/* normalize quaternions q and put results into o */
+static inline void quat4_normalize(quat4_t *o, const quat4_t *q)
+{
+   quat4_scale(o, q, 1.0f / quat4_len(q));
+}
+
+
+/* load 4 vectors from array v */
+static inline void vec3x4_load(vec3x4_t *p, const vec3_t *v)
+{
+#if defined(__SSE__)
+   /* a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3 */
+   __m128 a = _mm_loadu_ps(v[0].vec), b = _mm_loadu_ps(v[1].vec + 1), c = _mm_loadu_ps(v[2].vec + 2);
+   __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+   p->x = (vfloat4_t)_mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+   t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+   __m128 u = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+   p->y = (vfloat4_t)_mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+   t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+   p->z = (vfloat4_t)_mm_shuffle_ps(t, c, _MM_SHUFFLE(3, 0, 2, 0));
+#else
+   float x[4], y[4], z[4];
+   for (int i = 0; i < 4; i++) {
+      x[i] = v[i].x;
+      y[i] = v[i].y;
+      z[i] = v[i].z;
+   }
+   memcpy(&p->x, x, sizeof(x));
+   memcpy(&p->y, y, sizeof(y));
+   memcpy(&p->z, z, sizeof(z));
+#endif
+}
+
+
+/* store 4 vectors to array v */
+static inline void vec3x4_store(vec3_t *v, const vec3x4_t *p)
+{
+#if defined(__SSE__)
+   __m128 x = (__m128)p->x, y = (__m128)p->y, z = (__m128)p->z;
+   __m128 t = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+   __m128 u = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+   _mm_storeu_ps(v[0].vec, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+   t = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+   u = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+   _mm_storeu_ps(v[1].vec + 1, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+   t = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+   u = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+   _mm_storeu_ps(v[2].vec + 2, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+   for (int i = 0; i < 4; i++) {
+      v[i].x = p->x[i];
+      v[i].y = p->y[i];
+      v[i].z = p->z[i];
+   }
+#endif
+}
+
+
+/* rotate vectors v via unit quaternions q, same terms as quat_rot_vec */
+static inline void quat4_rot_vec(vec3x4_t *o, const vec3x4_t *v, const quat4_t *q)
+{
+   const vfloat4_t vx = v->x, vy = v->y, vz = v->z;
+   const vfloat4_t qw = q->w, qx = q->x, qy = q->y, qz = q->z;
+   const vfloat4_t qww = qw * qw, qxx = qx * qx, qyy = qy * qy, qzz = qz * qz;
+   const vfloat4_t qwx = qw * qx, qwy = qw * qy, qwz = qw * qz, qxy = qx * qy;
+   const vfloat4_t qxz = qx * qz, qyz = qy * qz;
+   o->x = (qww + qxx - qyy - qzz) * vx + 2.0f * ((qxy - qwz) * vy + (qxz + qwy) * vz);
+   o->y = (qww - qxx + qyy - qzz) * vy + 2.0f * ((qxy + qwz) * vx + (qyz - qwx) * vz);
+   o->z = (qww - qxx - qyy + qzz) * vz + 2.0f * ((qxz - qwy) * vx + (qyz + qwx) * vy);
+}
+
+
+#if defined(__AVX__)
+/* 4x4 transpose within each 128 bit lane */
+#define QUAT8_TRANSPOSE(r0, r1, r2, r3) \
+   do { \
+      __m256 t0 = _mm256_unpacklo_ps(r0, r1); \
+      __m256 t1 = _mm256_unpacklo_ps(r2, r3); \
+      __m256 t2 = _mm256_unpackhi_ps(r0, r1); \
+      __m256 t3 = _mm256_unpackhi_ps(r2, r3); \
+      r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)); \
+      r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)); \
+      r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)); \
+      r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)); \
+   } while (0)
+#endif
+
+
+/* load 8 quaternions from array q */
+static inline void quat8_load(quat8_t *p, const quat_t *q)
+{
+#if defined(__AVX__)
+   __m256 r0 = _mm256_loadu2_m128(q[4].vec, q[0].vec);
+   __m256 r1 = _mm256_loadu2_m128(q[5].vec, q[1].vec);
+   __m256 r2 = _mm256_loadu2_m128(q[6].vec, q[2].vec);
+   __m256 r3 = _mm256_loadu2_m128(q[7].vec, q[3].vec);
+   QUAT8_TRANSPOSE(r0, r1, r2, r3);
+   p->w = (vfloat8_t)r0;
+   p->x = (vfloat8_t)r1;
+   p->y = (vfloat8_t)r2;
+   p->z = (vfloat8_t)r3;
+#else
+   for (int i = 0; i < 8; i++) {
+      p->w[i] = q[i].w;
+      p->x[i] = q[i].x;
+      p->y[i] = q[i].y;
+      p->z[i] = q[i].z;
+   }
+#endif
+}
+
+
+/* store 8 quaternions to array q */
+static inline void quat8_store(quat_t *q, const quat8_t *p)
+{
+#if defined(__AVX__)
+   __m256 r0 = (__m256)p->w;
+   __m256 r1 = (__m256)p->x;
+   __m256 r2 = (__m256)p->y;
+   __m256 r3 = (__m256)p->z;
+   QUAT8_TRANSPOSE(r0, r1, r2, r3);
+   _mm256_storeu2_m128(q[4].vec, q[0].vec, r0);
+   _mm256_storeu2_m128(q[5].vec, q[1].vec, r1);
+   _mm256_storeu2_m128(q[6].vec, q[2].vec, r2);
+   _mm256_storeu2_m128(q[7].vec, q[3].vec, r3);
+#else
+   for (int i = 0; i < 8; i++) {
+      q[i].w = p->w[i];
+      q[i].x = p->x[i];
+      q[i].y = p->y[i];
+      q[i].z = p->z[i];
+   }
+#endif
+}
+
+
+/* set all 8 lanes to q */
+static inline void quat8_splat(quat8_t *p, const quat_t *q)
+{
+   p->w = (vfloat8_t){ q->w, q->w, q->w, q->w, q->w, q->w, q->w, q->w };
+   p->x = (vfloat8_t){ q->x, q->x, q->x, q->x, q->x, q->x, q->x, q->x };
+   p->y = (vfloat8_t){ q->y, q->y, q->y, q->y, q->y, q->y, q->y, q->y };
+   p->z = (vfloat8_t){ q->z, q->z, q->z, q->z, q->z, q->z, q->z, q->z };
+}
+
+
+/* o = q1 * q2 */
+static inline void quat8_mul(quat8_t *o, const quat8_t *q1, const quat8_t *q2)
+{
+   vfloat8_t x =  q1->x * q2->w + q1->y * q2->z - q1->z * q2->y + q1->w * q2->x;
+   vfloat8_t y = -q1->x * q2->z + q1->y * q2->w + q1->z * q2->x + q1->w * q2->y;
+   vfloat8_t z =  q1->x * q2->y - q1->y * q2->x + q1->z * q2->w + q1->w * q2->z;
+   vfloat8_t w = -q1->x * q2->x - q1->y * q2->y - q1->z * q2->z + q1->w * q2->w;
+   o->x = x;
+   o->y = y;
+   o->z = z;
+   o->w = w;
+}
+
+
+/* conjugate quaternions */
+static inline void quat8_conj(quat8_t *o, const quat8_t *q)
+{
+   o->x = -q->x;
+   o->y = -q->y;
+   o->z = -q->z;
+   o->w = q->w;
+}
+
+
+/* o = q1 + q2 */
+static inline void quat8_add(quat8_t *o, const quat8_t *q1, const quat8_t *q2)
+{
+   o->x = q1->x + q2->x;
+   o->y = q1->y + q2->y;
+   o->z = q1->z + q2->z;
+   o->w = q1->w + q2->w;
+}
+
+
+/* o = q * f */
+static inline void quat8_scale(quat8_t *o, const quat8_t *q, vfloat8_t f)
+{
+   o->w = q->w * f;
+   o->x = q->x * f;
+   o->y = q->y * f;
+   o->z = q->z * f;
+}
+
+
+/* lane-wise dot product q1 . q2 */
+static inline vfloat8_t quat8_dot(const quat8_t *q1, const quat8_t *q2)
+{
+   return q1->w * q2->w + q1->x * q2->x + q1->y * q2->y + q1->z * q2->z;
+}
+
+
+/* lane-wise length */
+static inline vfloat8_t quat8_len(const quat8_t *q)
+{
+   return vfloat8_sqrt(quat8_dot(q, q));
+}
+
+
+/* normalize quaternions q and put results into o */
+static inline void quat8_normalize(quat8_t *o, const quat8_t *q)
+{
+   quat8_scale(o, q, 1.0f / quat8_len(q));
+}
+
+
+/* load 8 vectors from array v */
+static inline void vec3x8_load(vec3x8_t *p, const vec3_t *v)
+{
+#if defined(__SSE__)
+   vec3x4_t lo, hi;
+   vec3x4_load(&lo, v);
+   vec3x4_load(&hi, v + 4);
+   p->x = (vfloat8_t){ lo.x[0], lo.x[1], lo.x[2], lo.x[3], hi.x[0], hi.x[1], hi.x[2], hi.x[3] };
+   p->y = (vfloat8_t){ lo.y[0], lo.y[1], lo.y[2], lo.y[3], hi.y[0], hi.y[1], hi.y[2], hi.y[3] };
+   p->z = (vfloat8_t){ lo.z[0], lo.z[1], lo.z[2], lo.z[3], hi.z[0], hi.z[1], hi.z[2], hi.z[3] };
+#else
+   float x[8], y[8], z[8];
+   for (int i = 0; i < 8; i++) {
+      x[i] = v[i].x;
+      y[i] = v[i].y;
+      z[i] = v[i].z;
+   }
+   memcpy(&p->x, x, sizeof(x));
+   memcpy(&p->y, y, sizeof(y));
+   memcpy(&p->z, z, sizeof(z));
+#endif
+}
+
+
+/* store 8 vectors to array v */
+static inline void vec3x8_store(vec3_t *v, const vec3x8_t *p)
+{
+#if defined(__SSE__)
+   vec3x4_t lo, hi;
+   lo.x = (vfloat4_t){ p->x[0], p->x[1], p->x[2], p->x[3] };
+   lo.y = (vfloat4_t){ p->y[0], p->y[1], p->y[2], p->y[3] };
+   lo.z = (vfloat4_t){ p->z[0], p->z[1], p->z[2], p->z[3] };
+   hi.x = (vfloat4_t){ p->x[4], p->x[5], p->x[6], p->x[7] };
+   hi.y = (vfloat4_t){ p->y[4], p->y[5], p->y[6], p->y[7] };
+   hi.z = (vfloat4_t){ p->z[4], p->z[5], p->z[6], p->z[7] };
+   vec3x4_store(v, &lo);
+   vec3x4_store(v + 4, &hi);
+#else
+   for (int i = 0; i < 8; i++) {
+      v[i].x = p->x[i];
+      v[i].y = p->y[i];
+      v[i].z = p->z[i];
+   }
+#endif
+}
+
+
+/* rotate vectors v via unit quaternions q, same terms as quat_rot_vec */
+static inline void quat8_rot_vec(vec3x8_t *o, const vec3x8_t *v, const quat8_t *q)
+{
+   const vfloat8_t vx = v->x, vy = v->y, vz = v->z;
+   const vfloat8_t qw = q->w, qx = q->x, qy = q->y, qz = q->z;
+   const vfloat8_t qww = qw * qw, qxx = qx * qx, qyy = qy * qy, qzz = qz * qz;
+   const vfloat8_t qwx = qw * qx, qwy = qw * qy, qwz = qw * qz, qxy = qx * qy;
+   const vfloat8_t qxz = qx * qz, qyz = qy * qz;
+   o->x = (qww + qxx - qyy - qzz) * vx + 2.0f * ((qxy - qwz) * vy + (qxz + qwy) * vz);
+   o->y = (qww - qxx + qyy - qzz) * vy + 2.0f * ((qxy + qwz) * vx + (qyz - qwx) * vz);
+   o->z = (qww - qxx - qyy + qzz) * vz + 2.0f * ((qxz - qwy) * vx + (qyz + qwx) * vy);
+}
+
+
+/*
+ * Trig-free slerp, see quat_slerp_fast in quat.h.
+ * sin(t * omega) / sin(omega) is evaluated as
+ *    t * (1 + b1 * (1 + b2 * (... (1 + b8))))
+ *    with bi = (u[i] * t^2 - v[i]) * (cos(omega) - 1),
+ *    u[i] = 1 / (i * (2 * i + 1)), v[i] = i / (2 * i + 1);
+ * the last term is scaled by QUAT_SLERP_FAST_MU to compensate the truncation
+ * (D. Eberly, "A Fast and Accurate Algorithm for Computing SLERP").
+ */
+#define QUAT_SLERP_FAST_MU 1.85298109240830f
+#define QUAT_SLERP_FAST_U { 1.0f / 3, 1.0f / 10, 1.0f / 21, 1.0f / 36, \
+                            1.0f / 55, 1.0f / 78, 1.0f / 105, QUAT_SLERP_FAST_MU / 136 }
+#define QUAT_SLERP_FAST_V { 1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9, \
+                            5.0f / 11, 6.0f / 13, 7.0f / 15, QUAT_SLERP_FAST_MU * 8 / 17 }
+
+
+/* lane-wise quat_slerp_fast(o, q0, q1, t) */
+static inline void quat4_slerp_fast(quat4_t *o, const quat4_t *q0, const quat4_t *q1, vfloat4_t t)
+{
+   static const float u[8] = QUAT_SLERP_FAST_U, v[8] = QUAT_SLERP_FAST_V;
+   const vfloat4_t one = { 1.0f, 1.0f, 1.0f, 1.0f };
+   vfloat4_t x = quat4_dot(q0, q1);
+   /* adjust for shortest path: sign = x < 0 ? -1 : 1 */
+   vint4_t neg = x < 0.0f;
+   vfloat4_t sign = (vfloat4_t)((neg & (vint4_t)(-one)) | (~neg & (vint4_t)one));
+   vfloat4_t xm1 = x * sign - 1.0f;
+   vfloat4_t d = 1.0f - t;
+   vfloat4_t tt = t * t, dd = d * d;
+   vfloat4_t bt = one, bd = one;
+   for (int i = 7; i >= 0; i--) {
+      bt = 1.0f + (u[i] * tt - v[i]) * xm1 * bt;
+      bd = 1.0f + (u[i] * dd - v[i]) * xm1 * bd;
+   }
+   vfloat4_t scale0 = d * bd;
+   vfloat4_t scale1 = sign * t * bt;
+   o->x = scale0 * q0->x + scale1 * q1->x;
+   o->y = scale0 * q0->y + scale1 * q1->y;
+   o->z = scale0 * q0->z + scale1 * q1->z;
+   o->w = scale0 * q0->w + scale1 * q1->w;
+}
+
+
+/* lane-wise quat_slerp_fast(o, q0, q1, t) */
+static inline void quat8_slerp_fast(quat8_t *o, const quat8_t *q0, const quat8_t *q1, vfloat8_t t)
+{
+   static const float u[8] = QUAT_SLERP_FAST_U, v[8] = QUAT_SLERP_FAST_V;
+   const vfloat8_t one = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+   vfloat8_t x = quat8_dot(q0, q1);
+   vint8_t neg = x < 0.0f;
+   vfloat8_t sign = (vfloat8_t)((neg & (vint8_t)(-one)) | (~neg & (vint8_t)one));
+   vfloat8_t xm1 = x * sign - 1.0f;
+   vfloat8_t d = 1.0f - t;
+   vfloat8_t tt = t * t, dd = d * d;
+   vfloat8_t bt = one, bd = one;
+   for (int i = 7; i >= 0; i--) {
+      bt = 1.0f + (u[i] * tt - v[i]) * xm1 * bt;
+      bd = 1.0f + (u[i] * dd - v[i]) * xm1 * bd;
+   }
+   vfloat8_t scale0 = d * bd;
+   vfloat8_t scale1 = sign * t * bt;
+   o->x = scale0 * q0->x + scale1 * q1->x;
+   o->y = scale0 * q0->y + scale1 * q1->y;
+   o->z = scale0 * q0->z + scale1 * q1->z;
+   o->w = scale0 * q0->w + scale1 * q1->w;
+}
+
+
+#pragma GCC diagnostic pop
+
+
+#endif /* __QUAT_PACKET_H__ */
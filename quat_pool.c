@@ -0,0 +1,270 @@
+/*
+   quaternion library - parallel batch executor implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * Every thread owns a run of chunks, packed as next << 32 | end into one
+ * word. The owner takes chunks from the front and thieves take them from
+ * the back, both by compare and swap on the whole word, so each chunk is
+ * taken exactly once. Runs only shrink during a job; a thread that found
+ * every run empty is done.
+ */
+
+
+#include <string.h>
+
+#include "quat_pool.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+#define POOL_RANGE(next, end) ((uint64_t)(next) << 32 | (uint64_t)(end))
+
+
+/* take the next chunk of run r (steal = 0) or the last one (steal = 1);
+   returns 0 if the run is empty */
+static int pool_take(quat_pool_range_t *r, int steal, size_t *chunk)
+{
+   uint64_t old = __atomic_load_n(&r->range, __ATOMIC_ACQUIRE);
+   for (;;) {
+      uint32_t next = (uint32_t)(old >> 32), end = (uint32_t)old;
+      if (next >= end)
+         return 0;
+      uint64_t new = steal ? POOL_RANGE(next, end - 1) : POOL_RANGE(next + 1, end);
+      if (__atomic_compare_exchange_n(&r->range, &old, new, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+         *chunk = steal ? end - 1 : next;
+         return 1;
+      }
+   }
+}
+
+
+static void pool_chunk(quat_pool_t *p, size_t c)
+{
+   size_t first = c * p->chunk, last = first + p->chunk;
+   p->fn(p->ctx, first, last < p->n ? last : p->n);
+}
+
+
+/* own run first, then the runs of the others, starting at the next thread */
+static void pool_run(quat_pool_t *p, int id)
+{
+   size_t c;
+   while (pool_take(&p->ranges[id], 0, &c))
+      pool_chunk(p, c);
+   for (int k = 1; k < p->threads; k++) {
+      quat_pool_range_t *r = &p->ranges[(id + k) % p->threads];
+      while (pool_take(r, 1, &c))
+         pool_chunk(p, c);
+   }
+}
+
+
+static void *pool_worker(void *arg)
+{
+   quat_pool_worker_t *w = arg;
+   quat_pool_t *p = w->pool;
+   unsigned long seen = 0;
+
+   for (;;) {
+      pthread_mutex_lock(&p->lock);
+      while (!p->stop && p->gen == seen)
+         pthread_cond_wait(&p->wake, &p->lock);
+      if (p->stop) {
+         pthread_mutex_unlock(&p->lock);
+         return NULL;
+      }
+      seen = p->gen;
+      pthread_mutex_unlock(&p->lock);
+
+      pool_run(p, w->id);
+
+      pthread_mutex_lock(&p->lock);
+      if (--p->busy == 0)
+         pthread_cond_signal(&p->done);
+      pthread_mutex_unlock(&p->lock);
+   }
+}
+
+
+QUAT_API int quat_pool_init(quat_pool_t *p, int threads)
+{
+   if (threads > QUAT_POOL_MAX_THREADS)
+      threads = QUAT_POOL_MAX_THREADS;
+   if (threads < 1)
+      threads = 1;
+   memset(p, 0, sizeof(*p));
+   if (pthread_mutex_init(&p->lock, NULL))
+      return -1;
+   if (pthread_cond_init(&p->wake, NULL)) {
+      pthread_mutex_destroy(&p->lock);
+      return -1;
+   }
+   if (pthread_cond_init(&p->done, NULL)) {
+      pthread_cond_destroy(&p->wake);
+      pthread_mutex_destroy(&p->lock);
+      return -1;
+   }
+   /* worker 0 is the caller of quat_pool_for */
+   p->threads = 1;
+   for (int t = 1; t < threads; t++) {
+      p->workers[t].pool = p;
+      p->workers[t].id = t;
+      if (pthread_create(&p->tids[t], NULL, pool_worker, &p->workers[t]))
+         break;
+      p->threads++;
+   }
+   return 0;
+}
+
+
+QUAT_API void quat_pool_destroy(quat_pool_t *p)
+{
+   pthread_mutex_lock(&p->lock);
+   p->stop = 1;
+   pthread_cond_broadcast(&p->wake);
+   pthread_mutex_unlock(&p->lock);
+   for (int t = 1; t < p->threads; t++)
+      pthread_join(p->tids[t], NULL);
+   pthread_cond_destroy(&p->done);
+   pthread_cond_destroy(&p->wake);
+   pthread_mutex_destroy(&p->lock);
+}
+
+
+QUAT_API void quat_pool_for(quat_pool_t *p, size_t n, size_t chunk, size_t min_parallel,
+                            quat_pool_fn_t fn, void *ctx)
+{
+   if (chunk < 1)
+      chunk = 1;
+   size_t chunks = (n + chunk - 1) / chunk;
+
+   if (!p || p->threads == 1 || n < min_parallel || chunks < 2 || chunks > UINT32_MAX) {
+      for (size_t c = 0; c < chunks; c++) {
+         size_t first = c * chunk, last = first + chunk;
+         fn(ctx, first, last < n ? last : n);
+      }
+      return;
+   }
+
+   pthread_mutex_lock(&p->lock);
+   p->fn = fn;
+   p->ctx = ctx;
+   p->n = n;
+   p->chunk = chunk;
+   /* equal runs of chunks, the runs of surplus threads are empty */
+   FOR_N(t, p->threads)
+      p->ranges[t].range = POOL_RANGE(chunks * t / p->threads, chunks * (t + 1) / p->threads);
+   p->busy = p->threads - 1;
+   p->gen++;
+   pthread_cond_broadcast(&p->wake);
+   pthread_mutex_unlock(&p->lock);
+
+   pool_run(p, 0);
+
+   pthread_mutex_lock(&p->lock);
+   while (p->busy > 0)
+      pthread_cond_wait(&p->done, &p->lock);
+   pthread_mutex_unlock(&p->lock);
+}
+
+
+/* wrappers of the array functions, elements [first, last) per chunk */
+
+typedef struct
+{
+   void *o;
+   const void *a, *b, *c;
+   float f;
+}
+pool_args_t;
+
+
+static void pool_mul(void *ctx, size_t first, size_t last)
+{
+   pool_args_t *a = ctx;
+   quat_mul_n((quat_t *)a->o + first, (const quat_t *)a->a + first, (const quat_t *)a->b + first,
+              last - first);
+}
+
+
+static void pool_normalize(void *ctx, size_t first, size_t last)
+{
+   pool_args_t *a = ctx;
+   quat_normalize_n((quat_t *)a->o + first, (const quat_t *)a->a + first, last - first);
+}
+
+
+static void pool_rot_vec(void *ctx, size_t first, size_t last)
+{
+   pool_args_t *a = ctx;
+   quat_rot_vec_n((vec3_t *)a->o + first, (const vec3_t *)a->a + first, a->b, last - first);
+}
+
+
+static void pool_slerp_fast(void *ctx, size_t first, size_t last)
+{
+   pool_args_t *a = ctx;
+   quat_slerp_fast_n((quat_t *)a->o + first, (const quat_t *)a->a + first, (const quat_t *)a->b + first,
+                     (const float *)a->c + first, last - first);
+}
+
+
+static void pool_integrate(void *ctx, size_t first, size_t last)
+{
+   pool_args_t *a = ctx;
+   quat_integrate_n((quat_t *)a->o + first, (const quat_t *)a->a + first, (const vec3_t *)a->b + first,
+                    a->f, last - first);
+}
+
+
+QUAT_API void quat_pool_mul_n(quat_pool_t *p, quat_t *o, const quat_t *q1, const quat_t *q2, size_t n)
+{
+   pool_args_t a = { .o = o, .a = q1, .b = q2 };
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, pool_mul, &a);
+}
+
+
+QUAT_API void quat_pool_normalize_n(quat_pool_t *p, quat_t *qo, const quat_t *qi, size_t n)
+{
+   pool_args_t a = { .o = qo, .a = qi };
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, pool_normalize, &a);
+}
+
+
+QUAT_API void quat_pool_rot_vec_n(quat_pool_t *p, vec3_t *vo, const vec3_t *vi, const quat_t *q, size_t n)
+{
+   pool_args_t a = { .o = vo, .a = vi, .b = q };
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, pool_rot_vec, &a);
+}
+
+
+QUAT_API void quat_pool_slerp_fast_n(quat_pool_t *p, quat_t *qo, const quat_t *qfrom, const quat_t *qto,
+                                     const float *t, size_t n)
+{
+   pool_args_t a = { .o = qo, .a = qfrom, .b = qto, .c = t };
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, pool_slerp_fast, &a);
+}
+
+
+QUAT_API void quat_pool_integrate_n(quat_pool_t *p, quat_t *qo, const quat_t *q, const vec3_t *omega,
+                                    float dt, size_t n)
+{
+   pool_args_t a = { .o = qo, .a = q, .b = omega, .f = dt };
+   quat_pool_for(p, n, QUAT_POOL_CHUNK, QUAT_POOL_MIN_PARALLEL, pool_integrate, &a);
+}
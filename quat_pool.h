@@ -0,0 +1,120 @@
+/*
+   quaternion library - parallel batch executor interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_POOL_H__
+#define __QUAT_POOL_H__
+
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "quat.h"
+
+
+/* A pool of worker threads that runs a kernel over the index range
+ * [0, n) in chunks of fixed size. The chunk boundaries depend only on n
+ * and the chunk size, never on the number of threads, so a kernel that
+ * gives the same result for the same chunk gives bit for bit the same
+ * output with any pool. Each thread starts with an equal run of chunks
+ * and, when done with it, steals single chunks from the end of the runs
+ * of the others.
+ */
+
+/* upper limit for the threads of a pool */
+#define QUAT_POOL_MAX_THREADS 64
+
+/* chunk size and single thread threshold of the quat_pool_*_n wrappers,
+ * in elements; below the threshold thread wake up costs more than it saves
+ */
+#define QUAT_POOL_CHUNK 4096
+#define QUAT_POOL_MIN_PARALLEL 32768
+
+
+/* kernel over elements [first, last) */
+typedef void (*quat_pool_fn_t)(void *ctx, size_t first, size_t last);
+
+
+typedef struct
+{
+   uint64_t range;           /* next chunk << 32 | end chunk */
+}
+__attribute__((aligned(64)))
+quat_pool_range_t;
+
+typedef struct quat_pool quat_pool_t;
+
+typedef struct
+{
+   quat_pool_t *pool;
+   int id;
+}
+quat_pool_worker_t;
+
+struct quat_pool
+{
+   int threads;              /* including the calling thread */
+   pthread_mutex_t lock;
+   pthread_cond_t wake, done;
+   unsigned long gen;        /* incremented for each job */
+   int busy;                 /* workers still on the current job */
+   int stop;
+   quat_pool_fn_t fn;        /* current job */
+   void *ctx;
+   size_t n, chunk;
+   pthread_t tids[QUAT_POOL_MAX_THREADS];
+   quat_pool_worker_t workers[QUAT_POOL_MAX_THREADS];
+   quat_pool_range_t ranges[QUAT_POOL_MAX_THREADS];
+};
+
+
+/* start a pool of threads threads (clamped to [1, QUAT_POOL_MAX_THREADS]),
+ * the thread calling quat_pool_for is one of them; returns 0 on success,
+ * -1 if no synchronization objects could be created. If fewer worker
+ * threads can be started, the pool runs with those.
+ */
+QUAT_API int quat_pool_init(quat_pool_t *p, int threads);
+
+/* stop and join the workers */
+QUAT_API void quat_pool_destroy(quat_pool_t *p);
+
+/* run fn over [0, n) in chunks of chunk elements and return when all
+ * are done; n below min_parallel runs the same chunks in order on the
+ * calling thread. p may be NULL for single threaded execution. One
+ * quat_pool_for at a time per pool.
+ */
+QUAT_API void quat_pool_for(quat_pool_t *p, size_t n, size_t chunk, size_t min_parallel,
+                            quat_pool_fn_t fn, void *ctx);
+
+
+/* array functions of quat.h run on pool p with QUAT_POOL_CHUNK and
+ * QUAT_POOL_MIN_PARALLEL; results match the functions themselves
+ */
+QUAT_API void quat_pool_mul_n(quat_pool_t *p, quat_t *o, const quat_t *q1, const quat_t *q2, size_t n);
+QUAT_API void quat_pool_normalize_n(quat_pool_t *p, quat_t *qo, const quat_t *qi, size_t n);
+QUAT_API void quat_pool_rot_vec_n(quat_pool_t *p, vec3_t *vo, const vec3_t *vi, const quat_t *q, size_t n);
+QUAT_API void quat_pool_slerp_fast_n(quat_pool_t *p, quat_t *qo, const quat_t *qfrom, const quat_t *qto,
+                                     const float *t, size_t n);
+QUAT_API void quat_pool_integrate_n(quat_pool_t *p, quat_t *qo, const quat_t *q, const vec3_t *omega,
+                                    float dt, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_pool.c"
+#endif
+
+
+#endif /* __QUAT_POOL_H__ */
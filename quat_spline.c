@@ -0,0 +1,312 @@
+/*
+   quaternion library - SQUAD spline implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+#include <string.h>
+
+#include "quat_spline.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+#if defined(__AVX__)
+#define SPLINE_LANES 8
+#define SPLINE_V vfloat8_t
+#define SPLINE_VI vint8_t
+#define SPLINE_VF(op) vfloat8_##op
+#define SPLINE_QP_T quat8_t
+#define SPLINE_QP(op) quat8_##op
+#else
+#define SPLINE_LANES 4
+#define SPLINE_V vfloat4_t
+#define SPLINE_VI vint4_t
+#define SPLINE_VF(op) vfloat4_##op
+#define SPLINE_QP_T quat4_t
+#define SPLINE_QP(op) quat4_##op
+#endif
+
+/* angles below this are interpolated linearly; the error is about
+   angle^2 / 8, far below float precision */
+#define SPLINE_LINEAR 1.0e-6f
+
+
+static void spline_to_d(quatd_t *o, const quat_t *q)
+{
+   FOR_N(c, 4)
+      o->vec[c] = q->vec[c];
+}
+
+
+/* inner control point s_i from the keys in segs[i - 1 .. i + 1], in double */
+static void spline_ctrl(quat_spline_seg_t *sg, int n, int i)
+{
+   quatd_t q, qc, sum = { { 0.0, 0.0, 0.0, 0.0 } }, e, s;
+   if (i == 0 || i == n - 1) {
+      sg[i].s = sg[i].q;
+      return;
+   }
+   spline_to_d(&q, &sg[i].q);
+   quatd_conj(&qc, &q);
+   for (int j = i - 1; j <= i + 1; j += 2) {
+      quatd_t k, r, l;
+      spline_to_d(&k, &sg[j].q);
+      quatd_mul(&r, &qc, &k);
+      /* shortest path to the neighbour */
+      if (r.w < 0.0)
+         quatd_scale_self(&r, -1.0);
+      quatd_log(&l, &r);
+      FOR_N(c, 4)
+         sum.vec[c] += l.vec[c];
+   }
+   quatd_scale_self(&sum, -0.25);
+   quatd_exp(&e, &sum);
+   quatd_mul(&s, &q, &e);
+   FOR_N(c, 4)
+      sg[i].s.vec[c] = (float)s.vec[c];
+}
+
+
+/* angle between unit quaternions a and b, 1 / its sine and its cotangent */
+static void spline_angle(const quat_t *a, const quat_t *b, float *omega, float *inv_sin, float *cot)
+{
+   double d = 0.0, s = 0.0;
+   FOR_N(c, 4) {
+      double u = (double)a->vec[c] - (double)b->vec[c], v = (double)a->vec[c] + (double)b->vec[c];
+      d += u * u;
+      s += v * v;
+   }
+   double w = 2.0 * atan2(sqrt(d), sqrt(s));
+   *omega = (float)w;
+   *inv_sin = *omega > SPLINE_LINEAR ? (float)(1.0 / sin(w)) : 0.0f;
+   *cot = *omega > SPLINE_LINEAR ? (float)(1.0 / tan(w)) : 0.0f;
+}
+
+
+/* segment i from the keys and control points of i and i + 1 */
+static void spline_seg(quat_spline_seg_t *sg, int n, int i)
+{
+   quat_spline_seg_t *g = &sg[i];
+   if (i == n - 1) {
+      /* hold segment for the last key */
+      g->inv_dt = 0.0f;
+      g->omega = g->inv_sin = g->cot = 0.0f;
+      g->s_omega = g->s_inv_sin = g->s_cot = 0.0f;
+      g->q1 = g->q;
+      g->s1 = g->s;
+      return;
+   }
+   const quat_spline_seg_t *h = &sg[i + 1];
+   g->inv_dt = 1.0f / (h->t0 - g->t0);
+   float sign = quat_dot(&g->q, &h->q) < 0.0f ? -1.0f : 1.0f;
+   quat_scale(&g->q1, &h->q, sign);
+   quat_scale(&g->s1, &h->s, sign);
+   spline_angle(&g->q, &g->q1, &g->omega, &g->inv_sin, &g->cot);
+   spline_angle(&g->s, &g->s1, &g->s_omega, &g->s_inv_sin, &g->s_cot);
+}
+
+
+QUAT_API int quat_spline_init(quat_spline_t *sp, quat_spline_seg_t *segs, const quat_key_t *keys, int n)
+{
+   if (n < 1)
+      return -1;
+   for (int i = 0; i < n - 1; i++)
+      if (!(keys[i + 1].t > keys[i].t))
+         return -1;
+   for (int i = 0; i < n; i++) {
+      segs[i].t0 = keys[i].t;
+      segs[i].q = keys[i].q;
+   }
+   for (int i = 0; i < n; i++)
+      spline_ctrl(segs, n, i);
+   for (int i = 0; i < n; i++)
+      spline_seg(segs, n, i);
+   sp->segs = segs;
+   sp->n = n;
+   sp->cursor = 0;
+   return 0;
+}
+
+
+QUAT_API int quat_spline_set_key(quat_spline_t *sp, int i, const quat_key_t *key)
+{
+   quat_spline_seg_t *sg = sp->segs;
+   int n = sp->n;
+   if (i < 0 || i >= n || (i > 0 && !(key->t > sg[i - 1].t0)) || (i < n - 1 && !(key->t < sg[i + 1].t0)))
+      return -1;
+   sg[i].t0 = key->t;
+   sg[i].q = key->q;
+   /* s_i - 1 .. s_i + 1 depend on key i, segments i - 2 .. i + 1 on them */
+   for (int j = i - 1; j <= i + 1; j++)
+      if (j >= 0 && j < n)
+         spline_ctrl(sg, n, j);
+   for (int j = i - 2; j <= i + 1; j++)
+      if (j >= 0 && j < n)
+         spline_seg(sg, n, j);
+   return 0;
+}
+
+
+QUAT_API void quat_spline_get_key(const quat_spline_t *sp, int i, quat_key_t *key)
+{
+   key->t = sp->segs[i].t0;
+   key->q = sp->segs[i].q;
+}
+
+
+static inline int spline_find(quat_spline_t *sp, float t)
+{
+   return quat_track_find(sp->segs, sizeof(quat_spline_seg_t), sp->n, &sp->cursor, t);
+}
+
+
+static float spline_u(const quat_spline_seg_t *g, float t)
+{
+   float u = (t - g->t0) * g->inv_dt;
+   if (u < 0.0f)
+      u = 0.0f;
+   else if (u > 1.0f)
+      u = 1.0f;
+   return u;
+}
+
+
+/* slerp with a known angle omega, inv_sin = 1 / sin(omega) and
+   cot = cos(omega) / sin(omega), or linear for inv_sin = 0 */
+static void spline_slerp(quat_t *o, const quat_t *a, const quat_t *b, float omega, float inv_sin,
+                         float cot, float u)
+{
+   float w0 = 1.0f - u, w1 = u;
+   if (inv_sin != 0.0f) {
+      float s = sinf(u * omega), c = cosf(u * omega);
+      w0 = c - s * cot;
+      w1 = s * inv_sin;
+   }
+   FOR_N(c, 4)
+      o->vec[c] = w0 * a->vec[c] + w1 * b->vec[c];
+}
+
+
+static void spline_seg_eval(const quat_spline_seg_t *g, quat_t *qo, float t)
+{
+   quat_t p, r;
+   float u = spline_u(g, t), d = 0.0f, s = 0.0f;
+   spline_slerp(&p, &g->q, &g->q1, g->omega, g->inv_sin, g->cot, u);
+   spline_slerp(&r, &g->s, &g->s1, g->s_omega, g->s_inv_sin, g->s_cot, u);
+   FOR_N(c, 4) {
+      float a = p.vec[c] - r.vec[c], b = p.vec[c] + r.vec[c];
+      d += a * a;
+      s += b * b;
+   }
+   float omega = 2.0f * atan2f(sqrtf(d), sqrtf(s));
+   float inv_sin = 0.0f, cot = 0.0f;
+   if (omega > SPLINE_LINEAR) {
+      inv_sin = 1.0f / sinf(omega);
+      cot = cosf(omega) * inv_sin;
+   }
+   spline_slerp(qo, &p, &r, omega, inv_sin, cot, 2.0f * u * (1.0f - u));
+}
+
+
+QUAT_API quat_t *quat_spline_eval(quat_spline_t *sp, quat_t *qo, float t)
+{
+   spline_seg_eval(&sp->segs[spline_find(sp, t)], qo, t);
+   return qo;
+}
+
+
+static inline void spline_slerp_lanes(SPLINE_QP_T *o, const SPLINE_QP_T *a, const SPLINE_QP_T *b,
+                                      SPLINE_V omega, SPLINE_V inv_sin, SPLINE_V cot, SPLINE_V u)
+{
+   SPLINE_V s, c;
+   SPLINE_QP_T x, y;
+   SPLINE_VF(sincos)(&s, &c, u * omega);
+   SPLINE_VI lin = inv_sin == 0.0f;
+   SPLINE_QP(scale)(&x, a, SPLINE_VF(select)(lin, 1.0f - u, c - s * cot));
+   SPLINE_QP(scale)(&y, b, SPLINE_VF(select)(lin, u, s * inv_sin));
+   SPLINE_QP(add)(o, &x, &y);
+}
+
+
+/* SPLINE_LANES times t[0 ..] into qo[0 ..]; the segments are found and
+   gathered per lane, the slerps run across lanes */
+static inline void spline_lanes(quat_spline_t *sp, quat_t *qo, const float *t)
+{
+   quat_t q[SPLINE_LANES], q1[SPLINE_LANES], s[SPLINE_LANES], s1[SPLINE_LANES];
+   float u[SPLINE_LANES], om[SPLINE_LANES], is[SPLINE_LANES], ct[SPLINE_LANES];
+   float som[SPLINE_LANES], sis[SPLINE_LANES], sct[SPLINE_LANES];
+   FOR_N(l, SPLINE_LANES) {
+      const quat_spline_seg_t *g = &sp->segs[spline_find(sp, t[l])];
+      u[l] = spline_u(g, t[l]);
+      om[l] = g->omega;
+      is[l] = g->inv_sin;
+      ct[l] = g->cot;
+      som[l] = g->s_omega;
+      sis[l] = g->s_inv_sin;
+      sct[l] = g->s_cot;
+      q[l] = g->q;
+      q1[l] = g->q1;
+      s[l] = g->s;
+      s1[l] = g->s1;
+   }
+   SPLINE_QP_T pq, pq1, ps, ps1, p, r, d, a, o;
+   SPLINE_V vu, vom, vis, vct, vsom, vsis, vsct, sin_o, cos_o;
+   memcpy(&vu, u, sizeof(vu));
+   memcpy(&vom, om, sizeof(vom));
+   memcpy(&vis, is, sizeof(vis));
+   memcpy(&vct, ct, sizeof(vct));
+   memcpy(&vsom, som, sizeof(vsom));
+   memcpy(&vsis, sis, sizeof(vsis));
+   memcpy(&vsct, sct, sizeof(vsct));
+   SPLINE_QP(load)(&pq, q);
+   SPLINE_QP(load)(&pq1, q1);
+   SPLINE_QP(load)(&ps, s);
+   SPLINE_QP(load)(&ps1, s1);
+   spline_slerp_lanes(&p, &pq, &pq1, vom, vis, vct, vu);
+   spline_slerp_lanes(&r, &ps, &ps1, vsom, vsis, vsct, vu);
+   SPLINE_QP(scale)(&d, &r, (SPLINE_V){ 0.0f } - 1.0f);
+   SPLINE_QP(add)(&d, &p, &d);
+   SPLINE_QP(add)(&a, &p, &r);
+   /* chords far below the linear limit are zeroed, the polynomials of
+      atan2 and sincos would go through denormals on smooth paths */
+   SPLINE_V ld = SPLINE_QP(len)(&d);
+   ld = SPLINE_VF(select)(ld > 0.1f * SPLINE_LINEAR, ld, (SPLINE_V){ 0.0f });
+   SPLINE_V omega = 2.0f * SPLINE_VF(atan2)(ld, SPLINE_QP(len)(&a));
+   SPLINE_VF(sincos)(&sin_o, &cos_o, omega);
+   SPLINE_V inv_sin = SPLINE_VF(select)(omega > SPLINE_LINEAR, 1.0f / sin_o, (SPLINE_V){ 0.0f });
+   spline_slerp_lanes(&o, &p, &r, omega, inv_sin, cos_o * inv_sin, 2.0f * vu * (1.0f - vu));
+   SPLINE_QP(store)(qo, &o);
+}
+
+
+QUAT_API void quat_spline_eval_n(quat_spline_t *sp, quat_t *qo, const float *t, size_t n)
+{
+   size_t i = 0;
+   for (; i + SPLINE_LANES <= n; i += SPLINE_LANES)
+      spline_lanes(sp, qo + i, t + i);
+   if (i < n) {
+      /* pad the tail with its last time */
+      quat_t o[SPLINE_LANES];
+      float tt[SPLINE_LANES];
+      FOR_N(l, SPLINE_LANES)
+         tt[l] = t[i + (size_t)l < n ? i + (size_t)l : n - 1];
+      spline_lanes(sp, o, tt);
+      memcpy(qo + i, o, (n - i) * sizeof(quat_t));
+   }
+}
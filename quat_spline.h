@@ -0,0 +1,110 @@
+/*
+   quaternion library - SQUAD spline interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_SPLINE_H__
+#define __QUAT_SPLINE_H__
+
+
+#include "quat.h"
+#include "quat_track.h"
+
+
+/* see: K. Shoemake, Animating rotation with quaternion curves, 1985
+ *
+ * Between keys q_i and q_i+1 the spline is
+ *
+ *    squad(u) = slerp(slerp(q_i, q_i+1, u), slerp(s_i, s_i+1, u), 2u (1 - u))
+ *
+ * with inner control points
+ *
+ *    s_i = q_i exp(-(log(q_i* q_i+1) + log(q_i* q_i-1)) / 4)
+ *
+ * and s_i = q_i at the first and last key. It passes through the keys
+ * with continuous angular velocity for evenly spaced key times; uneven
+ * spacing keeps it smooth in shape, but the speed jumps at the keys.
+ *
+ * The control points and the angles of both fixed slerps are computed
+ * once per segment, and each slerp takes one sine and cosine pair via
+ * sin((1 - u) w) = sin(w) (cos(u w) - cot(w) sin(u w)), so an evaluation
+ * costs one angle and three pairs. Editing a key updates only the four
+ * segments around it.
+ */
+
+
+/* precomputed segment between two consecutive keys */
+typedef struct
+{
+   float t0;       /* time of key i */
+   float inv_dt;   /* 1 / segment duration, 0 for the final hold segment */
+   float omega;    /* angle between q and q1 */
+   float inv_sin;  /* 1 / sin(omega), 0 if q and q1 are equal */
+   float cot;      /* cos(omega) / sin(omega) */
+   float s_omega;  /* the same between s and s1 */
+   float s_inv_sin;
+   float s_cot;
+   quat_t q;       /* key i as given */
+   quat_t q1;      /* key i + 1, sign corrected for the shortest path */
+   quat_t s;       /* s_i, same sign as q */
+   quat_t s1;      /* s_i+1, same sign as q1 */
+}
+quat_spline_seg_t;
+
+
+/* spline; segs holds one segment per key, the last one holds the final
+ * key for all times after it
+ */
+typedef struct
+{
+   quat_spline_seg_t *segs;
+   int n;
+   int cursor;     /* segment of the last evaluation */
+}
+quat_spline_t;
+
+
+/* build spline from n unit quaternion keys with strictly increasing
+ * times into caller provided storage segs[n]; returns 0 on success,
+ * -1 on invalid keys
+ */
+QUAT_API int quat_spline_init(quat_spline_t *sp, quat_spline_seg_t *segs, const quat_key_t *keys, int n);
+
+/* replace key i; returns 0 on success, -1 if i is out of range or the
+ * time is not between those of the neighbouring keys
+ */
+QUAT_API int quat_spline_set_key(quat_spline_t *sp, int i, const quat_key_t *key);
+
+/* key i */
+QUAT_API void quat_spline_get_key(const quat_spline_t *sp, int i, quat_key_t *key);
+
+/* evaluate spline at time t; times outside the key range are clamped.
+ * Monotonic playback does not need to search.
+ */
+QUAT_API quat_t *quat_spline_eval(quat_spline_t *sp, quat_t *qo, float t);
+
+/* evaluate spline at n times t[i] into qo[i], several times per vector
+ * with sines from quat_vmath_tmpl.h; within 1e-6 rad of quat_spline_eval
+ * (quat_accuracy)
+ */
+QUAT_API void quat_spline_eval_n(quat_spline_t *sp, quat_t *qo, const float *t, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_spline.c"
+#endif
+
+
+#endif /* __QUAT_SPLINE_H__ */
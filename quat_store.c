@@ -0,0 +1,183 @@
+/*
+   quaternion library - entity orientation store implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * With half angles a, b, c of yaw, pitch and roll:
+ *
+ *    Ry(yaw) Rz(pitch) = (ca cb, sa sb, sa cb, ca sb) = P
+ *    P Rx(roll)        = (Pw cc - Px sc, Px cc + Pw sc, Py cc + Pz sc, Pz cc - Py sc)
+ *
+ * and for the yaw/pitch version T = Ry(yaw) q, then T Rz(pitch):
+ *
+ *    T = (ca qw - sa qy, ca qx + sa qz, ca qy + sa qw, ca qz - sa qx)
+ *    T Rz(pitch) = (cb Tw - sb Tz, cb Tx + sb Ty, cb Ty - sb Tx, cb Tz + sb Tw)
+ */
+
+
+#include <string.h>
+
+#include "quat_store.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+#if defined(__AVX__)
+#define STORE_LANES 8
+#define STORE_V vfloat8_t
+#define STORE_SINCOS vfloat8_sincos
+#define STORE_QP_T quat8_t
+#define STORE_QP(op) quat8_##op
+#else
+#define STORE_LANES 4
+#define STORE_V vfloat4_t
+#define STORE_SINCOS vfloat4_sincos
+#define STORE_QP_T quat4_t
+#define STORE_QP(op) quat4_##op
+#endif
+
+
+QUAT_API void quat_store_init(quat_store_t *s, float *storage, size_t n, const quat_t *q)
+{
+   static const quat_t identity = { { 1.0f, 0.0f, 0.0f, 0.0f } };
+   s->n = n;
+   s->w = storage;
+   s->x = storage + n;
+   s->y = storage + 2 * n;
+   s->z = storage + 3 * n;
+   for (size_t i = 0; i < n; i++)
+      quat_store_set(s, i, q ? &q[i] : &identity);
+}
+
+
+QUAT_API void quat_store_get(const quat_store_t *s, size_t i, quat_t *q)
+{
+   q->w = s->w[i];
+   q->x = s->x[i];
+   q->y = s->y[i];
+   q->z = s->z[i];
+}
+
+
+QUAT_API void quat_store_set(quat_store_t *s, size_t i, const quat_t *q)
+{
+   s->w[i] = q->w;
+   s->x[i] = q->x;
+   s->y[i] = q->y;
+   s->z[i] = q->z;
+}
+
+
+/* entities i .. i + STORE_LANES - 1 from arrays w, x, y, z and angles;
+   roll is NULL for the yaw/pitch version */
+static inline void store_lanes(float *w, float *x, float *y, float *z, const float *yaw,
+                               const float *pitch, const float *roll)
+{
+   STORE_QP_T q, r;
+   STORE_V a, b, sa, ca, sb, cb;
+   memcpy(&q.w, w, sizeof(STORE_V));
+   memcpy(&q.x, x, sizeof(STORE_V));
+   memcpy(&q.y, y, sizeof(STORE_V));
+   memcpy(&q.z, z, sizeof(STORE_V));
+   memcpy(&a, yaw, sizeof(STORE_V));
+   memcpy(&b, pitch, sizeof(STORE_V));
+   STORE_SINCOS(&sa, &ca, a * 0.5f);
+   STORE_SINCOS(&sb, &cb, b * 0.5f);
+   if (roll) {
+      STORE_QP_T p;
+      STORE_V c, sc, cc;
+      memcpy(&c, roll, sizeof(STORE_V));
+      STORE_SINCOS(&sc, &cc, c * 0.5f);
+      STORE_V pw = ca * cb, px = sa * sb, py = sa * cb, pz = ca * sb;
+      p.w = pw * cc - px * sc;
+      p.x = px * cc + pw * sc;
+      p.y = py * cc + pz * sc;
+      p.z = pz * cc - py * sc;
+      STORE_QP(mul)(&r, &q, &p);
+      STORE_QP(normalize)(&r, &r);
+   } else {
+      STORE_V tw = ca * q.w - sa * q.y, tx = ca * q.x + sa * q.z;
+      STORE_V ty = ca * q.y + sa * q.w, tz = ca * q.z - sa * q.x;
+      r.w = cb * tw - sb * tz;
+      r.x = cb * tx + sb * ty;
+      r.y = cb * ty - sb * tx;
+      r.z = cb * tz + sb * tw;
+   }
+   memcpy(w, &r.w, sizeof(STORE_V));
+   memcpy(x, &r.x, sizeof(STORE_V));
+   memcpy(y, &r.y, sizeof(STORE_V));
+   memcpy(z, &r.z, sizeof(STORE_V));
+}
+
+
+typedef struct
+{
+   quat_store_t *s;
+   const float *yaw, *pitch, *roll;
+}
+store_job_t;
+
+
+/* entities [first, last) of a chunk */
+static void store_chunk(void *ctx, size_t first, size_t last)
+{
+   store_job_t *job = ctx;
+   quat_store_t *s = job->s;
+   const float *roll = job->roll;
+   size_t i = first;
+   for (; i + STORE_LANES <= last; i += STORE_LANES)
+      store_lanes(&s->w[i], &s->x[i], &s->y[i], &s->z[i], &job->yaw[i], &job->pitch[i],
+                  roll ? &roll[i] : NULL);
+   if (i < last) {
+      /* the last entities go through the same code, padded with zeros */
+      float t[7][STORE_LANES] = { { 0.0f } };
+      size_t m = last - i;
+      memcpy(t[0], &s->w[i], m * sizeof(float));
+      memcpy(t[1], &s->x[i], m * sizeof(float));
+      memcpy(t[2], &s->y[i], m * sizeof(float));
+      memcpy(t[3], &s->z[i], m * sizeof(float));
+      memcpy(t[4], &job->yaw[i], m * sizeof(float));
+      memcpy(t[5], &job->pitch[i], m * sizeof(float));
+      if (roll)
+         memcpy(t[6], &roll[i], m * sizeof(float));
+      FOR_N(l, STORE_LANES)
+         t[0][l] += (size_t)l < m ? 0.0f : 1.0f;
+      store_lanes(t[0], t[1], t[2], t[3], t[4], t[5], roll ? t[6] : NULL);
+      memcpy(&s->w[i], t[0], m * sizeof(float));
+      memcpy(&s->x[i], t[1], m * sizeof(float));
+      memcpy(&s->y[i], t[2], m * sizeof(float));
+      memcpy(&s->z[i], t[3], m * sizeof(float));
+   }
+}
+
+
+QUAT_API void quat_store_apply_relative_yaw_pitch_roll(quat_pool_t *p, quat_store_t *s, const float *yaw,
+                                                       const float *pitch, const float *roll)
+{
+   store_job_t job = { s, yaw, pitch, roll };
+   quat_pool_for(p, s->n, QUAT_STORE_CHUNK, 2 * QUAT_STORE_CHUNK, store_chunk, &job);
+}
+
+
+QUAT_API void quat_store_apply_relative_yaw_pitch(quat_pool_t *p, quat_store_t *s, const float *yaw,
+                                                  const float *pitch)
+{
+   store_job_t job = { s, yaw, pitch, NULL };
+   quat_pool_for(p, s->n, QUAT_STORE_CHUNK, 2 * QUAT_STORE_CHUNK, store_chunk, &job);
+}
@@ -0,0 +1,77 @@
+/*
+   quaternion library - entity orientation store interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_STORE_H__
+#define __QUAT_STORE_H__
+
+
+#include "quat.h"
+#include "quat_pool.h"
+
+
+/* orientations of n entities, stored as structure of arrays in caller
+ * provided storage of QUAT_STORE_FLOATS(n) floats
+ */
+typedef struct
+{
+   size_t n;
+   float *w, *x, *y, *z; /* orientation of entity i is (w[i], x[i], y[i], z[i]) */
+}
+quat_store_t;
+
+#define QUAT_STORE_FLOATS(n) (4 * (n))
+
+/* entities per chunk of the steering functions on a pool; fewer than
+ * two chunks are updated on the calling thread, waking the pool costs
+ * more than updating them
+ */
+#define QUAT_STORE_CHUNK 4096
+
+
+/* initialize store s of n entities from q[0 .. n - 1], or to the
+ * identity if q is NULL
+ */
+QUAT_API void quat_store_init(quat_store_t *s, float *storage, size_t n, const quat_t *q);
+
+/* orientation of entity i */
+QUAT_API void quat_store_get(const quat_store_t *s, size_t i, quat_t *q);
+QUAT_API void quat_store_set(quat_store_t *s, size_t i, const quat_t *q);
+
+/* per entity versions of quat_apply_relative_yaw_pitch_roll and
+ * quat_apply_relative_yaw_pitch with angles yaw[i], pitch[i] and roll[i]
+ * in rad, run on pool p (may be NULL).
+ *
+ * The rotation q Ry(yaw) Rz(pitch) Rx(roll) q* applied to q is the same
+ * as q Ry(yaw) Rz(pitch) Rx(roll), so the roll version costs one fused
+ * axis product, one quat_mul and a normalization per entity. Sines and
+ * cosines are vector approximations (quat_vmath_tmpl.h); for unit
+ * orientations and angles up to pi each call is within 1e-6 rad of the
+ * scalar function (quat_accuracy checks this), and the result does not
+ * depend on the pool.
+ */
+QUAT_API void quat_store_apply_relative_yaw_pitch_roll(quat_pool_t *p, quat_store_t *s, const float *yaw,
+                                                       const float *pitch, const float *roll);
+QUAT_API void quat_store_apply_relative_yaw_pitch(quat_pool_t *p, quat_store_t *s, const float *yaw,
+                                                  const float *pitch);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_store.c"
+#endif
+
+
+#endif /* __QUAT_STORE_H__ */
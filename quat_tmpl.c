@@ -0,0 +1,970 @@
+/*
+   quaternion library - generic scalar implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+   most of the code was stolen from the Internet
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * Included by quat.c once per scalar type, see quat_tmpl.h for the
+ * type and name macros. In addition the includer defines:
+ *
+ *    MATH(fn)        libm function of matching precision, e.g. fn##f
+ *    LIT(x)          floating point literal of type REAL, e.g. x##f
+ *    SLERP_FAST      optional replacement for the slerp implementation
+ */
+
+
+#define ZERO_TOLERANCE LIT(0.000001)
+
+
+QUAT_API void VFN(copy)(VEC3_T *vo, VEC3_T *vi)
+{
+   memcpy(vo, vi, sizeof(VEC3_T));   
+}
+
+
+QUAT_API void QUAT_INIT(QUAT_T *q, const VEC3_T *acc, const VEC3_T *mag)
+{
+   REAL ax = acc->x;
+   REAL ay = acc->y;
+   REAL az = acc->z;
+   REAL mx = mag->x;
+   REAL my = mag->y;
+   REAL mz = mag->z;
+
+
+   REAL init_roll = MATH(atan2)(-ay, -az);
+   REAL init_pitch = MATH(atan2)(ax, -az);
+
+   REAL cos_roll = MATH(cos)(init_roll);
+   REAL sin_roll = MATH(sin)(init_roll);
+   REAL cos_pitch = MATH(cos)(init_pitch);
+   REAL sin_pitch = MATH(sin)(init_pitch);
+
+   REAL mag_x = mx * cos_pitch + my * sin_roll * sin_pitch + mz * cos_roll * sin_pitch;
+   REAL mag_y = my * cos_roll - mz * sin_roll;
+
+   REAL init_yaw = MATH(atan2)(-mag_y, mag_x);
+
+   cos_roll =  MATH(cos)(init_roll * LIT(0.5));
+   sin_roll =  MATH(sin)(init_roll * LIT(0.5));
+
+   cos_pitch = MATH(cos)(init_pitch * LIT(0.5) );
+   sin_pitch = MATH(sin)(init_pitch * LIT(0.5) );
+
+   REAL cosHeading = MATH(cos)(init_yaw * LIT(0.5));
+   REAL sinHeading = MATH(sin)(init_yaw * LIT(0.5));
+
+   q->q0 = cos_roll * cos_pitch * cosHeading + sin_roll * sin_pitch * sinHeading;
+   q->q1 = sin_roll * cos_pitch * cosHeading - cos_roll * sin_pitch * sinHeading;
+   q->q2 = cos_roll * sin_pitch * cosHeading + sin_roll * cos_pitch * sinHeading;
+   q->q3 = cos_roll * cos_pitch * sinHeading - sin_roll * sin_pitch * cosHeading;
+}
+
+
+QUAT_API void QFN(init_axis)(QUAT_T *q, REAL x, REAL y, REAL z, REAL a)
+{
+   /* see: http://www.euclideanspace.com/maths/geometry/rotations
+           /conversions/angleToQuaternion/index.htm */
+   REAL a2 = a * LIT(0.5);
+   REAL s = MATH(sin)(a2);
+   q->x = x * s;   
+   q->y = y * s;   
+   q->z = z * s;   
+   q->w = MATH(cos)(a2);   
+}
+
+
+QUAT_API void QFN(init_axis_v)(QUAT_T *q, const VEC3_T *v, REAL a)
+{
+   QFN(init_axis)(q, v->x, v->y, v->z, a);
+}
+
+
+QUAT_API void QFN(to_axis)(const QUAT_T *q, REAL *x, REAL *y, REAL *z, REAL *a)
+{
+   /* see: http://www.euclideanspace.com/maths/geometry/rotations
+           /conversions/quaternionToAngle/index.htm */
+   REAL angle = 2 * MATH(acos)(q->w);
+   REAL s = MATH(sqrt)(LIT(1.0) - q->w * q->w);
+   if (s < ZERO_TOLERANCE) {
+      /* if s close to zero then direction of axis not important */
+      *a = 0;
+      *x = 1;
+      *y = 0;
+      *z = 0;
+   } else {
+      *a = angle;
+      *x = q->x / s; /* normalise axis */
+      *y = q->y / s;
+      *z = q->z / s;
+   }
+}
+
+
+QUAT_API void QFN(to_axis_v)(const QUAT_T *q, VEC3_T *v, REAL *a)
+{
+   QFN(to_axis)(q, &v->x, &v->y, &v->z, a);
+}
+
+
+QUAT_API void QFN(rot_vec_self)(VEC3_T *v, const QUAT_T *q)
+{
+   VEC3_T vo;
+   QFN(rot_vec)(&vo, v, q);
+   VFN(copy)(v, &vo);
+}
+
+
+QUAT_API void QFN(rot_vec)(VEC3_T *vo, const VEC3_T *vi, const QUAT_T *q)
+{
+   /* see: https://github.com/qsnake/ase/blob/master/ase/quaternions.py */
+   const REAL vx = vi->x, vy = vi->y, vz = vi->z;
+   const REAL qw = q->w, qx = q->x, qy = q->y, qz = q->z;
+   const REAL qww = qw * qw, qxx = qx * qx, qyy = qy * qy, qzz = qz * qz;
+   const REAL qwx = qw * qx, qwy = qw * qy, qwz = qw * qz, qxy = qx * qy;
+   const REAL qxz = qx * qz, qyz = qy * qz;
+   vo->x = (qww + qxx - qyy - qzz) * vx + 2 * ((qxy - qwz) * vy + (qxz + qwy) * vz);
+   vo->y = (qww - qxx + qyy - qzz) * vy + 2 * ((qxy + qwz) * vx + (qyz - qwx) * vz);
+   vo->z = (qww - qxx - qyy + qzz) * vz + 2 * ((qxz - qwy) * vx + (qyz + qwx) * vy);
+}
+
+
+QUAT_API void QFN(copy)(QUAT_T *qo, const QUAT_T *qi)
+{
+   memcpy(qo, qi, sizeof(QUAT_T));   
+}
+
+
+QUAT_API REAL QFN(len)(const QUAT_T *q)
+{
+   REAL s = LIT(0.0);
+   FOR_N(i, 4)
+      s += q->vec[i] * q->vec[i];
+   return MATH(sqrt)(s);
+}
+
+
+QUAT_API void QFN(conj)(QUAT_T *q_out, const QUAT_T *q_in)
+{
+   q_out->x = -q_in->x;
+   q_out->y = -q_in->y;
+   q_out->z = -q_in->z;
+   q_out->w = q_in->w;
+}
+
+
+QUAT_API void QFN(to_euler)(EULER_T *euler, const QUAT_T *quat)
+{
+   const REAL x = quat->x, y = quat->y, z = quat->z, w = quat->w;
+   const REAL ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+   euler->yaw = NORMALIZE_EULER(MATH(atan2)(LIT(2.0) * (x * y + z * w), xx - yy - zz + ww));
+   euler->pitch = MATH(asin)(-LIT(2.0) * (x * z - y * w));
+   euler->roll = MATH(atan2)(LIT(2.0) * (y * z + x * w), -xx - yy + zz + ww);
+}
+
+
+QUAT_API void QFN(from_euler)(QUAT_T *q, const EULER_T *e)
+{
+   const REAL cy = MATH(cos)(e->yaw * LIT(0.5)), sy = MATH(sin)(e->yaw * LIT(0.5));
+   const REAL cp = MATH(cos)(e->pitch * LIT(0.5)), sp = MATH(sin)(e->pitch * LIT(0.5));
+   const REAL cr = MATH(cos)(e->roll * LIT(0.5)), sr = MATH(sin)(e->roll * LIT(0.5));
+   q->w = cy * cp * cr + sy * sp * sr;
+   q->x = cy * cp * sr - sy * sp * cr;
+   q->y = cy * sp * cr + sy * cp * sr;
+   q->z = sy * cp * cr - cy * sp * sr;
+}
+
+
+QUAT_API void QFN(mul)(QUAT_T *o, const QUAT_T *q1, const QUAT_T *q2)
+{
+   /* see: http://www.euclideanspace.com/maths/algebra/
+           realNormedAlgebra/quaternions/code/index.htm#mul */
+   o->x =  q1->x * q2->w + q1->y * q2->z - q1->z * q2->y + q1->w * q2->x;
+   o->y = -q1->x * q2->z + q1->y * q2->w + q1->z * q2->x + q1->w * q2->y;
+   o->z =  q1->x * q2->y - q1->y * q2->x + q1->z * q2->w + q1->w * q2->z;
+   o->w = -q1->x * q2->x - q1->y * q2->y - q1->z * q2->z + q1->w * q2->w;
+}
+
+
+QUAT_API void QFN(add)(QUAT_T *o, const QUAT_T *q1, const QUAT_T *q2)
+{
+   /* see: http://www.euclideanspace.com/maths/algebra/
+           realNormedAlgebra/quaternions/code/index.htm#add */
+   o->x = q1->x + q2->x;
+   o->y = q1->y + q2->y;
+   o->z = q1->z + q2->z;
+   o->w = q1->w + q2->w;
+}
+
+
+QUAT_API void QFN(add_self)(QUAT_T *o, const QUAT_T *q)
+{
+   QUAT_T tmp;
+   QFN(add)(&tmp, o, q);
+   QFN(copy)(o, &tmp);
+}
+
+
+QUAT_API void QFN(scale)(QUAT_T *o, const QUAT_T *q, REAL f)
+{
+   /* see: http://www.euclideanspace.com/maths/algebra/
+           realNormedAlgebra/quaternions/code/index.htm#scale*/
+   FOR_N(i, 4)
+      o->vec[i] = q->vec[i] * f;
+}
+
+
+QUAT_API void QFN(scale_self)(QUAT_T *q, REAL f)
+{
+   QFN(scale)(q, q, f);
+}
+
+
+QUAT_API void QFN(normalize)(QUAT_T *o, const QUAT_T *q)
+{
+   /* see: http://www.euclideanspace.com/maths/algebra/
+           realNormedAlgebra/quaternions/code/index.htm#normalise */
+   QFN(scale)(o, q, LIT(1.0) / QFN(len)(q));
+}
+
+
+QUAT_API void QFN(normalize_self)(QUAT_T *q)
+{
+   QFN(normalize)(q, q);
+}
+
+
+QUAT_API REAL NORMALIZE_EULER(REAL a)
+{
+   while (a < 0)
+      a += (REAL)(2 * M_PI);
+   return a;
+}
+
+
+/* m is pointer to array of 16 scalars in column major order */
+QUAT_API void QFN(to_rh_rot_matrix)(const QUAT_T *q, REAL *m)
+{
+   QUAT_T qn;
+   REAL qw, qx, qy, qz;
+
+   QFN(normalize)(&qn, q);
+
+   qw = qn.w;
+   qx = qn.x;
+   qy = qn.y;
+   qz = qn.z;
+
+   m[0] = LIT(1.0) - LIT(2.0) * qy * qy - LIT(2.0) * qz * qz;
+   m[1] = LIT(2.0) * qx * qy + LIT(2.0) * qz * qw;
+   m[2] = LIT(2.0) * qx * qz - LIT(2.0) * qy * qw;
+   m[3] = LIT(0.0);
+
+   m[4] = LIT(2.0) * qx * qy - LIT(2.0) * qz * qw;
+   m[5] = LIT(1.0) - LIT(2.0) * qx * qx - LIT(2.0) * qz * qz;
+   m[6] = LIT(2.0) * qy * qz + LIT(2.0) * qx * qw;
+   m[7] = LIT(0.0);
+
+   m[8] = LIT(2.0) * qx * qz + LIT(2.0) * qy * qw;
+   m[9] = LIT(2.0) * qy * qz - LIT(2.0) * qx * qw;
+   m[10] = LIT(1.0) - LIT(2.0) * qx * qx - LIT(2.0) * qy * qy;
+   m[11] = LIT(0.0);
+
+   m[12] = LIT(0.0);
+   m[13] = LIT(0.0);
+   m[14] = LIT(0.0);
+   m[15] = LIT(1.0);
+}
+
+
+/* m is pointer to array of 16 scalars in column major order */
+QUAT_API void QFN(to_lh_rot_matrix)(const QUAT_T *q, REAL *m)
+{
+   QUAT_T qn;
+   REAL qw, qx, qy, qz;
+
+   QFN(normalize)(&qn, q);
+
+   qw = qn.w;
+   qx = qn.x;
+   qy = qn.y;
+   qz = qn.z;
+
+   m[0] = LIT(1.0) - LIT(2.0) * qy * qy - LIT(2.0) * qz * qz;
+   m[1] = LIT(2.0) * qx * qy - LIT(2.0) * qz * qw;
+   m[2] = LIT(2.0) * qx * qz + LIT(2.0) * qy * qw;
+   m[3] = LIT(0.0);
+
+   m[4] = LIT(2.0) * qx * qy + LIT(2.0) * qz * qw;
+   m[5] = LIT(1.0) - LIT(2.0) * qx * qx - LIT(2.0) * qz * qz;
+   m[6] = LIT(2.0) * qy * qz - LIT(2.0) * qx * qw;
+   m[7] = LIT(0.0);
+
+   m[8] = LIT(2.0) * qx * qz - LIT(2.0) * qy * qw;
+   m[9] = LIT(2.0) * qy * qz + LIT(2.0) * qx * qw;
+   m[10] = LIT(1.0) - LIT(2.0) * qx * qx - LIT(2.0) * qy * qy;
+   m[11] = LIT(0.0);
+
+   m[12] = LIT(0.0);
+   m[13] = LIT(0.0);
+   m[14] = LIT(0.0);
+   m[15] = LIT(1.0);
+}
+
+
+/* Shepperd's method for the row major 3x3 rotation r: the largest of
+   |w|, |x|, |y| and |z| comes from the diagonal, the others from off
+   diagonal sums and differences divided by it, so nothing cancels */
+static void QFN(from_rot_rows)(QUAT_T *o, const REAL *r)
+{
+   REAL big = r[0] + r[4] + r[8], s, h, f;
+   int k = 0;
+
+   if (r[0] > big) {
+      k = 1;
+      big = r[0];
+   }
+   if (r[4] > big) {
+      k = 2;
+      big = r[4];
+   }
+   if (r[8] > big)
+      k = 3;
+
+   switch (k) {
+      case 0: s = LIT(1.0) + r[0] + r[4] + r[8]; break;
+      case 1: s = LIT(1.0) + r[0] - r[4] - r[8]; break;
+      case 2: s = LIT(1.0) - r[0] + r[4] - r[8]; break;
+      default: s = LIT(1.0) - r[0] - r[4] + r[8]; break;
+   }
+   h = LIT(0.5) * MATH(sqrt)(s);
+   f = LIT(0.25) / h;
+
+   switch (k) {
+      case 0:
+         o->w = h;
+         o->x = (r[7] - r[5]) * f;
+         o->y = (r[2] - r[6]) * f;
+         o->z = (r[3] - r[1]) * f;
+         break;
+      case 1:
+         o->w = (r[7] - r[5]) * f;
+         o->x = h;
+         o->y = (r[1] + r[3]) * f;
+         o->z = (r[2] + r[6]) * f;
+         break;
+      case 2:
+         o->w = (r[2] - r[6]) * f;
+         o->x = (r[1] + r[3]) * f;
+         o->y = h;
+         o->z = (r[5] + r[7]) * f;
+         break;
+      default:
+         o->w = (r[3] - r[1]) * f;
+         o->x = (r[2] + r[6]) * f;
+         o->y = (r[5] + r[7]) * f;
+         o->z = h;
+         break;
+   }
+
+   /* q and -q are the same rotation, return the one with w >= 0 */
+   if (o->w < LIT(0.0))
+      FOR_N(i, 4)
+         o->vec[i] = -o->vec[i];
+}
+
+
+/* m is pointer to array of 16 scalars in column major order */
+QUAT_API void QFN(from_rh_rot_matrix)(QUAT_T *o, const REAL *m)
+{
+   const REAL r[9] = { m[0], m[4], m[8], m[1], m[5], m[9], m[2], m[6], m[10] };
+   QFN(from_rot_rows)(o, r);
+}
+
+
+/* m is pointer to array of 16 scalars in column major order */
+QUAT_API void QFN(from_lh_rot_matrix)(QUAT_T *o, const REAL *m)
+{
+   const REAL r[9] = { m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10] };
+   QFN(from_rot_rows)(o, r);
+}
+
+
+QUAT_API void VFN(init)(VEC3_T *vo, REAL x, REAL y, REAL z)
+{
+   vo->x = x;
+   vo->y = y;
+   vo->z = z;
+}
+
+
+QUAT_API VEC3_T *VFN(add)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2)
+{
+   vo->x = v1->x + v2->x;
+   vo->y = v1->y + v2->y;
+   vo->z = v1->z + v2->z;
+   return vo;
+}
+
+
+QUAT_API VEC3_T *VFN(add_self)(VEC3_T *v1, const VEC3_T *v2)
+{
+   return VFN(add)(v1, v1, v2);
+}
+
+
+QUAT_API VEC3_T *VFN(add_c_self)(VEC3_T *v1, REAL x, REAL y, REAL z)
+{
+        v1->x += x;
+        v1->y += y;
+        v1->z += z;
+        return v1;
+}
+
+
+QUAT_API VEC3_T *VFN(sub)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2)
+{
+   vo->vec[0] = v1->vec[0] - v2->vec[0];
+   vo->vec[1] = v1->vec[1] - v2->vec[1];
+   vo->vec[2] = v1->vec[2] - v2->vec[2];
+   return vo;
+}
+
+
+QUAT_API VEC3_T *VFN(sub_self)(VEC3_T *v1, const VEC3_T *v2)
+{
+   return VFN(sub)(v1, v1, v2);
+}
+
+
+QUAT_API VEC3_T *VFN(sub_c_self)(VEC3_T *v1, REAL x, REAL y, REAL z)
+{
+   v1->x -= x;
+   v1->y -= y;
+   v1->z -= z;
+   return v1;
+}
+
+
+QUAT_API VEC3_T *VFN(mul)(VEC3_T *vo, const VEC3_T *vi, REAL scalar)
+{
+   vo->vec[0] = vi->vec[0] * scalar;
+   vo->vec[1] = vi->vec[1] * scalar;
+   vo->vec[2] = vi->vec[2] * scalar;
+   return vo;
+}
+
+
+QUAT_API VEC3_T *VFN(mul_self)(VEC3_T *vi, REAL scalar)
+{
+   return VFN(mul)(vi, vi, scalar);
+}
+
+
+QUAT_API REAL VFN(dot)(const VEC3_T *v1, const VEC3_T *v2)
+{
+   return v1->vec[0] * v2->vec[0] + v1->vec[1] * v2->vec[1] + v1->vec[2] * v2->vec[2];
+}
+
+
+QUAT_API VEC3_T *VFN(cross)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2)
+{
+   vo->vec[0] = v1->vec[1]*v2->vec[2] - v1->vec[2]*v2->vec[1];
+   vo->vec[1] = v1->vec[2]*v2->vec[0] - v1->vec[0]*v2->vec[2];
+   vo->vec[2] = v1->vec[0]*v2->vec[1] - v1->vec[1]*v2->vec[0];
+   return vo;
+}
+
+
+QUAT_API REAL VFN(len2)(const VEC3_T *v)
+{
+   return v->x * v->x + v->y * v->y + v->z * v->z;
+}
+
+
+QUAT_API VEC3_T *VFN(normalize)(VEC3_T *vo, const VEC3_T *vi)
+{
+   REAL len = MATH(sqrt)(VFN(len2)(vi));
+   vo->x = vi->x / len;
+   vo->y = vi->y / len;
+   vo->z = vi->z / len;
+   return vo;
+}
+
+
+QUAT_API VEC3_T *VFN(rot_axis)(VEC3_T *vo, VEC3_T *vi, REAL x, REAL y, REAL z, REAL angle)
+{
+   VFN(copy)(vo, vi);
+   return VFN(rot_axis_self)(vo, x, y, z, angle);
+}
+
+
+QUAT_API VEC3_T *VFN(rot_axis_self)(VEC3_T *vo, REAL x, REAL y, REAL z, REAL angle)
+{
+   QUAT_T rotate;
+   QFN(init_axis)(&rotate, x, y, z, angle);
+   QFN(rot_vec_self)(vo, &rotate);
+   return vo;
+}
+
+
+QUAT_API double VFN(dist)(const VEC3_T *v1, const VEC3_T *v2)
+{
+   return (double)MATH(sqrt)((v1->x - v2->x) * (v1->x - v2->x) +
+                             (v1->y - v2->y) * (v1->y - v2->y) +
+                             (v1->z - v2->z) * (v1->z - v2->z));
+}
+
+
+QUAT_API double VFN(dist_c)(const VEC3_T *v1, REAL x, REAL y, REAL z)
+{
+   return (double)MATH(sqrt)((v1->x - x) * (v1->x - x) +
+                             (v1->y - y) * (v1->y - y) +
+                             (v1->z - z) * (v1->z - z));
+}
+
+
+QUAT_API_DATA const QUAT_T IDENTITY_QUAT = { { LIT(1.0), LIT(0.0), LIT(0.0), LIT(0.0) } };
+
+
+/* a b = p + *e exactly, with Veltkamp's split into halves whose products
+   are exact (Dekker); each operation has to be rounded on its own, as
+   with -ffp-contract=off */
+#define SPLIT (sizeof(REAL) == sizeof(float) ? LIT(4097.0) : LIT(134217729.0))
+
+static inline REAL QFN(two_prod)(REAL a, REAL b, REAL *e)
+{
+   REAL p = a * b;
+   REAL as = SPLIT * a, bs = SPLIT * b;
+   REAL ah = as - (as - a), bh = bs - (bs - b);
+   REAL al = a - ah, bl = b - bh;
+   *e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+   return p;
+}
+
+
+/* a + b = s + *e exactly (Knuth) */
+static inline REAL QFN(two_sum)(REAL a, REAL b, REAL *e)
+{
+   REAL s = a + b;
+   REAL bv = s - a;
+   *e = (a - (s - bv)) + (b - bv);
+   return s;
+}
+
+
+/* a b - c d from the exact products, so it does not cancel */
+static inline REAL QFN(diff_prod)(REAL a, REAL b, REAL c, REAL d)
+{
+   REAL e, f;
+   REAL p = QFN(two_prod)(a, b, &e);
+   REAL q = QFN(two_prod)(c, d, &f);
+   return (p - q) + (e - f);
+}
+
+
+/* a.b of two 3-vectors as if formed in twice the precision and then
+   rounded (Dot2 of Ogita, Rump and Oishi) */
+static inline REAL QFN(dot_acc)(const REAL *a, const REAL *b)
+{
+   REAL e, r, t;
+   REAL p = QFN(two_prod)(a[0], b[0], &e);
+   for (int i = 1; i < 3; i++) {
+      REAL h = QFN(two_prod)(a[i], b[i], &r);
+      p = QFN(two_sum)(p, h, &t);
+      e += t + r;
+   }
+   return p + e;
+}
+
+
+/* see http://gamedev.stackexchange.com/questions/15070/orienting-a-model-to-face-a-target */
+/* The rotation from u to v is the normalized (|u||v| + u.v, u x v), the
+   half turn between u and the half vector u / |u| + v / |v|, so no angle
+   is computed; both parts are scaled by 1 / |u||v|. Near antiparallel u
+   and v the first part is formed as |u x v|^2 / (|u||v| - u.v), which
+   does not cancel, and u x v is cleared of its rounding error along u,
+   which would tilt the axis. Within ZERO_TOLERANCE rad of antiparallel
+   it is the half turn h around the part of up perpendicular to u (any
+   perpendicular axis if up is parallel to u), followed by the small
+   rotation (|u||v| - u.v, -u x v) from -u to v. */
+QUAT_API void QFN(from_u2v)(QUAT_T *q, const VEC3_T *u, const VEC3_T *v, const VEC3_T *up)
+{
+   const REAL *a = u->vec, *b = v->vec;
+   REAL aa = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+   REAL l = MATH(sqrt)(aa * (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]));
+   if (!(l > LIT(0.0))) {
+      *q = IDENTITY_QUAT;
+      return;
+   }
+   REAL il = LIT(1.0) / l;
+   REAL d = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) * il;
+   REAL c[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+   REAL g = (c[0] * a[0] + c[1] * a[1] + c[2] * a[2]) / aa;
+   FOR_N(i, 3)
+      c[i] = (c[i] - g * a[i]) * il;
+   REAL cc = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+   REAL r[4] = { d < LIT(0.0) ? cc / (LIT(1.0) - d) : LIT(1.0) + d, c[0], c[1], c[2] };
+   if (d < LIT(0.0) && cc <= ZERO_TOLERANCE * ZERO_TOLERANCE) {
+      /* vector a and b point in the opposite direction
+       * so it is a 180 degrees turn around the up-axis
+       */
+      REAL h[3] = { LIT(0.0), LIT(1.0), LIT(0.0) };
+      if (up) {
+         h[0] = up->x;
+         h[1] = up->y;
+         h[2] = up->z;
+      }
+      REAL ee = h[0] * h[0] + h[1] * h[1] + h[2] * h[2];
+      /* twice, the second time for the rounding error of up near u */
+      FOR_N(k, 2) {
+         REAL f = (h[0] * a[0] + h[1] * a[1] + h[2] * a[2]) / aa;
+         FOR_N(i, 3)
+            h[i] -= f * a[i];
+      }
+      if (h[0] * h[0] + h[1] * h[1] + h[2] * h[2] <= ZERO_TOLERANCE * ZERO_TOLERANCE * ee) {
+         /* up is parallel to u: u x x, or u x y if u is within 60 degrees of x */
+         if (a[0] * a[0] < LIT(0.25) * aa) {
+            h[0] = LIT(0.0);
+            h[1] = a[2];
+            h[2] = -a[1];
+         } else {
+            h[0] = -a[2];
+            h[1] = LIT(0.0);
+            h[2] = a[0];
+         }
+      }
+      /* r = (1 - d, -c) (0, h) */
+      r[0] = c[0] * h[0] + c[1] * h[1] + c[2] * h[2];
+      r[1] = (LIT(1.0) - d) * h[0] - (c[1] * h[2] - c[2] * h[1]);
+      r[2] = (LIT(1.0) - d) * h[1] - (c[2] * h[0] - c[0] * h[2]);
+      r[3] = (LIT(1.0) - d) * h[2] - (c[0] * h[1] - c[1] * h[0]);
+   }
+   REAL n = MATH(sqrt)(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+   FOR_N(i, 4)
+      q->vec[i] = r[i] / n;
+}
+
+
+/* aims forward (x) at d = target - pos with the rotation q1 from x to d,
+   then turns around d by the angle phi from the rotated y to the part p
+   of up perpendicular to d, both projected onto the plane normal to d.
+   p is d x (up x d) / |d|^2, with up x d from d and its rounding error
+   and from exact products, so it keeps its direction for up near d. With k cos(phi) = a.p and
+   k sin(phi) |d| = (a x p).d, k = |a||p|, the turn is
+   (k + a.p, sin(phi) k d / |d|) if cos(phi) >= 0, else the same half
+   angle as (sin(phi) k, (k - a.p) d / |d|), which does not cancel near a
+   half turn. */
+QUAT_API void QFN(look_at)(QUAT_T *q, const VEC3_T *pos, const VEC3_T *target, const VEC3_T *up)
+{
+   static const VEC3_T x = { { LIT(1.0), LIT(0.0), LIT(0.0) } }, y = { { LIT(0.0), LIT(1.0), LIT(0.0) } };
+   REAL dl[3], m[3], a[3], p[3], w, f;
+   VEC3_T dv, y1;
+   QUAT_T q1, q2;
+   if (!up)
+      up = &y;
+   const REAL *d = dv.vec, *e = up->vec;
+   FOR_N(i, 3)
+      dv.vec[i] = QFN(two_sum)(target->vec[i], -pos->vec[i], &dl[i]);
+   QFN(from_u2v)(&q1, &x, &dv, up);
+   QFN(rot_vec)(&y1, &y, &q1);
+   REAL dd = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+   REAL ee = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+   m[0] = QFN(diff_prod)(e[1], d[2], e[2], d[1]) + (e[1] * dl[2] - e[2] * dl[1]);
+   m[1] = QFN(diff_prod)(e[2], d[0], e[0], d[2]) + (e[2] * dl[0] - e[0] * dl[2]);
+   m[2] = QFN(diff_prod)(e[0], d[1], e[1], d[0]) + (e[0] * dl[1] - e[1] * dl[0]);
+   if (!(dd > LIT(0.0))
+       || m[0] * m[0] + m[1] * m[1] + m[2] * m[2] <= ZERO_TOLERANCE * ZERO_TOLERANCE * ee * dd) {
+      /* target at pos or along up, any roll fits */
+      *q = q1;
+      return;
+   }
+   REAL id = LIT(1.0) / dd;
+   REAL fa = (y1.x * d[0] + y1.y * d[1] + y1.z * d[2]) * id;
+   FOR_N(i, 3)
+      a[i] = y1.vec[i] - fa * d[i];
+   p[0] = (d[1] * m[2] - d[2] * m[1]) * id;
+   p[1] = (d[2] * m[0] - d[0] * m[2]) * id;
+   p[2] = (d[0] * m[1] - d[1] * m[0]) * id;
+   REAL k = MATH(sqrt)((a[0] * a[0] + a[1] * a[1] + a[2] * a[2]) * (p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+   REAL c = a[0] * p[0] + a[1] * p[1] + a[2] * p[2];
+   REAL s = (a[1] * p[2] - a[2] * p[1]) * d[0] + (a[2] * p[0] - a[0] * p[2]) * d[1]
+            + (a[0] * p[1] - a[1] * p[0]) * d[2];
+   /* q2 = (w, f d) */
+   if (c >= LIT(0.0)) {
+      w = k + c;
+      f = s * id;
+   } else {
+      w = s;
+      f = k - c;
+   }
+   REAL n = MATH(sqrt)(w * w + f * f * dd);
+   q2.w = w / n;
+   q2.x = f * d[0] / n;
+   q2.y = f * d[1] / n;
+   q2.z = f * d[2] / n;
+   QFN(mul)(q, &q2, &q1);
+}
+
+
+QUAT_API REAL QFN(dot)(const QUAT_T *q1, const QUAT_T *q2)
+{
+   return q1->vec[0] * q2->vec[0] + q1->vec[1] * q2->vec[1] +
+          q1->vec[2] * q2->vec[2] + q1->vec[3] * q2->vec[3];
+}
+
+
+static QUAT_T *QFN(lerp)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, REAL t)
+{
+   REAL cosom = QFN(dot)(qfrom, qto);
+
+   /* qto = qfrom or qto = -qfrom so no rotation to slerp */
+   if (cosom >= LIT(1.0)) {
+      QFN(copy)(qo, qfrom);
+      return qo;
+   }
+
+   /* adjust for shortest path */
+   QUAT_T to1;
+   if (cosom < LIT(0.0)) {
+      to1.x = -qto->x;
+      to1.y = -qto->y;
+      to1.z = -qto->z;
+      to1.w = -qto->w;
+   } else {
+      QFN(copy)(&to1, qto);
+   }
+
+   REAL scale0 = LIT(1.0) - t;
+   REAL scale1 = t;
+
+   /* calculate final values */
+   qo->x = scale0 * qfrom->x + scale1 * to1.x;
+   qo->y = scale0 * qfrom->y + scale1 * to1.y;
+   qo->z = scale0 * qfrom->z + scale1 * to1.z;
+   qo->w = scale0 * qfrom->w + scale1 * to1.w;
+   return qo;
+}
+
+
+QUAT_API QUAT_T *QFN(nlerp)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, REAL t)
+{
+   QFN(lerp)(qo, qfrom, qto, t); 
+   QFN(normalize_self)(qo);
+   return qo; 
+}
+
+
+QUAT_API QUAT_T *QFN(slerp)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, REAL t)
+{
+#if defined(SLERP_FAST)
+   return SLERP_FAST(qo, qfrom, qto, t);
+#endif
+   /* calc cosine */
+   REAL cosom = QFN(dot)(qfrom, qto);
+
+   /* qto = qfrom or qto = -qfrom so no rotation to slerp */
+   if (cosom >= LIT(1.0)) {
+      QFN(copy)(qo, qfrom);
+      return qo; 
+   }   
+
+   /* adjust for shortest path */
+   QUAT_T to1;
+   if (cosom < LIT(0.0)) {
+      cosom = -cosom;
+      to1.x = -qto->x;
+      to1.y = -qto->y;
+      to1.z = -qto->z;
+      to1.w = -qto->w;
+   } else {
+      QFN(copy)(&to1, qto);
+   }
+
+   /* calculate coefficients */
+   REAL scale0, scale1;
+   if (cosom < LIT(0.99995)) {
+      /* standard case (slerp) */
+      REAL omega = MATH(acos)(cosom);
+      REAL sinom = MATH(sin)(omega);
+      scale0 = MATH(sin)((LIT(1.0) - t) * omega) / sinom;
+      scale1 = MATH(sin)(t * omega) / sinom;
+   } else {
+      /* "from" and "to" quaternions are very close
+       *  ... so we can do a linear interpolation
+       */
+      scale0 = LIT(1.0) - t;
+      scale1 = t;
+   }
+
+   /* calculate final values */
+   qo->x = scale0 * qfrom->x + scale1 * to1.x;
+   qo->y = scale0 * qfrom->y + scale1 * to1.y;
+   qo->z = scale0 * qfrom->z + scale1 * to1.z;
+   qo->w = scale0 * qfrom->w + scale1 * to1.w;
+   return qo;
+}
+
+
+/* below this |v|, sin|v| / |v| and cos|v| are taken from their Taylor
+   series up to |v|^4, which are exact to rounding there */
+#define EXP_TAYLOR (sizeof(REAL) == sizeof(float) ? LIT(0.125) : LIT(0.004))
+
+
+/* s = sin|v| / |v|, c = cos|v| with t2 = |v|^2 */
+static inline void QFN(exp_sincos)(REAL *s, REAL *c, REAL t2)
+{
+   REAL t = MATH(sqrt)(t2);
+   if (t < EXP_TAYLOR) {
+      *s = LIT(1.0) - t2 * LIT(0.16666666666666667) * (LIT(1.0) - t2 * LIT(0.05));
+      *c = LIT(1.0) - t2 * LIT(0.5) * (LIT(1.0) - t2 * LIT(0.083333333333333333));
+   } else {
+      *s = MATH(sin)(t) / t;
+      *c = MATH(cos)(t);
+   }
+}
+
+
+QUAT_API void QFN(exp)(QUAT_T *qo, const QUAT_T *q)
+{
+   REAL s, c;
+   QFN(exp_sincos)(&s, &c, q->x * q->x + q->y * q->y + q->z * q->z);
+   REAL e = MATH(exp)(q->w);
+   s *= e;
+   qo->w = e * c;
+   qo->x = s * q->x;
+   qo->y = s * q->y;
+   qo->z = s * q->z;
+}
+
+
+QUAT_API void QFN(log)(QUAT_T *qo, const QUAT_T *q)
+{
+   REAL s2 = q->x * q->x + q->y * q->y + q->z * q->z;
+   REAL s = MATH(sqrt)(s2);
+   REAL f = s > LIT(0.0) ? MATH(atan2)(s, q->w) / s : LIT(0.0);
+   qo->x = f * q->x + (s > LIT(0.0) || q->w >= LIT(0.0) ? LIT(0.0) : (REAL)M_PI);
+   qo->y = f * q->y;
+   qo->z = f * q->z;
+   qo->w = LIT(0.5) * MATH(log)(q->w * q->w + s2);
+}
+
+
+QUAT_API void QFN(pow)(QUAT_T *qo, const QUAT_T *q, REAL t)
+{
+   QUAT_T l;
+   QFN(log)(&l, q);
+   QFN(scale_self)(&l, t);
+   QFN(exp)(qo, &l);
+}
+
+
+QUAT_API void QFN(integrate)(QUAT_T *qo, const QUAT_T *q, const VEC3_T *omega, REAL dt)
+{
+   REAL h = LIT(0.5) * dt, s, c;
+   REAL x = omega->x * h, y = omega->y * h, z = omega->z * h;
+   QFN(exp_sincos)(&s, &c, x * x + y * y + z * z);
+   QUAT_T e = { .w = c, .x = s * x, .y = s * y, .z = s * z }, r;
+   QFN(mul)(&r, q, &e);
+   *qo = r;
+}
+
+
+QUAT_API QUAT_T *QFN(apply_relative_yaw_pitch_roll)(QUAT_T *q,
+                                        double yaw, double pitch, double roll)
+{
+        QUAT_T qyaw, qpitch, qroll, qrot, q1, q2, q3, q4;
+
+        /* calculate amount of yaw to impart this iteration... */
+        QFN(init_axis)(&qyaw, LIT(0.0), LIT(1.0), LIT(0.0), (REAL)yaw);
+        /* Calculate amount of pitch to impart this iteration... */
+        QFN(init_axis)(&qpitch, LIT(0.0), LIT(0.0), LIT(1.0), (REAL)pitch);
+        /* Calculate amount of roll to impart this iteration... */
+        QFN(init_axis)(&qroll, LIT(1.0), LIT(0.0), LIT(0.0), (REAL)roll);
+        /* Combine pitch, roll and yaw */
+        QFN(mul)(&q1, &qyaw, &qpitch);
+        QFN(mul)(&qrot, &q1, &qroll);
+
+        /* Convert rotation to local coordinate system */
+        QFN(mul)(&q1, q, &qrot);
+        QFN(conj)(&q2, q);
+        QFN(mul)(&q3, &q1, &q2);
+        /* Apply to local orientation */
+        QFN(mul)(&q4, &q3, q);
+        QFN(normalize_self)(&q4);
+        *q = q4;
+        return q;
+}
+
+
+QUAT_API QUAT_T *QFN(apply_relative_yaw_pitch)(QUAT_T *q, double yaw, double pitch)
+{
+        QUAT_T qyaw, qpitch, q1;
+
+        /* calculate amount of yaw to impart this iteration... */
+        QFN(init_axis)(&qyaw, LIT(0.0), LIT(1.0), LIT(0.0), (REAL)yaw);
+        /* Calculate amount of pitch to impart this iteration... */
+        QFN(init_axis)(&qpitch, LIT(0.0), LIT(0.0), LIT(1.0), (REAL)pitch);
+
+        QFN(mul)(&q1, &qyaw, q);
+        QFN(mul)(q, &q1, &qpitch);
+        return q;
+}
+
+
+/* twist around v1 of q = swing twist: the projection (w, (q.v1) v1 / |v1|^2)
+   of q onto the rotations around v1, normalized; then swing = q twist*
+   has no component along v1 and w >= 0, the shortest rotation from v1
+   to q v1. Near a swing of pi the projection is short and q.v1 cancels,
+   so it is formed as if in twice the precision. The identity if the
+   swing is exactly pi, where any twist fits. */
+static void QFN(swing_twist_proj)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *swing, QUAT_T *twist)
+{
+   const REAL *v = v1->vec;
+   REAL l2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+   REAL f = l2 > LIT(0.0) ? QFN(dot_acc)(&q->vec[1], v) / l2 : LIT(0.0);
+   REAL t[4] = { q->w, f * v[0], f * v[1], f * v[2] };
+   REAL n = MATH(sqrt)(t[0] * t[0] + t[1] * t[1] + t[2] * t[2] + t[3] * t[3]);
+   QUAT_T tc;
+   if (n > LIT(0.0)) {
+      FOR_N(c, 4)
+         twist->vec[c] = t[c] / n;
+   } else {
+      *twist = IDENTITY_QUAT;
+   }
+   QFN(conj)(&tc, twist);
+   QFN(mul)(swing, q, &tc);
+}
+
+
+QUAT_API void QFN(decompose_twist_swing)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *twist, QUAT_T *swing)
+{
+   QUAT_T t, sc;
+   QFN(swing_twist_proj)(q, v1, swing, &t);
+   QFN(conj)(&sc, swing);
+   QFN(mul)(twist, q, &sc);
+}
+
+
+QUAT_API void QFN(decompose_swing_twist)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *swing, QUAT_T *twist)
+{
+   QFN(swing_twist_proj)(q, v1, swing, twist);
+}
+
+
+#undef ZERO_TOLERANCE
+#undef EXP_TAYLOR
+#undef SPLIT
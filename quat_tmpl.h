@@ -0,0 +1,242 @@
+/*
+   quaternion library - generic scalar interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * This file is included by quat.h once per scalar type, no include guard.
+ * The includer defines:
+ *
+ *    REAL            scalar type (float, double)
+ *    QUAT_T, VEC3_T, EULER_T
+ *                    quaternion, vector and euler angle types
+ *    QFN(name)       quaternion function name, e.g. quat_##name
+ *    VFN(name)       vector function name, e.g. vec3_##name
+ *    QUAT_INIT, NORMALIZE_EULER, IDENTITY_QUAT
+ *                    names that do not follow the prefix scheme
+ */
+
+
+/* copy vector vi to vo */
+QUAT_API void VFN(copy)(VEC3_T *vo, VEC3_T *vi);
+
+/* init orientation quaternion from measurements */
+QUAT_API void QUAT_INIT(QUAT_T *quat, const VEC3_T *acc, const VEC3_T *mag);
+
+/* initialize quaternion from axis angle using scalars */
+QUAT_API void QFN(init_axis)(QUAT_T *q, REAL x, REAL y, REAL z, REAL a);
+
+/* initialize quaternion from axis angle using a vector */
+QUAT_API void QFN(init_axis_v)(QUAT_T *q, const VEC3_T *v, REAL a);
+
+/* extract axis and angle from a quaternion */
+QUAT_API void QFN(to_axis)(const QUAT_T *q, REAL *x, REAL *y, REAL *z, REAL *a);
+
+/* extract axis in vector form and angle from a quaternion */
+QUAT_API void QFN(to_axis_v)(const QUAT_T *q, VEC3_T *v, REAL *a);
+
+/* rotate vector vi via unit quaternion q and put result into vector vo */
+QUAT_API void QFN(rot_vec)(VEC3_T *vo, const VEC3_T *vi, const QUAT_T *q);
+
+/* rotate vector v_in in-place via unit quaternion quat */
+QUAT_API void QFN(rot_vec_self)(VEC3_T *v, const QUAT_T *q);
+
+/* returns len of quaternion */
+QUAT_API REAL QFN(len)(const QUAT_T *q);
+
+/* copy quaternion qi to qo */
+QUAT_API void QFN(copy)(QUAT_T *qo, const QUAT_T *qi);
+
+/* qo = qi * f */
+QUAT_API void QFN(scale)(QUAT_T *qo, const QUAT_T *qi, REAL f);
+
+/* qo *= f */
+QUAT_API void QFN(scale_self)(QUAT_T *q, REAL f);
+
+/* conjugate quaternion */
+QUAT_API void QFN(conj)(QUAT_T *qo, const QUAT_T *qi);
+
+/* o = q1 + 12 */
+QUAT_API void QFN(add)(QUAT_T *qo, const QUAT_T *q1, const QUAT_T *q2);
+
+/* o += q */
+QUAT_API void QFN(add_self)(QUAT_T *o, const QUAT_T *q);
+
+/* o = q1 * q2 */
+QUAT_API void QFN(mul)(QUAT_T *o, const QUAT_T *q1, const QUAT_T *q2);
+
+/* normalizes quaternion q and puts result into o */
+QUAT_API void QFN(normalize)(QUAT_T *qo, const QUAT_T *qi);
+
+/* normalize q in-place */
+QUAT_API void QFN(normalize_self)(QUAT_T *q);
+
+/* convert quaternion to euler angles */
+QUAT_API void QFN(to_euler)(EULER_T *e, const QUAT_T *q);
+
+/* convert euler angles to quaternion, the inverse of to_euler:
+ * q = yaw about z * pitch about y * roll about x
+ */
+QUAT_API void QFN(from_euler)(QUAT_T *q, const EULER_T *e);
+
+/* normalize angle */
+QUAT_API REAL NORMALIZE_EULER(REAL a);
+
+/* Convert quaternion to right handed rotation matrix. m is a pointer
+ * to 16 scalars in column major order.
+ */
+QUAT_API void QFN(to_rh_rot_matrix)(const QUAT_T *q, REAL *m);
+
+/* Convert quaternion to left handed rotation matrix. m is a pointer
+ * to 16 scalars in column major order.
+ */
+QUAT_API void QFN(to_lh_rot_matrix)(const QUAT_T *q, REAL *m);
+
+/* Convert right handed rotation matrix to quaternion, the inverse of
+ * to_rh_rot_matrix. m is a pointer to 16 scalars in column major order,
+ * only the orthonormal rotation part is read. The result has w >= 0.
+ */
+QUAT_API void QFN(from_rh_rot_matrix)(QUAT_T *o, const REAL *m);
+
+/* Convert left handed rotation matrix to quaternion, the inverse of
+ * to_lh_rot_matrix. m is a pointer to 16 scalars in column major order.
+ */
+QUAT_API void QFN(from_lh_rot_matrix)(QUAT_T *o, const REAL *m);
+
+/* initialize vector */
+QUAT_API void VFN(init)(VEC3_T *vo, REAL x, REAL y, REAL z);
+
+/* vo = v1 + v2 */
+QUAT_API VEC3_T *VFN(add)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2);
+
+/* v1 = v1 + v2 */
+QUAT_API VEC3_T *VFN(add_self)(VEC3_T *v1, const VEC3_T *v2);
+
+/* v1 += [x, y, z] */
+QUAT_API VEC3_T *VFN(add_c_self)(VEC3_T *v1, REAL x, REAL y, REAL z);
+
+/* vo = v1 - v2 */
+QUAT_API VEC3_T *VFN(sub)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2);
+
+/* v1 = v1 - v2 */
+QUAT_API VEC3_T *VFN(sub_self)(VEC3_T *v1, const VEC3_T *v2);
+
+/* v1 -= [x, y, z] */
+QUAT_API VEC3_T *VFN(sub_c_self)(VEC3_T *v1, REAL x, REAL y, REAL z);
+
+/* vo = vi * scalar */
+QUAT_API VEC3_T *VFN(mul)(VEC3_T *vo, const VEC3_T *vi, REAL scalar);
+
+/* vi *= scalar */
+QUAT_API VEC3_T *VFN(mul_self)(VEC3_T *vi, REAL scalar);
+
+/* return dot product of v1 and v2 */
+QUAT_API REAL VFN(dot)(const VEC3_T *v1, const VEC3_T *v2);
+
+/* vo = v1 x v2 (cross product) */ 
+QUAT_API VEC3_T *VFN(cross)(VEC3_T *vo, const VEC3_T *v1, const VEC3_T *v2);
+
+/* returns square of the magnitude of v */
+QUAT_API REAL VFN(len2)(const VEC3_T *v);
+
+/* vo = normalized vi */
+QUAT_API VEC3_T *VFN(normalize)(VEC3_T *vo, const VEC3_T *vi);
+
+/* vec3 rotate by axis and angle */
+QUAT_API VEC3_T *VFN(rot_axis)(VEC3_T *vo, VEC3_T *vi, REAL x, REAL y, REAL z, REAL angle);
+
+/* vec3 rotate self by axis and angle */
+QUAT_API VEC3_T *VFN(rot_axis_self)(VEC3_T *vo, REAL x, REAL y, REAL z, REAL angle);
+
+/* return distance between v1 and v2 */
+QUAT_API double VFN(dist)(const VEC3_T *v1, const VEC3_T *v2);
+
+/* return distance between v1 and [x, y, z] */
+QUAT_API double VFN(dist_c)(const VEC3_T *v1, REAL x, REAL y, REAL z);
+
+/* identity quaternion */
+#if !defined(QUAT_INLINE)
+extern const QUAT_T IDENTITY_QUAT;
+#endif
+
+/* see http://gamedev.stackexchange.com/questions/15070/orienting-a-model-to-face-a-target */
+/* Calculate the quaternion to rotate from vector u to vector v, the shortest rotation
+ * through the half vector of u and v, without trigonometry; u and v need not be unit.
+ * If they point in opposite directions (within 1e-6 rad), it is the 180 degrees turn
+ * around the part of up perpendicular to u (up is (0, 1, 0) if NULL), followed by the
+ * small rest to v. The identity if u or v is zero.
+ */
+QUAT_API void QFN(from_u2v)(QUAT_T *q, const VEC3_T *u, const VEC3_T *v, const VEC3_T *up);
+
+/* orientation that turns forward (x) from pos towards target and keeps up (y) as close
+ * to up as possible, so there is no roll (up is (0, 1, 0) if NULL), without
+ * trigonometry; targets along up or at pos keep the roll of the turn from x, which is
+ * around up for targets straight behind as in from_u2v
+ */
+QUAT_API void QFN(look_at)(QUAT_T *q, const VEC3_T *pos, const VEC3_T *target, const VEC3_T *up);
+
+/* quaternion dot product q1 . q2 */
+QUAT_API REAL QFN(dot)(const QUAT_T *q1, const QUAT_T *q2);
+
+/* calculate normalized linear quaternion interpolation */
+QUAT_API QUAT_T *QFN(nlerp)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, REAL t);
+
+/* calculate spherical quaternion interpolation;
+ * the float version uses quat_slerp_fast if the library is built
+ * with -DQUAT_SLERP_FAST
+ */
+QUAT_API QUAT_T *QFN(slerp)(QUAT_T *qo, const QUAT_T *qfrom, const QUAT_T *qto, REAL t);
+
+/* quaternion exponential, exp(w + v) = e^w (cos|v| + sin|v| v / |v|);
+ * the exponential of the pure quaternion (0, a n / 2) is the rotation by
+ * angle a around unit axis n. Small |v| use a Taylor series instead of
+ * sin and cos. qo may be equal to q.
+ */
+QUAT_API void QFN(exp)(QUAT_T *qo, const QUAT_T *q);
+
+/* quaternion logarithm, the inverse of exp for |v| <= pi:
+ * log(q) = ln|q| + atan2(|v|, w) v / |v|; for q = -|q| the vector part
+ * is (pi, 0, 0). q must not be 0. qo may be equal to q.
+ */
+QUAT_API void QFN(log)(QUAT_T *qo, const QUAT_T *q);
+
+/* qo = q^t = exp(t log(q)), for unit q the rotation by t times its angle */
+QUAT_API void QFN(pow)(QUAT_T *qo, const QUAT_T *q, REAL t);
+
+/* integrate angular velocity omega (rad/s, body frame, as the gyro rates
+ * of quat_ahrs) over dt: qo = q exp((0, omega dt / 2)). The result has the
+ * length of q up to rounding, renormalize now and then. qo may be equal to q.
+ */
+QUAT_API void QFN(integrate)(QUAT_T *qo, const QUAT_T *q, const VEC3_T *omega, REAL dt);
+
+/* Apply incremental yaw, pitch and roll relative to the quaternion.
+ * For example, if the quaternion represents an orientation of a ship,
+ * this will apply yaw/pitch/roll *in the ship's local coord system to the
+ * orientation.
+ */
+QUAT_API QUAT_T *QFN(apply_relative_yaw_pitch_roll)(QUAT_T *q,
+                                        double yaw, double pitch, double roll);
+
+/* Apply incremental yaw and pitch relative to the quaternion.
+ * Yaw is applied to world axis so no roll will accumulate */
+QUAT_API QUAT_T *QFN(apply_relative_yaw_pitch)(QUAT_T *q, double yaw, double pitch);
+
+/* decompose a quaternion into a rotation (swing) perpendicular to v1 and a rotation (twist) around v1:
+ * swing is the shortest rotation from v1 to q v1 (w >= 0); swing_twist gives q = swing twist, twist_swing
+ * q = twist swing with the twist around q v1. The twist is the projection of q onto the rotations
+ * around v1, without trigonometry; if swing is exactly pi, the twist is the identity.
+ */
+QUAT_API void QFN(decompose_twist_swing)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *twist, QUAT_T *swing);
+QUAT_API void QFN(decompose_swing_twist)(const QUAT_T *q, const VEC3_T *v1, QUAT_T *swing, QUAT_T *twist);
@@ -0,0 +1,29 @@
+/*
+   quaternion library - end of a quat_tmpl.h / quat_tmpl.c instantiation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#undef REAL
+#undef QUAT_T
+#undef VEC3_T
+#undef EULER_T
+#undef QFN
+#undef VFN
+#undef QUAT_INIT
+#undef NORMALIZE_EULER
+#undef IDENTITY_QUAT
+#undef MATH
+#undef LIT
+#undef SLERP_FAST
@@ -0,0 +1,443 @@
+/*
+   quaternion library - orientation trace files
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "quat_trace.h"
+#include "quat_wire.h"
+
+
+#define TRACE_MAGIC "QUATTRC"
+#define TRACE_BYTE_ORDER 0x01020304u
+#define TRACE_VERSION 1
+#define TRACE_DT_MAX 4294967295.0
+
+
+static uint64_t trace_pad8(uint64_t n)
+{
+   return (n + 7) & ~(uint64_t)7;
+}
+
+
+/* bytes of a block with count samples, and the offset of its codes */
+static uint64_t trace_codes_offset(uint32_t count)
+{
+   return trace_pad8((uint64_t)count * sizeof(uint32_t));
+}
+
+
+static uint64_t trace_block_size(uint32_t format, uint32_t count)
+{
+   return trace_codes_offset(count) + trace_pad8((uint64_t)count * format);
+}
+
+
+static int trace_valid_format(uint32_t format)
+{
+   return format == QUAT_TRACE_WIRE32 || format == QUAT_TRACE_WIRE48
+       || format == QUAT_TRACE_WIRE64 || format == QUAT_TRACE_FLOAT;
+}
+
+
+/*
+ * writer
+ */
+
+QUAT_API int quat_trace_writer_open(quat_trace_writer_t *w, const char *path,
+                                    quat_trace_format_t format, double tick, uint32_t block_max)
+{
+   memset(w, 0, sizeof(*w));
+   if (!trace_valid_format(format) || !(tick > 0.0))
+      return -1;
+   if (block_max == 0)
+      block_max = QUAT_TRACE_BLOCK_SAMPLES;
+   w->h.byte_order = TRACE_BYTE_ORDER;
+   w->h.version = TRACE_VERSION;
+   w->h.format = format;
+   w->h.block_max = block_max;
+   w->h.tick = tick;
+   w->dt = malloc(block_max * sizeof(*w->dt));
+   w->q = malloc(block_max * sizeof(*w->q));
+   w->codes = malloc(trace_pad8((uint64_t)block_max * format));
+   w->f = fopen(path, "wb");
+   /* the magic stays zero until the trace is complete */
+   quat_trace_header_t blank;
+   memset(&blank, 0, sizeof(blank));
+   if (!w->dt || !w->q || !w->codes || !w->f || fwrite(&blank, sizeof(blank), 1, w->f) != 1) {
+      if (w->f)
+         fclose(w->f);
+      free(w->dt);
+      free(w->q);
+      free(w->codes);
+      memset(w, 0, sizeof(*w));
+      return -1;
+   }
+   w->offset = sizeof(blank);
+   return 0;
+}
+
+
+static int trace_flush(quat_trace_writer_t *w)
+{
+   static const unsigned char pad[8] = { 0 };
+   uint32_t n = w->count;
+   uint32_t format = w->h.format;
+   if (n == 0)
+      return 0;
+   if (w->h.n_blocks == w->index_size) {
+      size_t size = w->index_size ? 2 * w->index_size : 64;
+      quat_trace_block_t *index = realloc(w->index, size * sizeof(*index));
+      if (!index)
+         return -1;
+      w->index = index;
+      w->index_size = size;
+   }
+
+   switch (format) {
+   case QUAT_TRACE_WIRE32:
+      quat_wire_encode32_n(w->codes, w->q, n);
+      break;
+   case QUAT_TRACE_WIRE48:
+      quat_wire_encode48_n(w->codes, w->q, n);
+      break;
+   case QUAT_TRACE_WIRE64:
+      quat_wire_encode64_n(w->codes, w->q, n);
+      break;
+   default:
+      memcpy(w->codes, w->q, (size_t)n * sizeof(quat_t));
+      break;
+   }
+   size_t dt_pad = trace_codes_offset(n) - (uint64_t)n * sizeof(uint32_t);
+   size_t codes_pad = trace_pad8((uint64_t)n * format) - (uint64_t)n * format;
+   if (fwrite(w->dt, sizeof(uint32_t), n, w->f) != n
+       || fwrite(pad, 1, dt_pad, w->f) != dt_pad
+       || fwrite(w->codes, format, n, w->f) != n
+       || fwrite(pad, 1, codes_pad, w->f) != codes_pad)
+      return -1;
+
+   quat_trace_block_t *b = &w->index[w->h.n_blocks++];
+   memset(b, 0, sizeof(*b));
+   b->t0 = w->t0;
+   b->offset = w->offset;
+   b->first = w->h.n_samples;
+   b->count = n;
+   w->offset += trace_block_size(format, n);
+   w->h.n_samples += n;
+   w->count = 0;
+   return 0;
+}
+
+
+QUAT_API int quat_trace_writer_append(quat_trace_writer_t *w, double t, const quat_t *q)
+{
+   if (w->error || !isfinite(t) || (w->h.n_samples + w->count > 0 && t < w->t_prev))
+      return -1;
+   double x = w->count ? (t - w->t0) / w->h.tick : 0.0;
+   if (w->count == w->h.block_max || x > TRACE_DT_MAX) {
+      if (trace_flush(w)) {
+         w->error = 1;
+         return -1;
+      }
+      x = 0.0;
+   }
+   if (w->count == 0) {
+      w->t0 = t;
+      if (w->h.n_samples == 0)
+         w->h.t_first = t;
+   }
+   uint32_t dt = (uint32_t)(x + 0.5);
+   w->t_prev = t;
+   w->dt[w->count] = dt;
+   w->q[w->count++] = *q;
+   /* the time the reader will see, not t, so that t_last is exact */
+   w->h.t_last = w->t0 + dt * w->h.tick;
+   return 0;
+}
+
+
+QUAT_API int quat_trace_writer_close(quat_trace_writer_t *w)
+{
+   int err = w->error || trace_flush(w);
+   if (!err) {
+      w->h.index_offset = w->offset;
+      memcpy(w->h.magic, TRACE_MAGIC, sizeof(w->h.magic));
+      err = fwrite(w->index, sizeof(*w->index), w->h.n_blocks, w->f) != w->h.n_blocks
+         || fseek(w->f, 0, SEEK_SET)
+         || fwrite(&w->h, sizeof(w->h), 1, w->f) != 1;
+   }
+   err |= fclose(w->f) != 0;
+   free(w->dt);
+   free(w->q);
+   free(w->codes);
+   free(w->index);
+   memset(w, 0, sizeof(*w));
+   return err ? -1 : 0;
+}
+
+
+/*
+ * reader
+ */
+
+/* checks everything sampling relies on, so that a truncated or
+   foreign file fails here instead of faulting later */
+static int trace_check(const quat_trace_t *tr)
+{
+   const quat_trace_header_t *h = tr->h;
+   if (tr->size < sizeof(*h) || memcmp(h->magic, TRACE_MAGIC, sizeof(h->magic))
+       || h->byte_order != TRACE_BYTE_ORDER || h->version != TRACE_VERSION
+       || !trace_valid_format(h->format) || h->block_max == 0 || !(h->tick > 0.0)
+       || h->n_samples == 0 || h->n_blocks == 0 || h->index_offset % 8
+       || h->index_offset > tr->size
+       || h->n_blocks > (tr->size - h->index_offset) / sizeof(quat_trace_block_t))
+      return -1;
+   uint64_t first = 0, end = sizeof(*h);
+   for (uint64_t i = 0; i < h->n_blocks; i++) {
+      const quat_trace_block_t *b = &tr->index[i];
+      if (b->count == 0 || b->count > h->block_max || b->first != first || b->offset != end
+          || (i > 0 && !(b->t0 >= tr->index[i - 1].t0)))
+         return -1;
+      first += b->count;
+      end += trace_block_size(h->format, b->count);
+      if (end > h->index_offset)
+         return -1;
+   }
+   /* sampling trusts t_first and t_last to bound the index */
+   const quat_trace_block_t *last = &tr->index[h->n_blocks - 1];
+   const uint32_t *dt = (const uint32_t *)(tr->base + last->offset);
+   if (first != h->n_samples || h->t_first != tr->index[0].t0
+       || h->t_last != last->t0 + dt[last->count - 1] * h->tick)
+      return -1;
+   return 0;
+}
+
+
+QUAT_API int quat_trace_open(quat_trace_t *tr, const char *path)
+{
+   struct stat st;
+   memset(tr, 0, sizeof(*tr));
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return -1;
+   if (fstat(fd, &st) || st.st_size < (off_t)sizeof(quat_trace_header_t)) {
+      close(fd);
+      return -1;
+   }
+   void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (base == MAP_FAILED)
+      return -1;
+   tr->base = base;
+   tr->size = (size_t)st.st_size;
+   tr->h = base;
+   tr->index = (const quat_trace_block_t *)(tr->base + tr->h->index_offset);
+   if (trace_check(tr)) {
+      quat_trace_close(tr);
+      return -1;
+   }
+   return 0;
+}
+
+
+QUAT_API void quat_trace_close(quat_trace_t *tr)
+{
+   if (tr->base)
+      munmap((void *)tr->base, tr->size);
+   memset(tr, 0, sizeof(*tr));
+}
+
+
+QUAT_API uint64_t quat_trace_count(const quat_trace_t *tr)
+{
+   return tr->h->n_samples;
+}
+
+
+QUAT_API double quat_trace_t_first(const quat_trace_t *tr)
+{
+   return tr->h->t_first;
+}
+
+
+QUAT_API double quat_trace_t_last(const quat_trace_t *tr)
+{
+   return tr->h->t_last;
+}
+
+
+static const uint32_t *trace_dt(const quat_trace_t *tr, const quat_trace_block_t *b)
+{
+   return (const uint32_t *)(tr->base + b->offset);
+}
+
+
+/* sample j of block b */
+static void trace_decode(const quat_trace_t *tr, const quat_trace_block_t *b, uint32_t j, quat_t *q)
+{
+   const unsigned char *c = tr->base + b->offset + trace_codes_offset(b->count);
+   switch (tr->h->format) {
+   case QUAT_TRACE_WIRE32:
+      quat_wire_decode32(q, ((const quat_wire32_t *)c)[j]);
+      break;
+   case QUAT_TRACE_WIRE48:
+      quat_wire_decode48(q, ((const quat_wire48_t *)c)[j]);
+      break;
+   case QUAT_TRACE_WIRE64:
+      quat_wire_decode64(q, ((const quat_wire64_t *)c)[j]);
+      break;
+   default:
+      *q = ((const quat_t *)c)[j];
+      break;
+   }
+}
+
+
+QUAT_API int quat_trace_get(const quat_trace_t *tr, uint64_t i, double *t, quat_t *q)
+{
+   if (i >= tr->h->n_samples)
+      return -1;
+   /* last block with first <= i */
+   size_t lo = 0, hi = tr->h->n_blocks - 1;
+   while (lo < hi) {
+      size_t mid = (lo + hi + 1) / 2;
+      if (tr->index[mid].first <= i)
+         lo = mid;
+      else
+         hi = mid - 1;
+   }
+   const quat_trace_block_t *b = &tr->index[lo];
+   uint32_t j = (uint32_t)(i - b->first);
+   if (t)
+      *t = b->t0 + trace_dt(tr, b)[j] * tr->h->tick;
+   if (q)
+      trace_decode(tr, b, j, q);
+   return 0;
+}
+
+
+/* index of the last block with t0 <= t, t >= t_first */
+static size_t trace_find_block(quat_trace_t *tr, double t)
+{
+   const quat_trace_block_t *b = tr->index;
+   size_t c = tr->cursor;
+   size_t last = tr->h->n_blocks - 1;
+
+   /* fast path: same or next block as last time */
+   if (t >= b[c].t0) {
+      if (c == last || t < b[c + 1].t0)
+         return c;
+      if (c + 1 == last || t < b[c + 2].t0)
+         return tr->cursor = c + 1;
+   }
+
+   /* branch free binary search, b[base].t0 <= t holds throughout */
+   size_t base = 0, len = last + 1;
+   while (len > 1) {
+      size_t half = len / 2;
+      base = b[base + half].t0 <= t ? base + half : base;
+      len -= half;
+   }
+   return tr->cursor = base;
+}
+
+
+/* last sample j of block bi with dt[j] <= xi, dt[0] = 0 <= xi */
+static uint32_t trace_find_sample(quat_trace_t *tr, size_t bi, const uint32_t *dt,
+                                  uint32_t count, uint32_t xi)
+{
+   uint32_t base = 0, len = count;
+   uint32_t j = tr->sample;
+
+   /* fast path: same or next sample in the same block as last time */
+   if (bi == tr->sample_block && dt[j] <= xi) {
+      if (j + 1 == count || dt[j + 1] > xi)
+         return j;
+      if (j + 2 == count || dt[j + 2] > xi)
+         return tr->sample = j + 1;
+      base = j + 2;
+      len = count - base;
+   }
+
+   /* branch free binary search, dt[base] <= xi holds throughout */
+   while (len > 1) {
+      uint32_t half = len / 2;
+      base = dt[base + half] <= xi ? base + half : base;
+      len -= half;
+   }
+   tr->sample_block = bi;
+   return tr->sample = base;
+}
+
+
+QUAT_API quat_t *quat_trace_sample(quat_trace_t *tr, quat_t *qo, double t, quat_trace_interp_t interp)
+{
+   const quat_trace_header_t *h = tr->h;
+   if (!(t > h->t_first)) {
+      trace_decode(tr, &tr->index[0], 0, qo);
+      return qo;
+   }
+   if (t >= h->t_last) {
+      const quat_trace_block_t *b = &tr->index[h->n_blocks - 1];
+      trace_decode(tr, b, b->count - 1, qo);
+      return qo;
+   }
+
+   size_t bi = trace_find_block(tr, t);
+   const quat_trace_block_t *b = &tr->index[bi];
+   const uint32_t *dt = trace_dt(tr, b);
+   double x = (t - b->t0) / h->tick;
+   uint32_t xi = x < TRACE_DT_MAX ? (uint32_t)x : UINT32_MAX;
+   uint32_t lo = trace_find_sample(tr, bi, dt, b->count, xi);
+   /* t just below t_last can round onto the last sample, which has no
+      successor to interpolate with */
+   if (lo + 1 == b->count && bi == h->n_blocks - 1) {
+      trace_decode(tr, b, lo, qo);
+      return qo;
+   }
+
+   quat_t qa, qb;
+   double ta = b->t0 + dt[lo] * h->tick, tb;
+   trace_decode(tr, b, lo, &qa);
+   if (lo + 1 < b->count) {
+      tb = b->t0 + dt[lo + 1] * h->tick;
+      trace_decode(tr, b, lo + 1, &qb);
+   } else {
+      /* t < t_last, so there is a next block */
+      tb = b[1].t0;
+      trace_decode(tr, &b[1], 0, &qb);
+   }
+
+   float u = tb > ta ? (float)((t - ta) / (tb - ta)) : 1.0f;
+   u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+   if (interp == QUAT_TRACE_NLERP)
+      return quat_nlerp(qo, &qa, &qb, u);
+   return quat_slerp(qo, &qa, &qb, u);
+}
+
+
+QUAT_API void quat_trace_sample_n(quat_trace_t *tr, quat_t *qo, const double *t, size_t n,
+                                  quat_trace_interp_t interp)
+{
+   for (size_t i = 0; i < n; i++)
+      quat_trace_sample(tr, &qo[i], t[i], interp);
+}
@@ -0,0 +1,180 @@
+/*
+   quaternion library - orientation trace file interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_TRACE_H__
+#define __QUAT_TRACE_H__
+
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "quat.h"
+
+
+/* A trace file holds timestamped orientations in blocks of up to
+ * block_max samples:
+ *
+ *    header     quat_trace_header_t
+ *    blocks     uint32_t dt[count], times in ticks after the block start
+ *               time t0, then count orientation codes, each part
+ *               padded to 8 bytes
+ *    index      quat_trace_block_t[n_blocks], sorted by time
+ *
+ * Sample times are t0 + dt * tick; a new block starts when a block is
+ * full or its time offsets would overflow 32 bits. All fields are in
+ * host byte order.
+ */
+
+
+/* orientation encodings, the value is the code size in bytes */
+typedef enum
+{
+   QUAT_TRACE_WIRE32 = 4,    /* quat_wire32_t, max angle error 4.8e-3 rad */
+   QUAT_TRACE_WIRE48 = 6,    /* quat_wire48_t, 1.5e-4 rad */
+   QUAT_TRACE_WIRE64 = 8,    /* quat_wire64_t, 4.7e-6 rad */
+   QUAT_TRACE_FLOAT = 16     /* quat_t, lossless */
+}
+quat_trace_format_t;
+
+
+typedef enum
+{
+   QUAT_TRACE_SLERP,         /* quat_slerp between neighbouring samples */
+   QUAT_TRACE_NLERP          /* quat_nlerp between neighbouring samples */
+}
+quat_trace_interp_t;
+
+
+/* default samples per block */
+#define QUAT_TRACE_BLOCK_SAMPLES 4096
+
+
+typedef struct
+{
+   char magic[8];            /* "QUATTRC", written last */
+   uint32_t byte_order;      /* 0x01020304 */
+   uint32_t version;         /* 1 */
+   uint32_t format;          /* quat_trace_format_t */
+   uint32_t block_max;
+   double tick;              /* time unit of the offsets */
+   uint64_t n_samples;
+   uint64_t n_blocks;
+   uint64_t index_offset;
+   double t_first;
+   double t_last;
+}
+quat_trace_header_t;
+
+
+/* index entry of one block */
+typedef struct
+{
+   double t0;                /* time of the first sample */
+   uint64_t offset;          /* file offset of dt[0] */
+   uint64_t first;           /* number of samples before this block */
+   uint32_t count;
+   uint32_t reserved;
+}
+quat_trace_block_t;
+
+
+/* trace writer, samples are buffered one block at a time */
+typedef struct
+{
+   FILE *f;
+   quat_trace_header_t h;
+   uint64_t offset;          /* end of the last written block */
+   double t_prev;            /* last appended time */
+   double t0;                /* start time of the current block */
+   uint32_t count;           /* samples in the current block */
+   uint32_t *dt;             /* current block, block_max entries each */
+   quat_t *q;
+   void *codes;
+   quat_trace_block_t *index;
+   size_t index_size;
+   int error;
+}
+quat_trace_writer_t;
+
+
+/* memory mapped trace reader; the cursor makes sampling at increasing
+ * times cheap, use one reader (or a copy of it) per thread
+ */
+typedef struct
+{
+   const unsigned char *base;
+   size_t size;
+   const quat_trace_header_t *h;
+   const quat_trace_block_t *index;
+   size_t cursor;            /* block of the last lookup */
+   size_t sample_block;      /* block and sample of the last sample lookup */
+   uint32_t sample;
+}
+quat_trace_t;
+
+
+/* create trace file path with orientation encoding format, time unit
+ * tick (e.g. 1e-6 for microseconds) and block_max samples per block
+ * (0 for QUAT_TRACE_BLOCK_SAMPLES); returns 0 on success, -1 on error
+ */
+QUAT_API int quat_trace_writer_open(quat_trace_writer_t *w, const char *path,
+                                    quat_trace_format_t format, double tick, uint32_t block_max);
+
+/* append unit quaternion q at time t; times must not decrease.
+ * Returns 0 on success, -1 on invalid time or write error.
+ */
+QUAT_API int quat_trace_writer_append(quat_trace_writer_t *w, double t, const quat_t *q);
+
+/* write the last block and the index and close the file; the file is
+ * only readable afterwards. Returns 0 on success, -1 if any write failed.
+ */
+QUAT_API int quat_trace_writer_close(quat_trace_writer_t *w);
+
+
+/* map trace file path read only; returns 0 on success, -1 if the file
+ * cannot be mapped, is not a complete trace or has no samples
+ */
+QUAT_API int quat_trace_open(quat_trace_t *tr, const char *path);
+
+QUAT_API void quat_trace_close(quat_trace_t *tr);
+
+/* number of samples and the time range */
+QUAT_API uint64_t quat_trace_count(const quat_trace_t *tr);
+QUAT_API double quat_trace_t_first(const quat_trace_t *tr);
+QUAT_API double quat_trace_t_last(const quat_trace_t *tr);
+
+/* sample i (decoded) and its time; returns -1 if i is out of range */
+QUAT_API int quat_trace_get(const quat_trace_t *tr, uint64_t i, double *t, quat_t *q);
+
+/* orientation at time t, interpolated between the neighbouring samples;
+ * times outside the trace are clamped. The block is found by binary
+ * search over the index and the sample by binary search within the
+ * block, only the pages touched are read.
+ */
+QUAT_API quat_t *quat_trace_sample(quat_trace_t *tr, quat_t *qo, double t, quat_trace_interp_t interp);
+
+/* sample at n times t[i] into qo[i]; increasing times are fastest */
+QUAT_API void quat_trace_sample_n(quat_trace_t *tr, quat_t *qo, const double *t, size_t n,
+                                  quat_trace_interp_t interp);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_trace.c"
+#endif
+
+
+#endif /* __QUAT_TRACE_H__ */
@@ -0,0 +1,151 @@
+/*
+   quaternion library - keyframe track implementation
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+
+#include "quat_track.h"
+
+
+static void seg_init(quat_seg_t *s, const quat_key_t *k0, const quat_key_t *k1)
+{
+   /* same case analysis as quat_slerp, done once per segment */
+   float cosom = quat_dot(&k0->q, &k1->q);
+   s->t0 = k0->t;
+   s->inv_dt = 1.0f / (k1->t - k0->t);
+   s->from = k0->q;
+   if (cosom < 0.0f) {
+      cosom = -cosom;
+      quat_scale(&s->to, &k1->q, -1.0f);
+   } else {
+      s->to = k1->q;
+   }
+   if (cosom < 0.99995f) {
+      s->omega = acosf(cosom);
+      s->inv_sin = 1.0f / sinf(s->omega);
+   } else {
+      /* keys are very close: linear interpolation */
+      s->omega = 0.0f;
+      s->inv_sin = 0.0f;
+   }
+}
+
+
+QUAT_API int quat_track_init(quat_track_t *tr, quat_seg_t *segs, const quat_key_t *keys, int n)
+{
+   if (n < 1)
+      return -1;
+   for (int i = 0; i < n - 1; i++) {
+      if (!(keys[i + 1].t > keys[i].t))
+         return -1;
+      seg_init(&segs[i], &keys[i], &keys[i + 1]);
+   }
+   /* hold segment for the last key */
+   quat_seg_t *last = &segs[n - 1];
+   last->t0 = keys[n - 1].t;
+   last->inv_dt = 0.0f;
+   last->omega = 0.0f;
+   last->inv_sin = 0.0f;
+   last->from = keys[n - 1].q;
+   last->to = keys[n - 1].q;
+   tr->segs = segs;
+   tr->n = n;
+   tr->cursor = 0;
+   return 0;
+}
+
+
+/* start time of segment i */
+#define SEG_T0(i) (*(const float *)((const char *)segs + (size_t)(i) * size))
+
+QUAT_API int quat_track_find(const void *segs, size_t size, int n, int *cursor, float t)
+{
+   int c = *cursor;
+   int last = n - 1;
+
+   /* fast path: same or next segment as last time */
+   if (t >= SEG_T0(c)) {
+      if (c == last || t < SEG_T0(c + 1))
+         return c;
+      if (c + 1 == last || t < SEG_T0(c + 2))
+         return *cursor = c + 1;
+   }
+   if (t < SEG_T0(0))
+      return *cursor = 0;
+
+   /* binary search for the last segment with t0 <= t */
+   int lo = 0, hi = last;
+   while (lo < hi) {
+      int mid = (lo + hi + 1) / 2;
+      if (SEG_T0(mid) <= t)
+         lo = mid;
+      else
+         hi = mid - 1;
+   }
+   return *cursor = lo;
+}
+
+#undef SEG_T0
+
+
+static inline int track_find(quat_track_t *tr, float t)
+{
+   return quat_track_find(tr->segs, sizeof(quat_seg_t), tr->n, &tr->cursor, t);
+}
+
+
+static void seg_eval(const quat_seg_t *s, quat_t *qo, float t)
+{
+   float u = (t - s->t0) * s->inv_dt;
+   if (u < 0.0f)
+      u = 0.0f;
+   else if (u > 1.0f)
+      u = 1.0f;
+
+   float scale0, scale1;
+   if (s->inv_sin != 0.0f) {
+      scale0 = sinf((1.0f - u) * s->omega) * s->inv_sin;
+      scale1 = sinf(u * s->omega) * s->inv_sin;
+   } else {
+      scale0 = 1.0f - u;
+      scale1 = u;
+   }
+   qo->x = scale0 * s->from.x + scale1 * s->to.x;
+   qo->y = scale0 * s->from.y + scale1 * s->to.y;
+   qo->z = scale0 * s->from.z + scale1 * s->to.z;
+   qo->w = scale0 * s->from.w + scale1 * s->to.w;
+}
+
+
+QUAT_API quat_t *quat_track_eval(quat_track_t *tr, quat_t *qo, float t)
+{
+   seg_eval(&tr->segs[track_find(tr, t)], qo, t);
+   return qo;
+}
+
+
+QUAT_API void quat_track_eval_n(quat_track_t *tr, quat_t *qo, const float *t, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      seg_eval(&tr->segs[track_find(tr, t[i])], &qo[i], t[i]);
+}
+
+
+QUAT_API void quat_track_eval_tracks(quat_track_t *tr, quat_t *qo, float t, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      seg_eval(&tr[i].segs[track_find(&tr[i], t)], &qo[i], t);
+}
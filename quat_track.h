@@ -0,0 +1,90 @@
+/*
+   quaternion library - keyframe track interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_TRACK_H__
+#define __QUAT_TRACK_H__
+
+
+#include "quat.h"
+
+
+/* keyframe: orientation q at time t */
+typedef struct
+{
+   float t;
+   quat_t q;
+}
+quat_key_t;
+
+
+/* precomputed slerp segment between two consecutive keys */
+typedef struct
+{
+   float t0;      /* start time */
+   float inv_dt;  /* 1 / segment duration, 0 for the final hold segment */
+   float omega;   /* angle between from and to */
+   float inv_sin; /* 1 / sin(omega), 0 if the segment is interpolated linearly */
+   quat_t from;
+   quat_t to;     /* sign corrected for the shortest path */
+}
+quat_seg_t;
+
+
+/* keyframe track; segs holds one segment per key, the last one
+ * holds the final key for all times after it.
+ */
+typedef struct
+{
+   quat_seg_t *segs;
+   int n;
+   int cursor;    /* segment of the last evaluation */
+}
+quat_track_t;
+
+
+/* build track from n keys with strictly increasing times into
+ * caller provided storage segs[n]; returns 0 on success, -1 on invalid keys
+ */
+QUAT_API int quat_track_init(quat_track_t *tr, quat_seg_t *segs, const quat_key_t *keys, int n);
+
+/* evaluate track at time t; times outside the key range are clamped.
+ * The track remembers the last segment, so monotonic playback
+ * does not need to search.
+ */
+QUAT_API quat_t *quat_track_eval(quat_track_t *tr, quat_t *qo, float t);
+
+/* evaluate track at n sample times t[i] into qo[i] */
+QUAT_API void quat_track_eval_n(quat_track_t *tr, quat_t *qo, const float *t, size_t n);
+
+/* evaluate n tracks at the same time t into qo[i] */
+QUAT_API void quat_track_eval_tracks(quat_track_t *tr, quat_t *qo, float t, size_t n);
+
+/* index of the segment containing t among n segments of size bytes
+ * whose first member is their float start time, as quat_seg_t and
+ * quat_spline_seg_t: the last one with a start time <= t, 0 before the
+ * first. *cursor is the result of the previous search; the same and the
+ * next segment are tried before searching.
+ */
+QUAT_API int quat_track_find(const void *segs, size_t size, int n, int *cursor, float t);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_track.c"
+#endif
+
+
+#endif /* __QUAT_TRACK_H__ */
@@ -0,0 +1,142 @@
+/*
+   quaternion library - lane-wise elementary functions
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+/*
+ * Included by quat_packet.h once per vector width with:
+ *
+ *    VM_V, VM_VI     float and int vector types
+ *    VM(name)        function name prefix, vfloat4_##name or vfloat8_##name
+ *
+ * Branch free float approximations after the Cephes single precision
+ * functions (S. L. Moshier). Max errors against the exact functions,
+ * measured over their whole input range:
+ *
+ *    sincos(x)      8e-8 absolute for |x| <= 8192
+ *    atan2(y, x)    2.8e-7 rad, about one ulp of pi
+ *    asin(x)        1.7e-7 rad
+ *    exp(x)         2 ulp for |x| <= 87
+ *    log(x)         1e-7 absolute, normal x > 0
+ */
+
+
+/* lane-wise |v| */
+static inline VM_V VM(abs)(VM_V v)
+{
+   return (VM_V)((VM_VI)v & 0x7fffffff);
+}
+
+
+/* lane-wise |a| with the sign of b */
+static inline VM_V VM(copysign)(VM_V a, VM_V b)
+{
+   return (VM_V)(((VM_VI)a & 0x7fffffff) | ((VM_VI)b & ~0x7fffffff));
+}
+
+
+/* s = sin(x), c = cos(x): x is reduced by the multiple k of pi/2 nearest
+   to it (three part pi/2, exact for |k| < 2^16), the quadrant k & 3
+   selects and negates the polynomials for [-pi/4, pi/4] */
+static inline void VM(sincos)(VM_V *s, VM_V *c, VM_V x)
+{
+   /* round to nearest by adding and subtracting 1.5 * 2^23 */
+   VM_V k = (x * 0.636619772f + 12582912.0f) - 12582912.0f;
+   VM_VI ki = __builtin_convertvector(k, VM_VI);
+   VM_V r = ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f;
+   VM_V z = r * r;
+   VM_V ps = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+   VM_V pc = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f)
+             * z * z - 0.5f * z + 1.0f;
+   VM_VI swap = (ki & 1) != 0;
+   VM_VI sign_s = ((ki & 2) != 0) & ~0x7fffffff;
+   VM_VI sign_c = (((ki + 1) & 2) != 0) & ~0x7fffffff;
+   *s = (VM_V)((VM_VI)VM(select)(swap, pc, ps) ^ sign_s);
+   *c = (VM_V)((VM_VI)VM(select)(swap, ps, pc) ^ sign_c);
+}
+
+
+/* atan2(y, x) in [-pi, pi]: atan of min(|x|, |y|) / max(|x|, |y|) in
+   [0, 1], reduced to [-tan(pi/8), tan(pi/8)] via atan(t) = pi/4 +
+   atan((t - 1) / (t + 1)), then mirrored into the octant of (x, y) */
+static inline VM_V VM(atan2)(VM_V y, VM_V x)
+{
+   VM_V ax = VM(abs)(x), ay = VM(abs)(y);
+   VM_VI steep = ay > ax;
+   VM_V hi = VM(select)(steep, ay, ax), lo = VM(select)(steep, ax, ay);
+   VM_V t = VM(select)(hi > 0.0f, lo / hi, (VM_V){ 0.0f });
+   VM_VI red = t > 0.414213562f;
+   VM_V u = VM(select)(red, (t - 1.0f) / (t + 1.0f), t);
+   VM_V z = u * u;
+   VM_V a = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z
+             - 3.33329491539e-1f) * z * u + u;
+   a = VM(select)(red, a + 0.785398163f, a);
+   a = VM(select)(steep, 1.570796327f - a, a);
+   a = VM(select)(x < 0.0f, 3.141592654f - a, a);
+   return VM(copysign)(a, y);
+}
+
+
+/* asin(x) = atan2(x, sqrt((1 - x) (1 + x))), x is clamped to [-1, 1] */
+static inline VM_V VM(asin)(VM_V x)
+{
+   VM_V one = (VM_V){ 0.0f } + 1.0f;
+   x = VM(select)(x > one, one, VM(select)(x < -one, -one, x));
+   return VM(atan2)(x, VM(sqrt)((1.0f - x) * (1.0f + x)));
+}
+
+
+/* e^x: x = k ln 2 + r with |r| <= ln 2 / 2 (two part ln 2), then the
+   polynomial for e^r times 2^k built in the exponent bits; x is clamped
+   to [-87, 88] so that 2^k stays a normal number */
+static inline VM_V VM(exp)(VM_V x)
+{
+   VM_V lo = (VM_V){ 0.0f } - 87.0f, hi = (VM_V){ 0.0f } + 88.0f;
+   x = VM(select)(x > hi, hi, VM(select)(x < lo, lo, x));
+   VM_V k = (x * 1.44269504f + 12582912.0f) - 12582912.0f;
+   VM_V r = (x - k * 0.693359375f) + k * 2.12194440e-4f;
+   VM_V z = r * r;
+   VM_V p = (((((1.9875691500e-4f * r + 1.3981999507e-3f) * r + 8.3334519073e-3f) * r
+               + 4.1665795894e-2f) * r + 1.6666665459e-1f) * r + 5.0000001201e-1f) * z + r + 1.0f;
+   VM_VI e = (__builtin_convertvector(k, VM_VI) + 127) << 23;
+   return p * (VM_V)e;
+}
+
+
+/* ln x for normal x > 0: x = 2^e m with m in [sqrt(1/2), sqrt(2)),
+   ln x = e ln 2 + ln m with a polynomial in m - 1 (two part ln 2) */
+static inline VM_V VM(log)(VM_V x)
+{
+   VM_VI xi = (VM_VI)x;
+   VM_VI e = ((xi >> 23) & 0xff) - 126;
+   VM_V m = (VM_V)((xi & 0x007fffff) | 0x3f000000);
+   VM_VI small = m < 0.707106781f;
+   e = e + small;
+   m = VM(select)(small, m + m, m) - 1.0f;
+   VM_V ef = __builtin_convertvector(e, VM_V);
+   VM_V z = m * m;
+   VM_V y = ((((((((7.0376836292e-2f * m - 1.1514610310e-1f) * m + 1.1676998740e-1f) * m
+                  - 1.2420140846e-1f) * m + 1.4249322787e-1f) * m - 1.6668057665e-1f) * m
+               + 2.0000714765e-1f) * m - 2.4999993993e-1f) * m + 3.3333331174e-1f) * m * z;
+   y = y + ef * -2.12194440e-4f - 0.5f * z;
+   return (m + y) + ef * 0.693359375f;
+}
+
+
+/* angles in [-pi, pi] to [0, 2 pi], branch free */
+static inline VM_V VM(wrap_2pi)(VM_V a)
+{
+   return a + (VM_V)((a < 0.0f) & (VM_VI)((VM_V){ 0.0f } + 6.283185307f));
+}
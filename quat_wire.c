@@ -0,0 +1,353 @@
+/*
+   quaternion library - compact wire formats
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <math.h>
+#include <string.h>
+
+#include "quat_wire.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+/* the three smaller components of a unit quaternion lie in [-S, S] */
+#define WIRE_S 0.707106781f
+
+/* quantization of a component to bits bits: u = (v + S) M / (2 S) + 1/2,
+   rounded down, and back: v = u 2 S / M - S, with M = 2^bits - 1 */
+#define WIRE_MAX(bits) ((1u << (bits)) - 1)
+#define WIRE_ENC_SCALE(bits) ((float)WIRE_MAX(bits) * WIRE_S)
+#define WIRE_ENC_BIAS(bits) ((float)WIRE_MAX(bits) * 0.5f + 0.5f)
+#define WIRE_DEC_STEP(bits) (2.0f * WIRE_S / (float)WIRE_MAX(bits))
+
+
+/* index of the largest component and the other three, in order and
+   negated if the largest one is negative */
+static inline unsigned int wire_smallest3(float *abc, const quat_t *q)
+{
+   unsigned int idx = 0;
+   float best = fabsf(q->vec[0]);
+   for (unsigned int i = 1; i < 4; i++)
+      if (fabsf(q->vec[i]) > best) {
+         best = fabsf(q->vec[i]);
+         idx = i;
+      }
+   int neg = q->vec[idx] < 0.0f;
+   int j = 0;
+   FOR_N(i, 4)
+      if (i != (int)idx)
+         abc[j++] = neg ? -q->vec[i] : q->vec[i];
+   return idx;
+}
+
+
+static inline uint32_t wire_quant(float v, float scale, float bias)
+{
+   v = v < -WIRE_S ? -WIRE_S : (v > WIRE_S ? WIRE_S : v);
+   return (uint32_t)(int)(v * scale + bias);
+}
+
+
+static inline float wire_dequant(uint32_t u, float step)
+{
+   return (float)(int)u * step - WIRE_S;
+}
+
+
+/* rebuild the largest component from the unit length and put it at idx */
+static inline void wire_place(quat_t *q, unsigned int idx, float a, float b, float c)
+{
+   float l = 1.0f - (a * a + b * b + c * c);
+   l = sqrtf(l > 0.0f ? l : 0.0f);
+   switch (idx) {
+   case 0:
+      q->w = l; q->x = a; q->y = b; q->z = c;
+      break;
+   case 1:
+      q->w = a; q->x = l; q->y = b; q->z = c;
+      break;
+   case 2:
+      q->w = a; q->x = b; q->y = l; q->z = c;
+      break;
+   default:
+      q->w = a; q->x = b; q->y = c; q->z = l;
+      break;
+   }
+}
+
+
+QUAT_API quat_wire32_t quat_wire_encode32(const quat_t *q)
+{
+   float v[3];
+   unsigned int idx = wire_smallest3(v, q);
+   return (uint32_t)idx << 30
+        | wire_quant(v[0], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10)) << 20
+        | wire_quant(v[1], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10)) << 10
+        | wire_quant(v[2], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10));
+}
+
+
+QUAT_API void quat_wire_decode32(quat_t *q, quat_wire32_t c)
+{
+   wire_place(q, c >> 30,
+              wire_dequant((c >> 20) & 0x3ff, WIRE_DEC_STEP(10)),
+              wire_dequant((c >> 10) & 0x3ff, WIRE_DEC_STEP(10)),
+              wire_dequant(c & 0x3ff, WIRE_DEC_STEP(10)));
+}
+
+
+QUAT_API quat_wire48_t quat_wire_encode48(const quat_t *q)
+{
+   float v[3];
+   unsigned int idx = wire_smallest3(v, q);
+   quat_wire48_t c;
+   c.v[0] = (uint16_t)(wire_quant(v[0], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15)) | (idx & 1) << 15);
+   c.v[1] = (uint16_t)(wire_quant(v[1], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15)) | (idx >> 1) << 15);
+   c.v[2] = (uint16_t)wire_quant(v[2], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15));
+   return c;
+}
+
+
+QUAT_API void quat_wire_decode48(quat_t *q, quat_wire48_t c)
+{
+   wire_place(q, (c.v[0] >> 15) | (c.v[1] >> 15) << 1,
+              wire_dequant(c.v[0] & 0x7fff, WIRE_DEC_STEP(15)),
+              wire_dequant(c.v[1] & 0x7fff, WIRE_DEC_STEP(15)),
+              wire_dequant(c.v[2] & 0x7fff, WIRE_DEC_STEP(15)));
+}
+
+
+QUAT_API quat_wire64_t quat_wire_encode64(const quat_t *q)
+{
+   float v[3];
+   unsigned int idx = wire_smallest3(v, q);
+   return (uint64_t)idx << 62
+        | (uint64_t)wire_quant(v[0], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20)) << 40
+        | (uint64_t)wire_quant(v[1], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20)) << 20
+        | wire_quant(v[2], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20));
+}
+
+
+QUAT_API void quat_wire_decode64(quat_t *q, quat_wire64_t c)
+{
+   wire_place(q, (unsigned int)(c >> 62),
+              wire_dequant((c >> 40) & 0xfffff, WIRE_DEC_STEP(20)),
+              wire_dequant((c >> 20) & 0xfffff, WIRE_DEC_STEP(20)),
+              wire_dequant(c & 0xfffff, WIRE_DEC_STEP(20)));
+}
+
+
+/*
+ * array versions, one quaternion per lane
+ */
+
+#if defined(__AVX__)
+#define WIRE_LANES 8
+#define WIRE_V vfloat8_t
+#define WIRE_VI vint8_t
+#define WIRE_SQRT vfloat8_sqrt
+#define WIRE_SELECT vfloat8_select
+#define WIRE_QP_T quat8_t
+#define WIRE_QP(op) quat8_##op
+#define WIRE_LANES_INIT(e) { e(0), e(1), e(2), e(3), e(4), e(5), e(6), e(7) }
+typedef unsigned int wire_vu_t __attribute__((vector_size(32)));
+#else
+#define WIRE_LANES 4
+#define WIRE_V vfloat4_t
+#define WIRE_VI vint4_t
+#define WIRE_SQRT vfloat4_sqrt
+#define WIRE_SELECT vfloat4_select
+#define WIRE_QP_T quat4_t
+#define WIRE_QP(op) quat4_##op
+#define WIRE_LANES_INIT(e) { e(0), e(1), e(2), e(3) }
+typedef unsigned int wire_vu_t __attribute__((vector_size(16)));
+#endif
+
+#define WIRE_N(n) ((n) & ~(size_t)(WIRE_LANES - 1))
+
+
+/* wire_smallest3 for WIRE_LANES quaternions */
+static inline wire_vu_t wire_smallest3_v(WIRE_V *abc, const quat_t *q)
+{
+   WIRE_QP_T p;
+   WIRE_QP(load)(&p, q);
+   const WIRE_V c[4] = { p.w, p.x, p.y, p.z };
+   const WIRE_VI abs_mask = (WIRE_VI){ 0 } + 0x7fffffff;
+   WIRE_V best = (WIRE_V)((WIRE_VI)c[0] & abs_mask), large = c[0];
+   WIRE_VI idx = { 0 };
+   for (int i = 1; i < 4; i++) {
+      WIRE_V a = (WIRE_V)((WIRE_VI)c[i] & abs_mask);
+      WIRE_VI m = a > best;
+      best = WIRE_SELECT(m, a, best);
+      large = WIRE_SELECT(m, c[i], large);
+      idx = (idx & ~m) | (m & i);
+   }
+   WIRE_VI sign = (large < 0.0f) & (WIRE_VI)~abs_mask;
+   abc[0] = (WIRE_V)((WIRE_VI)WIRE_SELECT(idx == 0, c[1], c[0]) ^ sign);
+   abc[1] = (WIRE_V)((WIRE_VI)WIRE_SELECT(idx <= 1, c[2], c[1]) ^ sign);
+   abc[2] = (WIRE_V)((WIRE_VI)WIRE_SELECT(idx <= 2, c[3], c[2]) ^ sign);
+   return (wire_vu_t)idx;
+}
+
+
+static inline wire_vu_t wire_quant_v(WIRE_V v, float scale, float bias)
+{
+   WIRE_V s = (WIRE_V){ 0.0f } + WIRE_S;
+   v = WIRE_SELECT(v < -s, -s, v);
+   v = WIRE_SELECT(v > s, s, v);
+   return (wire_vu_t)__builtin_convertvector(v * scale + bias, WIRE_VI);
+}
+
+
+static inline WIRE_V wire_dequant_v(wire_vu_t u, float step)
+{
+   return __builtin_convertvector((WIRE_VI)u, WIRE_V) * step - WIRE_S;
+}
+
+
+/* wire_place for WIRE_LANES quaternions */
+static inline void wire_place_v(quat_t *q, wire_vu_t idx, WIRE_V a, WIRE_V b, WIRE_V c)
+{
+   WIRE_V l = 1.0f - (a * a + b * b + c * c);
+   l = WIRE_SQRT(WIRE_SELECT(l > 0.0f, l, (WIRE_V){ 0.0f }));
+   WIRE_VI i = (WIRE_VI)idx;
+   WIRE_QP_T p;
+   p.w = WIRE_SELECT(i == 0, l, a);
+   p.x = WIRE_SELECT(i == 0, a, WIRE_SELECT(i == 1, l, b));
+   p.y = WIRE_SELECT(i == 2, l, WIRE_SELECT(i == 3, c, b));
+   p.z = WIRE_SELECT(i == 3, l, c);
+   WIRE_QP(store)(q, &p);
+}
+
+
+QUAT_API void quat_wire_encode32_n(quat_wire32_t *c, const quat_t *q, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+      WIRE_V v[3];
+      wire_vu_t u = wire_smallest3_v(v, q + i) << 30
+                  | wire_quant_v(v[0], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10)) << 20
+                  | wire_quant_v(v[1], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10)) << 10
+                  | wire_quant_v(v[2], WIRE_ENC_SCALE(10), WIRE_ENC_BIAS(10));
+      memcpy(c + i, &u, sizeof(u));
+   }
+   for (; i < n; i++)
+      c[i] = quat_wire_encode32(&q[i]);
+}
+
+
+QUAT_API void quat_wire_decode32_n(quat_t *q, const quat_wire32_t *c, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+      wire_vu_t u;
+      memcpy(&u, c + i, sizeof(u));
+      wire_place_v(q + i, u >> 30,
+                   wire_dequant_v((u >> 20) & 0x3ff, WIRE_DEC_STEP(10)),
+                   wire_dequant_v((u >> 10) & 0x3ff, WIRE_DEC_STEP(10)),
+                   wire_dequant_v(u & 0x3ff, WIRE_DEC_STEP(10)));
+   }
+   for (; i < n; i++)
+      quat_wire_decode32(&q[i], c[i]);
+}
+
+
+QUAT_API void quat_wire_encode48_n(quat_wire48_t *c, const quat_t *q, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+      WIRE_V v[3];
+      wire_vu_t idx = wire_smallest3_v(v, q + i);
+      wire_vu_t u0 = wire_quant_v(v[0], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15)) | (idx & 1) << 15;
+      wire_vu_t u1 = wire_quant_v(v[1], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15)) | (idx >> 1) << 15;
+      wire_vu_t u2 = wire_quant_v(v[2], WIRE_ENC_SCALE(15), WIRE_ENC_BIAS(15));
+      FOR_N(l, WIRE_LANES) {
+         c[i + l].v[0] = (uint16_t)u0[l];
+         c[i + l].v[1] = (uint16_t)u1[l];
+         c[i + l].v[2] = (uint16_t)u2[l];
+      }
+   }
+   for (; i < n; i++)
+      c[i] = quat_wire_encode48(&q[i]);
+}
+
+
+QUAT_API void quat_wire_decode48_n(quat_t *q, const quat_wire48_t *c, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+#define WIRE_U0(l) c[i + l].v[0]
+#define WIRE_U1(l) c[i + l].v[1]
+#define WIRE_U2(l) c[i + l].v[2]
+      wire_vu_t u0 = WIRE_LANES_INIT(WIRE_U0);
+      wire_vu_t u1 = WIRE_LANES_INIT(WIRE_U1);
+      wire_vu_t u2 = WIRE_LANES_INIT(WIRE_U2);
+#undef WIRE_U0
+#undef WIRE_U1
+#undef WIRE_U2
+      wire_place_v(q + i, (u0 >> 15) | (u1 >> 15) << 1,
+                   wire_dequant_v(u0 & 0x7fff, WIRE_DEC_STEP(15)),
+                   wire_dequant_v(u1 & 0x7fff, WIRE_DEC_STEP(15)),
+                   wire_dequant_v(u2 & 0x7fff, WIRE_DEC_STEP(15)));
+   }
+   for (; i < n; i++)
+      quat_wire_decode48(&q[i], c[i]);
+}
+
+
+/* the 64 bit codes are handled as 32 bit halves:
+   lo = b << 20 | c, hi = idx << 30 | a << 8 | b >> 12 */
+
+QUAT_API void quat_wire_encode64_n(quat_wire64_t *c, const quat_t *q, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+      WIRE_V v[3];
+      wire_vu_t idx = wire_smallest3_v(v, q + i);
+      wire_vu_t a = wire_quant_v(v[0], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20));
+      wire_vu_t b = wire_quant_v(v[1], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20));
+      wire_vu_t lo = b << 20 | wire_quant_v(v[2], WIRE_ENC_SCALE(20), WIRE_ENC_BIAS(20));
+      wire_vu_t hi = idx << 30 | a << 8 | b >> 12;
+      FOR_N(l, WIRE_LANES)
+         c[i + l] = (uint64_t)hi[l] << 32 | lo[l];
+   }
+   for (; i < n; i++)
+      c[i] = quat_wire_encode64(&q[i]);
+}
+
+
+QUAT_API void quat_wire_decode64_n(quat_t *q, const quat_wire64_t *c, size_t n)
+{
+   size_t i = 0;
+   for (; i < WIRE_N(n); i += WIRE_LANES) {
+#define WIRE_LO(l) (uint32_t)c[i + l]
+#define WIRE_HI(l) (uint32_t)(c[i + l] >> 32)
+      wire_vu_t lo = WIRE_LANES_INIT(WIRE_LO);
+      wire_vu_t hi = WIRE_LANES_INIT(WIRE_HI);
+#undef WIRE_LO
+#undef WIRE_HI
+      wire_place_v(q + i, hi >> 30,
+                   wire_dequant_v((hi >> 8) & 0xfffff, WIRE_DEC_STEP(20)),
+                   wire_dequant_v((hi & 0xff) << 12 | lo >> 20, WIRE_DEC_STEP(20)),
+                   wire_dequant_v(lo & 0xfffff, WIRE_DEC_STEP(20)));
+   }
+   for (; i < n; i++)
+      quat_wire_decode64(&q[i], c[i]);
+}
+
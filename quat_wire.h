@@ -0,0 +1,84 @@
+/*
+   quaternion library - compact wire format interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_WIRE_H__
+#define __QUAT_WIRE_H__
+
+
+#include <stdint.h>
+
+#include "quat.h"
+
+
+/* Smallest three encodings of unit quaternions: the index of the largest
+ * component (2 bits) and the other three components, uniformly quantized
+ * over [-1/sqrt(2), 1/sqrt(2)]. The sign is chosen so that the dropped
+ * component is positive (q and -q are the same rotation); the decoder
+ * recovers it from the unit length.
+ *
+ * The three components are off by at most half a step, S / M with
+ * S = 1/sqrt(2) and M = 2^bits - 1, the rebuilt one by at most sqrt(3)
+ * times their combined error, so the rotation angle error is below
+ * 4 sqrt(3) S / M:
+ *
+ *    format   components   max angle error           mean (quat_accuracy)
+ *    32 bit   3 x 10 bit   4.8e-3 rad (0.27 deg)     1.5e-3 rad
+ *    48 bit   3 x 15 bit   1.5e-4 rad (0.0086 deg)   4.7e-5 rad
+ *    64 bit   3 x 20 bit   4.7e-6 rad (0.00027 deg)  1.5e-6 rad
+ *
+ * quat_accuracy checks the bounds. Inputs must have unit length.
+ * Codes are integers in host byte order, the 48 bit code is three 16 bit
+ * words; byte order conversion is up to the transport.
+ */
+
+typedef uint32_t quat_wire32_t;    /* idx << 30 | a << 20 | b << 10 | c */
+
+typedef struct
+{
+   uint16_t v[3];                  /* a | idx bit 0 << 15, b | idx bit 1 << 15, c */
+}
+quat_wire48_t;
+
+typedef uint64_t quat_wire64_t;    /* idx << 62 | a << 40 | b << 20 | c */
+
+
+/* encode and decode one quaternion */
+QUAT_API quat_wire32_t quat_wire_encode32(const quat_t *q);
+QUAT_API void quat_wire_decode32(quat_t *q, quat_wire32_t c);
+QUAT_API quat_wire48_t quat_wire_encode48(const quat_t *q);
+QUAT_API void quat_wire_decode48(quat_t *q, quat_wire48_t c);
+QUAT_API quat_wire64_t quat_wire_encode64(const quat_t *q);
+QUAT_API void quat_wire_decode64(quat_t *q, quat_wire64_t c);
+
+/* array versions: process n quaternions at full vector width, the
+ * largest component is selected and placed without branches. Results
+ * match the functions above.
+ */
+QUAT_API void quat_wire_encode32_n(quat_wire32_t *c, const quat_t *q, size_t n);
+QUAT_API void quat_wire_decode32_n(quat_t *q, const quat_wire32_t *c, size_t n);
+QUAT_API void quat_wire_encode48_n(quat_wire48_t *c, const quat_t *q, size_t n);
+QUAT_API void quat_wire_decode48_n(quat_t *q, const quat_wire48_t *c, size_t n);
+QUAT_API void quat_wire_encode64_n(quat_wire64_t *c, const quat_t *q, size_t n);
+QUAT_API void quat_wire_decode64_n(quat_t *q, const quat_wire64_t *c, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_wire.c"
+#endif
+
+
+#endif /* __QUAT_WIRE_H__ */
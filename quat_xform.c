@@ -0,0 +1,282 @@
+/*
+   quaternion library - rigid transforms
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#include <string.h>
+
+#include "quat_xform.h"
+#include "quat_packet.h"
+
+#ifndef FOR_N
+#define FOR_N(v, m) for (int v = 0; v < m; ++v)
+#endif /* FOR_N */
+
+
+QUAT_API void quat_xform_init(quat_xform_t *x, const quat_t *q, const vec3_t *t)
+{
+   x->q = *q;
+   x->t = *t;
+}
+
+
+QUAT_API void quat_xform_mul(quat_xform_t *o, const quat_xform_t *a, const quat_xform_t *b)
+{
+   quat_xform_t r;
+   quat_mul(&r.q, &a->q, &b->q);
+   quat_rot_vec(&r.t, &b->t, &a->q);
+   vec3_add(&r.t, &r.t, &a->t);
+   *o = r;
+}
+
+
+QUAT_API void quat_xform_inv(quat_xform_t *o, const quat_xform_t *x)
+{
+   quat_xform_t r;
+   quat_conj(&r.q, &x->q);
+   quat_rot_vec(&r.t, &x->t, &r.q);
+   FOR_N(i, 3)
+      r.t.vec[i] = -r.t.vec[i];
+   *o = r;
+}
+
+
+QUAT_API void quat_xform_apply(vec3_t *vo, const quat_xform_t *x, const vec3_t *p)
+{
+   vec3_t r;
+   quat_rot_vec(&r, p, &x->q);
+   vec3_add(vo, &r, &x->t);
+}
+
+
+QUAT_API void quat_xform_apply_n(vec3_t *vo, const quat_xform_t *x, const vec3_t *p, size_t n)
+{
+   quat_rot_vec_n(vo, p, &x->q, n);
+   for (size_t i = 0; i < n; i++)
+      vec3_add(&vo[i], &vo[i], &x->t);
+}
+
+
+#if defined(__AVX__)
+#define XFORM_LANES 8
+#define XFORM_V vfloat8_t
+#define XFORM_QP_T quat8_t
+#define XFORM_QP(op) quat8_##op
+#define XFORM_V3_T vec3x8_t
+#define XFORM_V3(op) vec3x8_##op
+#else
+#define XFORM_LANES 4
+#define XFORM_V vfloat4_t
+#define XFORM_QP_T quat4_t
+#define XFORM_QP(op) quat4_##op
+#define XFORM_V3_T vec3x4_t
+#define XFORM_V3(op) vec3x4_##op
+#endif
+
+/* runs shorter than this are not split across threads; longer ones
+   are split in chunks of whole lane groups */
+#define XFORM_MIN_SPLIT 2048
+#define XFORM_CHUNK 1024
+
+
+#if defined(__SSE__)
+
+/* 7 floats of 4 transforms into 7 vectors; two overlapping loads per
+   transform, (w, x, y, z) and (z, tx, ty, tz), stay inside the struct */
+static inline void xform_load4(__m128 *r, const quat_xform_t *const *x)
+{
+   __m128 q0 = _mm_loadu_ps(x[0]->q.vec), t0 = _mm_loadu_ps(&x[0]->q.vec[3]);
+   __m128 q1 = _mm_loadu_ps(x[1]->q.vec), t1 = _mm_loadu_ps(&x[1]->q.vec[3]);
+   __m128 q2 = _mm_loadu_ps(x[2]->q.vec), t2 = _mm_loadu_ps(&x[2]->q.vec[3]);
+   __m128 q3 = _mm_loadu_ps(x[3]->q.vec), t3 = _mm_loadu_ps(&x[3]->q.vec[3]);
+   _MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+   _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+   r[0] = q0;
+   r[1] = q1;
+   r[2] = q2;
+   r[3] = q3;
+   r[4] = t1;
+   r[5] = t2;
+   r[6] = t3;
+}
+
+
+/* inverse of xform_load4 for 4 consecutive transforms */
+static inline void xform_store4(quat_xform_t *x, const __m128 *r)
+{
+   __m128 q0 = r[0], q1 = r[1], q2 = r[2], q3 = r[3];
+   __m128 t0 = r[3], t1 = r[4], t2 = r[5], t3 = r[6];
+   _MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+   _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+   _mm_storeu_ps(x[0].q.vec, q0);
+   _mm_storeu_ps(&x[0].q.vec[3], t0);
+   _mm_storeu_ps(x[1].q.vec, q1);
+   _mm_storeu_ps(&x[1].q.vec[3], t1);
+   _mm_storeu_ps(x[2].q.vec, q2);
+   _mm_storeu_ps(&x[2].q.vec[3], t2);
+   _mm_storeu_ps(x[3].q.vec, q3);
+   _mm_storeu_ps(&x[3].q.vec[3], t3);
+}
+
+#endif /* __SSE__ */
+
+
+/* transforms x[0 .. XFORM_LANES - 1] into lanes: q, then t */
+static inline void xform_load(XFORM_QP_T *q, XFORM_V3_T *t, const quat_xform_t *const *x)
+{
+   XFORM_V v[7];
+#if defined(__AVX__)
+   __m128 lo[7], hi[7];
+   xform_load4(lo, x);
+   xform_load4(hi, x + 4);
+   FOR_N(k, 7)
+      v[k] = (XFORM_V)_mm256_set_m128(hi[k], lo[k]);
+#elif defined(__SSE__)
+   __m128 r[7];
+   xform_load4(r, x);
+   FOR_N(k, 7)
+      v[k] = (XFORM_V)r[k];
+#else
+   float g[7][XFORM_LANES];
+   FOR_N(l, XFORM_LANES) {
+      FOR_N(k, 4)
+         g[k][l] = x[l]->q.vec[k];
+      FOR_N(k, 3)
+         g[4 + k][l] = x[l]->t.vec[k];
+   }
+   memcpy(v, g, sizeof(v));
+#endif
+   q->w = v[0];
+   q->x = v[1];
+   q->y = v[2];
+   q->z = v[3];
+   t->x = v[4];
+   t->y = v[5];
+   t->z = v[6];
+}
+
+
+/* lanes into the consecutive transforms x[0 .. XFORM_LANES - 1] */
+static inline void xform_store(quat_xform_t *x, const XFORM_QP_T *q, const XFORM_V3_T *t)
+{
+   XFORM_V v[7] = { q->w, q->x, q->y, q->z, t->x, t->y, t->z };
+#if defined(__AVX__)
+   __m128 lo[7], hi[7];
+   FOR_N(k, 7) {
+      lo[k] = _mm256_castps256_ps128((__m256)v[k]);
+      hi[k] = _mm256_extractf128_ps((__m256)v[k], 1);
+   }
+   xform_store4(x, lo);
+   xform_store4(x + 4, hi);
+#elif defined(__SSE__)
+   __m128 r[7];
+   FOR_N(k, 7)
+      r[k] = (__m128)v[k];
+   xform_store4(x, r);
+#else
+   float g[7][XFORM_LANES];
+   memcpy(g, v, sizeof(g));
+   FOR_N(l, XFORM_LANES) {
+      FOR_N(k, 4)
+         x[l].q.vec[k] = g[k][l];
+      FOR_N(k, 3)
+         x[l].t.vec[k] = g[4 + k][l];
+   }
+#endif
+}
+
+
+/* world[first .. last - 1], all of whose parents are before first */
+static void xform_run(quat_xform_t *world, const quat_xform_t *local, const int *parent,
+                      size_t first, size_t last)
+{
+   size_t i = first;
+   for (; i + XFORM_LANES <= last; i += XFORM_LANES) {
+      const quat_xform_t *p[XFORM_LANES], *c[XFORM_LANES];
+      int roots = 0;
+      FOR_N(l, XFORM_LANES) {
+         /* roots take any parent and are copied below */
+         roots |= parent[i + l] < 0;
+         p[l] = parent[i + l] < 0 ? &local[i + l] : &world[parent[i + l]];
+         c[l] = &local[i + l];
+      }
+      XFORM_QP_T a, b;
+      XFORM_V3_T u, v;
+      xform_load(&a, &u, p);
+      xform_load(&b, &v, c);
+      XFORM_QP(mul)(&b, &a, &b);
+      XFORM_QP(rot_vec)(&v, &v, &a);
+      v.x = v.x + u.x;
+      v.y = v.y + u.y;
+      v.z = v.z + u.z;
+      xform_store(&world[i], &b, &v);
+      if (roots)
+         FOR_N(l, XFORM_LANES)
+            if (parent[i + l] < 0)
+               world[i + l] = local[i + l];
+   }
+   for (; i < last; i++) {
+      if (parent[i] < 0)
+         world[i] = local[i];
+      else
+         quat_xform_mul(&world[i], &world[parent[i]], &local[i]);
+   }
+}
+
+
+/* end of the run starting at first: the nodes whose parents are all before first */
+static size_t xform_run_end(const int *parent, size_t first, size_t n)
+{
+   size_t last = first + 1;
+   while (last < n && parent[last] < (long)first)
+      last++;
+   return last;
+}
+
+
+typedef struct
+{
+   quat_xform_t *world;
+   const quat_xform_t *local;
+   const int *parent;
+   size_t first;         /* start of the run */
+}
+xform_job_t;
+
+
+/* nodes [first, last) of a run, counted from its start */
+static void xform_chunk(void *ctx, size_t first, size_t last)
+{
+   xform_job_t *job = ctx;
+   xform_run(job->world, job->local, job->parent, job->first + first, job->first + last);
+}
+
+
+QUAT_API void quat_xform_hierarchy(quat_pool_t *p, quat_xform_t *world, const quat_xform_t *local,
+                                   const int *parent, size_t n)
+{
+   /* a run only reads nodes before it, so long runs are split on the
+      pool; quat_pool_for returns once the run is done */
+   for (size_t first = 0; first < n; ) {
+      size_t last = xform_run_end(parent, first, n);
+      if (last - first < XFORM_MIN_SPLIT) {
+         xform_run(world, local, parent, first, last);
+      } else {
+         xform_job_t job = { world, local, parent, first };
+         quat_pool_for(p, last - first, XFORM_CHUNK, XFORM_MIN_SPLIT, xform_chunk, &job);
+      }
+      first = last;
+   }
+}
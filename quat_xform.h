@@ -0,0 +1,76 @@
+/*
+   quaternion library - rigid transform interface
+
+   Copyright (C) 2013 Tobias Simon and Stephen M. Cameron
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+*/
+
+
+#ifndef __QUAT_XFORM_H__
+#define __QUAT_XFORM_H__
+
+
+#include "quat.h"
+#include "quat_pool.h"
+
+
+/* rigid transform: rotation by unit quaternion q, then translation by t,
+ * i.e. p -> q p q* + t
+ */
+typedef struct
+{
+   quat_t q;
+   vec3_t t;
+}
+quat_xform_t;
+
+
+/* initialize transform from rotation q and translation t */
+QUAT_API void quat_xform_init(quat_xform_t *x, const quat_t *q, const vec3_t *t);
+
+/* o = a * b, the transform that applies b first and then a;
+ * o may be equal to a or b
+ */
+QUAT_API void quat_xform_mul(quat_xform_t *o, const quat_xform_t *a, const quat_xform_t *b);
+
+/* inverse transform, o may be equal to x */
+QUAT_API void quat_xform_inv(quat_xform_t *o, const quat_xform_t *x);
+
+/* transform point p, vo may be equal to p */
+QUAT_API void quat_xform_apply(vec3_t *vo, const quat_xform_t *x, const vec3_t *p);
+
+/* transform n points p via x into vo; vo may be equal to p.
+ * Results match quat_xform_apply.
+ */
+QUAT_API void quat_xform_apply_n(vec3_t *vo, const quat_xform_t *x, const vec3_t *p, size_t n);
+
+/* local to world pass over a flat hierarchy of n nodes:
+ * world[i] = world[parent[i]] * local[i], or local[i] for roots
+ * (parent[i] < 0). Parents must come before their children,
+ * parent[i] < i.
+ *
+ * Nodes whose parents all precede a run of nodes are computed at full
+ * vector width, so breadth first (level) order vectorizes across
+ * siblings and cousins; depth first order still works, one node at a time.
+ * Large runs are split on pool p (may be NULL); the result does not
+ * depend on the pool and matches quat_xform_mul.
+ */
+QUAT_API void quat_xform_hierarchy(quat_pool_t *p, quat_xform_t *world, const quat_xform_t *local,
+                                   const int *parent, size_t n);
+
+
+#if defined(QUAT_INLINE)
+#include "quat_xform.c"
+#endif
+
+
+#endif /* __QUAT_XFORM_H__ */